@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "../include/background_reclamation.hpp"
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time clear(), rehash() and the destructor of a map with many
+// elements take on the calling thread, with replaced bucket lists destroyed
+// right away and on the background thread.
+
+namespace {
+	struct background_traits: hash_map_traits {
+		typedef background_reclamation reclamation_policy;
+	};
+
+	void report(const std::string &name, double ns) {
+		std::cout << std::left << std::setw(32) << name
+			<< " " << std::fixed << std::setprecision(2)
+			<< ns << " ns/op" << std::endl;
+	}
+
+	template<typename Traits>
+	void run(const std::string &name) {
+		constexpr std::uint64_t num_keys = 1 << 20;
+		constexpr int rounds = 4;
+
+		typedef hash_map<
+			std::uint64_t, std::uint64_t,
+			integer_hash,
+			std::equal_to<std::uint64_t>,
+			std::allocator<std::pair<const std::uint64_t, std::uint64_t>>,
+			Traits
+		> map_type;
+
+		const auto fill = [](map_type &hm) {
+			for(std::uint64_t key=0; key<num_keys; ++key) {
+				hm.insert(std::make_pair(key, key));
+			}
+		};
+		const auto elapsed = [](bench_clock::time_point start) {
+			return static_cast<double>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					bench_clock::now() - start
+				).count()
+			);
+		};
+
+		double clear_ns = 0;
+		double rehash_ns = 0;
+		double destroy_ns = 0;
+		for(int round=0; round<rounds; ++round) {
+			std::unique_ptr<map_type> hm(new map_type(num_keys));
+			fill(*hm);
+
+			auto start = bench_clock::now();
+			hm->clear();
+			clear_ns += elapsed(start);
+
+			fill(*hm);
+			start = bench_clock::now();
+			hm->rehash(num_keys * 2);
+			rehash_ns += elapsed(start);
+
+			start = bench_clock::now();
+			hm.reset();
+			destroy_ns += elapsed(start);
+
+			// let the background thread catch up between rounds
+			while(background_reclamation::backlog().objects) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		report(name + " clear", clear_ns / rounds);
+		report(name + " rehash", rehash_ns / rounds);
+		report(name + " destroy", destroy_ns / rounds);
+	}
+}
+
+int main() {
+	run<hash_map_traits>("immediate");
+	run<background_traits>("background");
+}
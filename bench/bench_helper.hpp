@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock bench_clock;
+
+// collects latency samples and reports their distribution
+struct latency_histogram {
+	void add(bench_clock::duration sample) {
+		samples.push_back(sample);
+	}
+
+	void merge(const latency_histogram &other) {
+		samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+	}
+
+	std::int64_t percentile_ns(double p) {
+		if (samples.empty()) {
+			return 0;
+		}
+		std::sort(samples.begin(), samples.end());
+		const auto index = static_cast<std::size_t>(
+			p * static_cast<double>(samples.size() - 1)
+		);
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			samples[index]
+		).count();
+	}
+
+	void report(const std::string &name) {
+		std::cout << std::left << std::setw(32) << name
+			<< " samples=" << samples.size()
+			<< " p50=" << percentile_ns(0.50) << "ns"
+			<< " p99=" << percentile_ns(0.99) << "ns"
+			<< " p99.9=" << percentile_ns(0.999) << "ns"
+			<< " max=" << percentile_ns(1.0) << "ns" << std::endl;
+	}
+
+	std::vector<bench_clock::duration> samples;
+};
+
+// runs a callable repeatedly and reports the time per iteration
+template<typename F>
+void measure(const std::string &name, std::uint64_t iterations, F &&f) {
+	const auto start = bench_clock::now();
+	for(std::uint64_t i=0; i<iterations; ++i) {
+		f(i);
+	}
+	const auto stop = bench_clock::now();
+	const double ns = static_cast<double>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()
+	);
+	std::cout << std::left << std::setw(32) << name
+		<< " " << std::fixed << std::setprecision(2)
+		<< ns / static_cast<double>(iterations) << " ns/op" << std::endl;
+}
+
+// keeps the compiler from optimizing away a computed value
+template<typename T>
+void do_not_optimize(const T &value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
@@ -0,0 +1,48 @@
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../include/hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time per find() with the different bucket index policies for
+// a table that fits into the cache, so the mapping of hashes to buckets makes
+// up a noticeable part of the lookup.
+
+namespace {
+	template<typename Policy>
+	struct bucket_index_traits: hash_map_traits {
+		typedef Policy bucket_index_policy;
+	};
+
+	template<typename Policy>
+	void run(const std::string &name) {
+		constexpr std::uint64_t num_keys = 4096;
+		constexpr std::uint64_t iterations = 1 << 24;
+
+		hash_map<
+			std::uint64_t, std::uint64_t,
+			std::hash<std::uint64_t>,
+			std::equal_to<std::uint64_t>,
+			std::allocator<std::pair<const std::uint64_t, std::uint64_t>>,
+			bucket_index_traits<Policy>
+		> hm(num_keys);
+		for(std::uint64_t key=0; key<num_keys; ++key) {
+			hm.insert(std::make_pair(key, key));
+		}
+
+		measure(name, iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(i % num_keys));
+		});
+	}
+}
+
+int main() {
+	run<modulo_bucket_index>("modulo_bucket_index");
+	run<mask_bucket_index>("mask_bucket_index");
+	run<fastrange_bucket_index>("fastrange_bucket_index");
+	run<reciprocal_bucket_index>("reciprocal_bucket_index");
+}
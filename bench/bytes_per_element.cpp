@@ -0,0 +1,79 @@
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "../include/hash_map.hpp"
+#include "../include/pool_allocator.hpp"
+#include "bench_helper.hpp"
+
+// Reports the heap memory taken per element of maps from uint64_t to
+// uint64_t with as many buckets as elements, in total and in nodes only, with
+// std::allocator and with
+// pool_allocator, and with and without offline_reorder.
+// All maps are kept alive until the end, so pooled maps can not reuse the
+// nodes of previous maps.
+
+namespace {
+	constexpr std::uint64_t num_keys = 1 << 20;
+
+	struct offline_reorder_traits: hash_map_traits {
+		static constexpr bool offline_reorder = true;
+	};
+
+	std::size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+		const auto info = mallinfo2();
+		return info.uordblks + info.hblkhd;
+#else
+		return 0;
+#endif
+	}
+
+	template<typename Allocator, typename Traits>
+	std::shared_ptr<void> run(const std::string &name) {
+		typedef hash_map<
+			std::uint64_t, std::uint64_t,
+			std::hash<std::uint64_t>,
+			std::equal_to<std::uint64_t>,
+			Allocator,
+			Traits
+		> map_type;
+
+		const std::size_t before = heap_in_use();
+		auto hm = std::make_shared<map_type>(num_keys);
+		const std::size_t empty = heap_in_use();
+		for(std::uint64_t key=0; key<num_keys; ++key) {
+			hm->insert(std::make_pair(key, key));
+		}
+		const std::size_t after = heap_in_use();
+
+		std::cout << std::left << std::setw(32) << name
+			<< " " << std::fixed << std::setprecision(1)
+			<< static_cast<double>(after - before) / num_keys
+			<< " bytes/element ("
+			<< static_cast<double>(after - empty) / num_keys
+			<< " in nodes)" << std::endl;
+		return hm;
+	}
+}
+
+int main() {
+	typedef std::pair<const std::uint64_t, std::uint64_t> value_type;
+
+	const auto a = run<std::allocator<value_type>, hash_map_traits>(
+		"std::allocator");
+	const auto b = run<std::allocator<value_type>, offline_reorder_traits>(
+		"std::allocator offline_reorder");
+	const auto c = run<pool_allocator<value_type>, hash_map_traits>(
+		"pool_allocator");
+	const auto d = run<pool_allocator<value_type>, offline_reorder_traits>(
+		"pool_allocator offline_reorder");
+}
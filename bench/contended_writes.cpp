@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Measures the throughput of writers inserting and erasing uniformly
+// distributed keys, with buckets of their natural size (several of them
+// sharing a cache line) and with every bucket on a cache line of its own.
+
+struct cache_line_traits: hash_map_traits {
+	static constexpr std::size_t bucket_alignment = 64;
+};
+
+template<typename Traits>
+void run(const std::string &name, unsigned num_threads) {
+	constexpr unsigned num_keys = 4096;
+	constexpr unsigned num_buckets = 4096; // mostly empty or single nodes
+	const auto run_time = std::chrono::seconds(2);
+
+	hash_map<
+		unsigned, unsigned,
+		std::hash<unsigned>, std::equal_to<unsigned>,
+		std::allocator<std::pair<const unsigned, unsigned>>,
+		Traits
+	> hm(num_buckets);
+	for(unsigned key=0; key<num_keys; key+=2) {
+		hm.insert(std::make_pair(key, key));
+	}
+
+	std::atomic<bool> stop{false};
+	std::atomic<std::uint64_t> writes{0};
+	std::vector<std::thread> threads;
+
+	for(unsigned t=0; t<num_threads; ++t) {
+		threads.emplace_back([&, t]{
+			std::mt19937 rand(t);
+			std::uniform_int_distribution<unsigned> key_dist(0, num_keys-1);
+			std::uint64_t local_writes = 0;
+			while(!stop) {
+				const unsigned key = key_dist(rand);
+				if (rand() & 1) {
+					hm.erase(key);
+				}
+				else {
+					hm.insert(std::make_pair(key, key));
+				}
+				++local_writes;
+			}
+			writes += local_writes;
+		});
+	}
+
+	std::this_thread::sleep_for(run_time);
+	stop = true;
+	for(auto &thread : threads) {
+		thread.join();
+	}
+
+	std::cout << std::left << std::setw(32) << name << " "
+		<< writes / static_cast<std::uint64_t>(run_time.count())
+		<< " ops/s" << std::endl;
+}
+
+int main() {
+	const unsigned num_threads = std::max(4U, std::thread::hardware_concurrency());
+
+	std::cout << num_threads << " writers (50% erase), uniformly distributed keys"
+		<< std::endl;
+	run<hash_map_traits>("natural bucket alignment", num_threads);
+	run<cache_line_traits>("cache line bucket alignment", num_threads);
+}
@@ -0,0 +1,38 @@
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "../include/direct_hash_map.hpp"
+#include "../include/hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time per find() and insert_or_assign() for keys from a dense
+// range, with hash_map and one bucket per key, and with direct_hash_map.
+
+namespace {
+	template<typename Map>
+	void run(const std::string &name) {
+		constexpr std::uint32_t num_keys = 1 << 16;
+		constexpr std::uint64_t iterations = 1 << 22;
+
+		Map hm(num_keys);
+		for(std::uint32_t key=0; key<num_keys; ++key) {
+			hm.insert(std::make_pair(key, key));
+		}
+
+		measure(name + " find", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(static_cast<std::uint32_t>((i * 40503) % num_keys)));
+		});
+		measure(name + " insert_or_assign", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.insert_or_assign(
+				static_cast<std::uint32_t>((i * 40503) % num_keys),
+				static_cast<std::uint32_t>(i)
+			));
+		});
+	}
+}
+
+int main() {
+	run<hash_map<std::uint32_t, std::uint32_t>>("hash_map");
+	run<direct_hash_map<std::uint32_t, std::uint32_t>>("direct_hash_map");
+}
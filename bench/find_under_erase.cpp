@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Measures the latency of find() while other threads keep erasing and
+// re-inserting elements of the same buckets. Half of all writer operations
+// are erase operations.
+
+int main() {
+	constexpr unsigned num_keys = 4096;
+	constexpr unsigned num_buckets = 64; // long chains: ~64 nodes per bucket
+	const auto run_time = std::chrono::seconds(2);
+	const unsigned num_threads = std::max(4U, std::thread::hardware_concurrency());
+	const unsigned num_writers = num_threads / 2;
+	const unsigned num_readers = num_threads - num_writers;
+
+	hash_map<unsigned, unsigned> hm(num_buckets);
+	for(unsigned key=0; key<num_keys; ++key) {
+		hm.insert(std::make_pair(key, key));
+	}
+
+	std::atomic<bool> stop{false};
+	std::atomic<std::uint64_t> writes{0};
+	std::vector<latency_histogram> reader_latencies(num_readers);
+	std::vector<std::thread> threads;
+
+	for(unsigned w=0; w<num_writers; ++w) {
+		threads.emplace_back([&, w]{
+			std::mt19937 rand(w);
+			std::uniform_int_distribution<unsigned> key_dist(0, num_keys-1);
+			std::uint64_t local_writes = 0;
+			while(!stop) {
+				const unsigned key = key_dist(rand);
+				if (rand() & 1) {
+					hm.erase(key);
+				}
+				else {
+					hm.insert(std::make_pair(key, key));
+				}
+				++local_writes;
+			}
+			writes += local_writes;
+		});
+	}
+
+	for(unsigned r=0; r<num_readers; ++r) {
+		threads.emplace_back([&, r]{
+			std::mt19937 rand(1000+r);
+			std::uniform_int_distribution<unsigned> key_dist(0, num_keys-1);
+			latency_histogram &latencies = reader_latencies[r];
+			while(!stop) {
+				const unsigned key = key_dist(rand);
+				const auto start = bench_clock::now();
+				do_not_optimize(hm.find(key) == hm.end());
+				latencies.add(bench_clock::now() - start);
+			}
+		});
+	}
+
+	std::this_thread::sleep_for(run_time);
+	stop = true;
+	for(auto &thread : threads) {
+		thread.join();
+	}
+
+	latency_histogram all;
+	for(const auto &latencies : reader_latencies) {
+		all.merge(latencies);
+	}
+
+	std::cout << num_readers << " readers, " << num_writers
+		<< " writers (50% erase), " << num_keys << " keys in "
+		<< num_buckets << " buckets" << std::endl;
+	all.report("find() latency");
+	std::cout << "writer throughput: "
+		<< writes / static_cast<std::uint64_t>(run_time.count())
+		<< " ops/s" << std::endl;
+}
@@ -0,0 +1,39 @@
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "../include/fixed_string.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time per find() for short identifiers stored as std::string,
+// which allocates its characters for more than 15 characters, and stored as
+// fixed_string, which keeps them inside the node.
+
+namespace {
+	template<typename Key>
+	void run(const std::string &name) {
+		constexpr std::uint64_t num_keys = 1 << 16;
+		constexpr std::uint64_t iterations = 1 << 22;
+
+		std::vector<Key> keys;
+		for(std::uint64_t i=0; i<num_keys; ++i) {
+			keys.push_back(Key("identifier_" + std::to_string(i * 7919)));
+		}
+
+		hash_map<Key, std::uint64_t> hm(num_keys);
+		for(std::uint64_t i=0; i<num_keys; ++i) {
+			hm[keys[i]] = i;
+		}
+
+		measure(name, iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(keys[(i * 40503) % num_keys]));
+		});
+	}
+}
+
+int main() {
+	run<std::string>("std::string");
+	run<fixed_string<30>>("fixed_string<30>");
+}
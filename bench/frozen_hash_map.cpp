@@ -0,0 +1,38 @@
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "../include/frozen_hash_map.hpp"
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time per find() with a hash_map and with its frozen copy, at a
+// load factor of one.
+
+namespace {
+	constexpr std::uint32_t num_keys = 1 << 18;
+	constexpr std::uint64_t iterations = 1 << 22;
+
+	typedef hash_map<std::uint32_t, std::uint32_t, integer_hash> map_type;
+
+	template<typename Map>
+	void run(const std::string &name, const Map &hm) {
+		measure(name + " find", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(static_cast<std::uint32_t>((i * 40503) % num_keys)));
+		});
+		measure(name + " find miss", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(static_cast<std::uint32_t>(num_keys + i % num_keys)));
+		});
+	}
+}
+
+int main() {
+	map_type hm(num_keys);
+	for(std::uint32_t key=0; key<num_keys; ++key) {
+		hm.insert(std::make_pair(key, key));
+	}
+
+	run("hash_map", hm);
+	run("frozen_hash_map", hm.freeze());
+}
@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "bench_helper.hpp"
+
+// Compares the built in hashers to std::hash: the time to hash integers and
+// strings, and the time per find() for integer keys which are all multiples of
+// the bucket count, which std::hash maps to a single bucket.
+// Also compares hashing and finding keys one by one to the batch interfaces.
+
+namespace {
+	constexpr std::uint64_t iterations = 1 << 24;
+
+	template<typename Hash>
+	void run_integers(const std::string &name) {
+		const Hash hash{};
+		measure(name + " u64", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hash(i));
+		});
+	}
+
+	template<typename Hash>
+	void run_strings(const std::string &name, std::size_t length) {
+		const Hash hash{};
+		const std::string key(length, 'x');
+		measure(
+			name + " string[" + std::to_string(length) + "]", iterations,
+			[&](std::uint64_t) {
+				do_not_optimize(key);
+				do_not_optimize(hash(key));
+			}
+		);
+	}
+
+	template<typename Hash>
+	void run_find(const std::string &name) {
+		constexpr std::uint64_t num_buckets = 1024;
+		constexpr std::uint64_t num_keys = 1024;
+
+		hash_map<std::uint64_t, std::uint64_t, Hash> hm(num_buckets);
+		for(std::uint64_t key=0; key<num_keys; ++key) {
+			hm.insert(std::make_pair(key * num_buckets, key));
+		}
+
+		measure(name + " find", iterations / 64, [&](std::uint64_t i) {
+			do_not_optimize(hm.find((i % num_keys) * num_buckets));
+		});
+	}
+
+	void run_batch() {
+		constexpr std::uint64_t batch = 1024;
+		const integer_hash hash{};
+		std::vector<std::uint64_t> keys(batch);
+		std::vector<std::size_t> hashes(batch);
+		for(std::uint64_t i=0; i<batch; ++i) {
+			keys[i] = i * i;
+		}
+
+		measure("integer_hash u64 batch of 1024", iterations / batch, [&](std::uint64_t) {
+			hash.hash_batch(keys.data(), batch, hashes.data());
+			do_not_optimize(hashes);
+		});
+	}
+
+	void run_find_bulk() {
+		// large enough to not fit into the cache
+		constexpr std::uint64_t num_keys = 1 << 22;
+		constexpr std::uint64_t batch = 1024;
+
+		hash_map<std::uint64_t, std::uint64_t, integer_hash> hm(num_keys);
+		std::vector<std::uint64_t> keys(num_keys);
+		for(std::uint64_t key=0; key<num_keys; ++key) {
+			keys[key] = key;
+		}
+		hm.insert_bulk(keys.data(), keys.data(), num_keys);
+
+		// probe in a random order
+		std::vector<std::uint64_t> probes(batch);
+		std::vector<decltype(hm)::iterator> results(batch);
+		const integer_hash scramble(1);
+
+		measure("find", iterations / 16, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(scramble(i) % num_keys));
+		});
+		measure("find_bulk batch of 1024", iterations / 16 / batch, [&](std::uint64_t i) {
+			for(std::uint64_t n=0; n<batch; ++n) {
+				probes[n] = scramble(i * batch + n) % num_keys;
+			}
+			hm.find_bulk(probes.data(), batch, results.data());
+			do_not_optimize(results);
+		});
+	}
+}
+
+int main() {
+	run_integers<std::hash<std::uint64_t>>("std::hash");
+	run_integers<integer_hash>("integer_hash");
+	run_integers<crc32c_hash>("crc32c_hash");
+
+	for(const std::size_t length : {8u, 32u, 256u}) {
+		run_strings<std::hash<std::string>>("std::hash", length);
+		run_strings<bytes_hash>("bytes_hash", length);
+		run_strings<crc32c_hash>("crc32c_hash", length);
+	}
+
+	run_find<std::hash<std::uint64_t>>("std::hash");
+	run_find<integer_hash>("integer_hash");
+	run_find<crc32c_hash>("crc32c_hash");
+
+	run_batch();
+	run_find_bulk();
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time a single clear() of a map with many elements takes, with
+// the elements destroyed by clear() and destroyed by the following
+// insertions, and the time per insertion right after clearing.
+
+namespace {
+	struct incremental_clear_traits: hash_map_traits {
+		static constexpr bool incremental_clear = true;
+		static constexpr bool lazy_buckets = true;
+	};
+
+	template<typename Traits>
+	void run(const std::string &name) {
+		constexpr std::uint64_t num_keys = 1 << 20;
+		constexpr int rounds = 8;
+
+		typedef hash_map<
+			std::uint64_t, std::uint64_t,
+			integer_hash,
+			std::equal_to<std::uint64_t>,
+			std::allocator<std::pair<const std::uint64_t, std::uint64_t>>,
+			Traits
+		> map_type;
+
+		map_type hm(num_keys);
+		double clear_ns = 0;
+		double insert_ns = 0;
+		for(int round=0; round<rounds; ++round) {
+			for(std::uint64_t key=0; key<num_keys; ++key) {
+				hm.insert(std::make_pair(key, key));
+			}
+
+			const auto start = bench_clock::now();
+			hm.clear();
+			const auto cleared = bench_clock::now();
+			for(std::uint64_t key=0; key<num_keys / 16; ++key) {
+				hm.insert(std::make_pair(key, key));
+			}
+			const auto stop = bench_clock::now();
+
+			clear_ns += static_cast<double>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					cleared - start
+				).count()
+			);
+			insert_ns += static_cast<double>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					stop - cleared
+				).count()
+			);
+		}
+
+		std::cout << std::left << std::setw(32) << (name + " clear")
+			<< " " << std::fixed << std::setprecision(2)
+			<< clear_ns / rounds << " ns/op" << std::endl;
+		std::cout << std::left << std::setw(32) << (name + " insert after")
+			<< " " << std::fixed << std::setprecision(2)
+			<< insert_ns / rounds / (num_keys / 16) << " ns/op" << std::endl;
+	}
+}
+
+int main() {
+	run<hash_map_traits>("eager");
+	run<incremental_clear_traits>("incremental");
+}
@@ -0,0 +1,37 @@
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "../include/insert_only_hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time per insert() into an empty map and per find() afterwards,
+// with hash_map and with insert_only_hash_map at a load factor of one.
+
+namespace {
+	template<typename Map>
+	void run(const std::string &name) {
+		constexpr std::uint32_t num_keys = 1 << 18;
+		constexpr std::uint64_t iterations = 1 << 22;
+
+		Map hm(num_keys, integer_hash());
+		measure(name + " insert", num_keys, [&](std::uint64_t i) {
+			const auto key = static_cast<std::uint32_t>(i);
+			do_not_optimize(hm.insert(std::make_pair(key, key)));
+		});
+		measure(name + " find", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(static_cast<std::uint32_t>((i * 40503) % num_keys)));
+		});
+		measure(name + " find miss", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(static_cast<std::uint32_t>(num_keys + i % num_keys)));
+		});
+	}
+}
+
+int main() {
+	run<hash_map<std::uint32_t, std::uint32_t, integer_hash>>("hash_map");
+	run<insert_only_hash_map<std::uint32_t, std::uint32_t, integer_hash>>(
+		"insert_only_hash_map");
+}
@@ -0,0 +1,54 @@
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time to create a map with a large number of buckets, insert a
+// few elements and destroy it again, with eagerly and lazily constructed
+// buckets, and the time per find() once all buckets are in use.
+
+namespace {
+	struct lazy_buckets_traits: hash_map_traits {
+		static constexpr bool lazy_buckets = true;
+	};
+
+	template<typename Traits>
+	void run(const std::string &name) {
+		constexpr std::uint64_t num_buckets = 1 << 22;
+		constexpr std::uint64_t num_keys = 1 << 20;
+
+		typedef hash_map<
+			std::uint64_t, std::uint64_t,
+			integer_hash,
+			std::equal_to<std::uint64_t>,
+			std::allocator<std::pair<const std::uint64_t, std::uint64_t>>,
+			Traits
+		> map_type;
+
+		measure(name + " create/destroy", 32, [&](std::uint64_t i) {
+			map_type hm(num_buckets);
+			for(std::uint64_t key=0; key<16; ++key) {
+				hm.insert(std::make_pair(key * 65537, i));
+			}
+			do_not_optimize(hm.size());
+		});
+
+		map_type hm(num_keys);
+		for(std::uint64_t key=0; key<num_keys; ++key) {
+			hm.insert(std::make_pair(key, key));
+		}
+		measure(name + " find", 1 << 22, [&](std::uint64_t i) {
+			do_not_optimize(hm.find((i * 40503) % num_keys));
+		});
+	}
+}
+
+int main() {
+	run<hash_map_traits>("eager buckets");
+	run<lazy_buckets_traits>("lazy buckets");
+}
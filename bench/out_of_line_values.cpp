@@ -0,0 +1,54 @@
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time per find() on a map with large mapped values and long
+// buckets, with values stored inside the nodes and stored out of line, for
+// keys which exist and keys which do not.
+
+namespace {
+	typedef std::array<std::uint64_t, 48> large_value;
+
+	struct out_of_line_values_traits: hash_map_traits {
+		static constexpr bool out_of_line_values = true;
+	};
+
+	template<typename Traits>
+	void run(const std::string &name) {
+		constexpr std::uint64_t num_keys = 1 << 18;
+		constexpr std::uint64_t iterations = 1 << 22;
+
+		typedef hash_map<
+			std::uint64_t, large_value,
+			integer_hash,
+			std::equal_to<std::uint64_t>,
+			std::allocator<std::pair<const std::uint64_t, large_value>>,
+			Traits
+		> map_type;
+
+		// four elements per bucket
+		map_type hm(num_keys / 4);
+		for(std::uint64_t key=0; key<num_keys; ++key) {
+			hm[key][0] = key;
+		}
+
+		measure(name + " hit", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find((i * 40503) % num_keys));
+		});
+		measure(name + " miss", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find((i * 40503) % num_keys + num_keys));
+		});
+	}
+}
+
+int main() {
+	run<hash_map_traits>("inline values");
+	run<out_of_line_values_traits>("out of line values");
+}
@@ -0,0 +1,42 @@
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "../include/packed_hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time per find() and insert_or_assign() for maps from uint32_t
+// to uint32_t, with hash_map and with packed_hash_map at a load factor of one
+// half.
+
+namespace {
+	template<typename Map>
+	void run(const std::string &name) {
+		constexpr std::uint32_t num_keys = 1 << 18;
+		constexpr std::uint64_t iterations = 1 << 22;
+
+		Map hm(num_keys * 2, integer_hash());
+		for(std::uint32_t key=0; key<num_keys; ++key) {
+			hm.insert(std::make_pair(key, key));
+		}
+
+		measure(name + " find", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(static_cast<std::uint32_t>((i * 40503) % num_keys)));
+		});
+		measure(name + " insert_or_assign", iterations, [&](std::uint64_t i) {
+			do_not_optimize(hm.insert_or_assign(
+				static_cast<std::uint32_t>((i * 40503) % num_keys),
+				static_cast<std::uint32_t>(i)
+			));
+		});
+	}
+}
+
+int main() {
+	run<hash_map<std::uint32_t, std::uint32_t, integer_hash>>("hash_map");
+	run<packed_hash_map<std::uint32_t, std::uint32_t, integer_hash>>(
+		"packed_hash_map");
+}
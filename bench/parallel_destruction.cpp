@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "../include/background_reclamation.hpp"
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time the destructor of a map with many elements takes on the
+// calling thread, destroying the buckets on a single thread, on four threads,
+// and on four threads in the background.
+
+namespace {
+	struct parallel_traits: hash_map_traits {
+		static constexpr unsigned destruction_threads = 4;
+	};
+
+	struct detached_traits: parallel_traits {
+		typedef background_reclamation reclamation_policy;
+	};
+
+	template<typename Traits>
+	void run(const std::string &name) {
+		constexpr std::uint64_t num_keys = 1 << 21;
+		constexpr int rounds = 4;
+
+		typedef hash_map<
+			std::uint64_t, std::uint64_t,
+			integer_hash,
+			std::equal_to<std::uint64_t>,
+			std::allocator<std::pair<const std::uint64_t, std::uint64_t>>,
+			Traits
+		> map_type;
+
+		double ns = 0;
+		for(int round=0; round<rounds; ++round) {
+			std::unique_ptr<map_type> hm(new map_type(num_keys));
+			for(std::uint64_t key=0; key<num_keys; ++key) {
+				hm->insert(std::make_pair(key, key));
+			}
+
+			const auto start = bench_clock::now();
+			hm.reset();
+			ns += static_cast<double>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					bench_clock::now() - start
+				).count()
+			);
+
+			// let the background thread catch up between rounds
+			while(background_reclamation::backlog().objects) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		std::cout << std::left << std::setw(32) << name
+			<< " " << std::fixed << std::setprecision(2)
+			<< ns / rounds << " ns/op" << std::endl;
+	}
+}
+
+int main() {
+	std::cout << std::thread::hardware_concurrency()
+		<< " hardware threads" << std::endl;
+	run<hash_map_traits>("1 thread");
+	run<parallel_traits>("4 threads");
+	run<detached_traits>("4 threads, detached");
+}
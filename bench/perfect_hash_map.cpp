@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "../include/hash_map.hpp"
+#include "../include/perfect_hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time per find() on a table of HTTP method names, with a
+// hash_map filled at startup and with a perfect_hash_map built at compile time.
+
+namespace {
+	constexpr auto methods = make_perfect_hash_map<const char *, int>({
+		{"GET", 1}, {"HEAD", 2}, {"POST", 3}, {"PUT", 4},
+		{"DELETE", 5}, {"CONNECT", 6}, {"OPTIONS", 7}, {"TRACE", 8},
+	});
+
+	const char *const queries[] = {
+		"GET", "POST", "PATCH", "HEAD", "PUT", "TRACE", "GETS", "DELETE",
+	};
+	constexpr std::uint64_t num_queries = sizeof(queries) / sizeof(*queries);
+
+	struct c_string_hash {
+		std::size_t operator()(const char *key) const noexcept {
+			return static_cast<std::size_t>(perfect_hash()(key));
+		}
+	};
+
+	struct c_string_equal {
+		bool operator()(const char *a, const char *b) const noexcept {
+			return std::strcmp(a, b) == 0;
+		}
+	};
+}
+
+int main() {
+	constexpr std::uint64_t iterations = 1 << 22;
+
+	hash_map<const char *, int, c_string_hash, c_string_equal> hm(16);
+	for(const auto &element: methods) {
+		hm.insert(std::make_pair(element.first, element.second));
+	}
+
+	measure("hash_map find", iterations, [&](std::uint64_t i) {
+		do_not_optimize(hm.find(queries[i % num_queries]));
+	});
+	measure("perfect_hash_map find", iterations, [&](std::uint64_t i) {
+		do_not_optimize(methods.find(queries[i % num_queries]));
+	});
+}
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Compares growing the bucket list, a full-table scan and destroying all
+// elements with and without prefetching. The buckets are scrambled by
+// previous rehashes, so the order of the nodes is unrelated to their order in
+// memory.
+
+namespace {
+	struct no_prefetch_traits: hash_map_traits {
+		static constexpr unsigned prefetch_distance = 0;
+	};
+
+	template<typename Traits>
+	using map_type = hash_map<
+		std::uint64_t, std::uint64_t,
+		std::hash<std::uint64_t>,
+		std::equal_to<std::uint64_t>,
+		std::allocator<std::pair<const std::uint64_t, std::uint64_t>>,
+		Traits
+	>;
+
+	double elapsed_ms(bench_clock::time_point start) {
+		return static_cast<double>(
+			std::chrono::duration_cast<std::chrono::microseconds>(
+				bench_clock::now() - start
+			).count()
+		) / 1000.0;
+	}
+
+	template<typename Traits>
+	void run(const std::string &name, const std::vector<std::uint64_t> &keys) {
+		constexpr std::size_t long_chains = 256;
+
+		map_type<Traits> hm(keys.size());
+		for(const auto key : keys) {
+			hm.insert(std::make_pair(key, key));
+		}
+		hm.rehash(long_chains); // scrambles the node order
+		hm.rehash(keys.size() / 2 + 1);
+
+		auto start = bench_clock::now();
+		hm.rehash(keys.size() + 1);
+		const double rehash_ms = elapsed_ms(start);
+
+		start = bench_clock::now();
+		std::uint64_t sum = 0;
+		for(const auto &element : hm) {
+			sum += element.second;
+		}
+		do_not_optimize(sum);
+		const double scan_ms = elapsed_ms(start);
+
+		start = bench_clock::now();
+		hm.clear();
+		const double clear_ms = elapsed_ms(start);
+
+		std::cout << std::left << std::setw(16) << name
+			<< std::fixed << std::setprecision(2)
+			<< " rehash=" << rehash_ms << "ms"
+			<< " scan=" << scan_ms << "ms"
+			<< " clear=" << clear_ms << "ms" << std::endl;
+	}
+}
+
+int main() {
+	constexpr std::size_t num_keys = 1 << 22; // exceeds typical caches
+
+	std::vector<std::uint64_t> keys(num_keys);
+	std::iota(keys.begin(), keys.end(), std::uint64_t(0));
+	std::shuffle(keys.begin(), keys.end(), std::mt19937_64(42));
+
+	std::cout << num_keys << " elements" << std::endl;
+	run<no_prefetch_traits>("no prefetching", keys);
+	run<hash_map_traits>("prefetching", keys);
+}
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Compares the average number of hops per find() for a Zipf distributed
+// workload (s = 1.1) before and after a hash_map with offline_reorder has been
+// reorganized.
+
+namespace {
+	struct offline_reorder_traits: hash_map_traits {
+		static constexpr bool offline_reorder = true;
+	};
+
+	typedef hash_map<
+		std::uint64_t, std::uint64_t,
+		std::hash<std::uint64_t>,
+		std::equal_to<std::uint64_t>,
+		std::allocator<std::pair<const std::uint64_t, std::uint64_t>>,
+		offline_reorder_traits
+	> offline_reorder_map;
+
+	// position of a key in its bucket; 1 for the first node
+	template<typename HashMap>
+	double average_hops(const HashMap &hm, const std::vector<std::uint64_t> &lookups) {
+		std::uint64_t hops = 0;
+		for(const auto key : lookups) {
+			const auto bucket = hm.bucket(key);
+			auto it = hm.cbegin(bucket);
+			++hops;
+			while(it->first != key) {
+				++it;
+				++hops;
+			}
+		}
+		return static_cast<double>(hops) / static_cast<double>(lookups.size());
+	}
+}
+
+int main() {
+	constexpr std::size_t num_keys = 100'000;
+	constexpr std::size_t num_buckets = 5'000; // 20 nodes per bucket
+	constexpr std::size_t num_lookups = 2'000'000;
+	constexpr double s = 1.1;
+
+	std::mt19937_64 rand(42);
+
+	// rank r is accessed with a probability proportional to 1/r^s
+	std::vector<double> weights(num_keys);
+	for(std::size_t r=0; r<num_keys; ++r) {
+		weights[r] = 1.0 / std::pow(static_cast<double>(r+1), s);
+	}
+	std::discrete_distribution<std::size_t> zipf(weights.begin(), weights.end());
+
+	// keys of all ranks, inserted in random order
+	std::vector<std::uint64_t> keys(num_keys);
+	std::iota(keys.begin(), keys.end(), 0);
+	std::shuffle(keys.begin(), keys.end(), rand);
+	std::vector<std::uint64_t> insertion_order(keys);
+	std::shuffle(insertion_order.begin(), insertion_order.end(), rand);
+
+	std::vector<std::uint64_t> lookups(num_lookups);
+	for(auto &key : lookups) {
+		key = keys[zipf(rand)];
+	}
+
+	hash_map<std::uint64_t, std::uint64_t> plain(num_buckets);
+	offline_reorder_map adjusting(num_buckets);
+	for(const auto key : insertion_order) {
+		plain.insert(std::make_pair(key, key));
+		adjusting.insert(std::make_pair(key, key));
+	}
+
+	measure("find() plain", num_lookups, [&](std::uint64_t i) {
+		do_not_optimize(plain.find(lookups[i]));
+	});
+	measure("find() offline_reorder, training", num_lookups, [&](std::uint64_t i) {
+		do_not_optimize(adjusting.find(lookups[i]));
+	});
+	adjusting.reorganize();
+	measure("find() offline_reorder, reorganized", num_lookups, [&](std::uint64_t i) {
+		do_not_optimize(adjusting.find(lookups[i]));
+	});
+
+	std::cout << "average hops plain:          " << average_hops(plain, lookups) << std::endl;
+	std::cout << "average hops offline_reorder: " << average_hops(adjusting, lookups) << std::endl;
+}
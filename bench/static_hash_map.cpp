@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "../include/static_hash_map.hpp"
+#include "bench_helper.hpp"
+
+// Compares the time to create a small map, insert and find eight elements and
+// destroy it again, with hash_map and with static_hash_map. Then measures the
+// throughput of writers which erase and insert their own keys in a shared map,
+// so nodes are released and allocated again concurrently, and the time the
+// arena of a static_hash_map takes to hand out and take back eight blocks.
+//
+// The arena is measured after threads have been started, as the C library may
+// skip the atomic operations of a mutex in a process with a single thread.
+
+namespace {
+	constexpr int num_keys = 8;
+
+	template<typename Map, typename Create>
+	void run(const std::string &name, Create create) {
+		constexpr std::uint64_t iterations = 1 << 18;
+
+		measure(name, iterations, [&](std::uint64_t i) {
+			Map hm = create();
+			for(int key=0; key<num_keys; ++key) {
+				hm.insert(std::make_pair(key, static_cast<int>(i)));
+			}
+			for(int key=0; key<num_keys; ++key) {
+				do_not_optimize(hm.find(key));
+			}
+		});
+	}
+
+	constexpr int churn_keys_per_thread = 64;
+	constexpr int churn_max_threads = 8;
+	constexpr int churn_capacity = churn_keys_per_thread * churn_max_threads;
+
+	template<typename Map>
+	void run_churn(const std::string &name, Map &hm, unsigned num_threads) {
+		const auto run_time = std::chrono::seconds(2);
+
+		std::atomic<bool> stop{false};
+		std::atomic<std::uint64_t> writes{0};
+		std::vector<std::thread> threads;
+
+		for(unsigned t=0; t<num_threads; ++t) {
+			threads.emplace_back([&, t]{
+				const int first = static_cast<int>(t) * churn_keys_per_thread;
+				std::uint64_t local_writes = 0;
+				for(int key=first; key<first+churn_keys_per_thread; ++key) {
+					hm.insert(std::make_pair(key, key));
+				}
+				while(!stop) {
+					for(int key=first; key<first+churn_keys_per_thread; ++key) {
+						hm.erase(key);
+						hm.insert(std::make_pair(key, key));
+					}
+					local_writes += 2 * churn_keys_per_thread;
+				}
+				writes += local_writes;
+			});
+		}
+
+		std::this_thread::sleep_for(run_time);
+		stop = true;
+		for(auto &thread : threads) {
+			thread.join();
+		}
+
+		std::cout << std::left << std::setw(32) << name << " "
+			<< writes / static_cast<std::uint64_t>(run_time.count())
+			<< " ops/s" << std::endl;
+	}
+}
+
+int main() {
+	run<hash_map<int, int>>("hash_map", [] {
+		return hash_map<int, int>(13);
+	});
+	run<static_hash_map<int, int, 13, num_keys>>("static_hash_map", [] {
+		return static_hash_map<int, int, 13, num_keys>();
+	});
+
+	const unsigned num_threads = std::min<unsigned>(churn_max_threads,
+		std::max(4U, std::thread::hardware_concurrency()));
+	std::cout << num_threads << " writers erasing and inserting their own keys"
+		<< std::endl;
+	{
+		hash_map<int, int> hm(churn_capacity);
+		run_churn("hash_map churn", hm, num_threads);
+	}
+	{
+		const std::unique_ptr<static_hash_map<int, int, churn_capacity, churn_capacity>>
+			hm(new static_hash_map<int, int, churn_capacity, churn_capacity>());
+		run_churn("static_hash_map churn", *hm, num_threads);
+	}
+
+	alignas(std::max_align_t) static unsigned char storage[1 << 16];
+	static_arena arena(storage, sizeof(storage));
+	void *blocks[num_keys];
+	measure("static_arena", 1 << 22, [&](std::uint64_t) {
+		for(void *&block: blocks) {
+			block = arena.allocate(48, alignof(std::max_align_t));
+		}
+		for(void *block: blocks) {
+			arena.deallocate(block, 48);
+		}
+		do_not_optimize(blocks[0]);
+	});
+}
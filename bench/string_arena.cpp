@@ -0,0 +1,46 @@
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "../include/string_arena.hpp"
+#include "bench_helper.hpp"
+
+// Compares keys stored as std::string, which allocates the characters of each
+// key on its own, to keys stored in the arena of an arena_hash_map, for
+// inserting and finding many keys which do not fit into the cache.
+
+namespace {
+	constexpr std::uint64_t num_keys = 1 << 20;
+
+	std::string make_key(std::uint64_t i) {
+		return "customer/" + std::to_string(i * 2654435761u % 1000000007u);
+	}
+
+	void run_string() {
+		hash_map<std::string, std::uint64_t> hm(num_keys);
+		measure("std::string insert", num_keys, [&](std::uint64_t i) {
+			hm.insert(std::make_pair(make_key(i), i));
+		});
+		measure("std::string find", num_keys, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(make_key((i * 40503) % num_keys)));
+		});
+	}
+
+	void run_arena() {
+		arena_hash_map<std::uint64_t> hm(num_keys);
+		measure("arena_hash_map insert", num_keys, [&](std::uint64_t i) {
+			hm.insert(make_key(i), i);
+		});
+		measure("arena_hash_map find", num_keys, [&](std::uint64_t i) {
+			do_not_optimize(hm.find(make_key((i * 40503) % num_keys)));
+		});
+	}
+}
+
+int main() {
+	run_string();
+	run_arena();
+}
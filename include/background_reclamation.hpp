@@ -0,0 +1,226 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef BACKGROUND_RECLAMATION_HPP_INCLUDED
+#define BACKGROUND_RECLAMATION_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/** \brief Destroys bucket lists replaced in a hash_map on a background thread.
+ *
+ * Use as \ref hash_map_traits::reclamation_policy to keep \c rehash(),
+ * \c clear() and the destruction of a \c hash_map from destroying a whole
+ * bucket list, along with all of its elements, on the calling thread.
+ *
+ * Retired objects are kept in a list shared by all maps using this policy.
+ * A single background thread, started on the first retirement, destroys
+ * those which have been retired for at least \ref grace_period() and are no
+ * longer used by any other thread. Objects still left when the process
+ * exits are not destroyed.
+ *
+ * \note The allocator of the \c hash_map must support deallocating memory
+ *     from another thread than the one which allocated it, and must outlive
+ *     the retired bucket lists. \ref reclaim() destroys all retired objects
+ *     which are no longer in use right away.
+ */
+class background_reclamation {
+public:
+	/// \brief The amount of retired memory not reclaimed yet.
+	struct backlog_type {
+		/// \brief The number of retired objects.
+		std::size_t objects;
+
+		/// \brief The approximate number of bytes held by retired objects.
+		std::size_t bytes;
+	};
+
+	/** \brief Hands an object over for destruction on the background thread.
+	 *
+	 * \param object The object to destroy once no one else uses it.
+	 * \param bytes The approximate number of bytes held by \c object.
+	 *
+	 * \note If the object can not be queued, it is released right away.
+	 */
+	static void retire(std::shared_ptr<void> object, std::size_t bytes) noexcept {
+		shared_state &state = shared();
+		try {
+			std::lock_guard<std::mutex> lock(state.mutex);
+			if (!state.worker_started) {
+				std::thread(run).detach();
+				state.worker_started = true;
+			}
+			state.retired.push_back(retired_object{
+				std::move(object), bytes, clock::now()
+			});
+			state.backlog.objects += 1;
+			state.backlog.bytes += bytes;
+		}
+		catch(...) {
+			// object is released along with the argument
+			return;
+		}
+		state.wake.notify_one();
+	}
+
+	/** \brief Returns the memory retired, but not reclaimed yet.
+	 *
+	 * \return The number of retired objects and the approximate number of
+	 *     bytes they hold.
+	 */
+	static backlog_type backlog() {
+		shared_state &state = shared();
+		std::lock_guard<std::mutex> lock(state.mutex);
+		return state.backlog;
+	}
+
+	/** \brief Destroys all retired objects no longer in use right away.
+	 *
+	 * Ignores the grace period and destroys the objects on the calling
+	 * thread.
+	 *
+	 * \return The number of objects destroyed.
+	 */
+	static std::size_t reclaim() {
+		shared_state &state = shared();
+		std::unique_lock<std::mutex> lock(state.mutex);
+		return reclaim(lock, clock::time_point::max());
+	}
+
+	/** \brief Returns the minimum time between retiring and destroying an
+	 *     object.
+	 *
+	 * Objects are retired in bursts, e.g. by repeated calls to \c clear(),
+	 * so waiting a bit lets the background thread destroy them in batches.
+	 */
+	static std::chrono::milliseconds grace_period() noexcept {
+		return std::chrono::milliseconds(10);
+	}
+
+private:
+	/// \internal \brief The clock used for the grace period.
+	typedef std::chrono::steady_clock clock;
+
+	/// \internal \brief An object waiting for its destruction.
+	struct retired_object {
+		/// \internal \brief The object.
+		std::shared_ptr<void> object;
+
+		/// \internal \brief The approximate number of bytes it holds.
+		std::size_t bytes;
+
+		/// \internal \brief When it was retired.
+		clock::time_point retired_at;
+	};
+
+	/// \internal \brief The state shared by all maps and the worker thread.
+	struct shared_state {
+		/// \internal \brief Creates an empty list.
+		shared_state()
+		: mutex()
+		, wake()
+		, retired()
+		, backlog{0, 0}
+		, worker_started(false) {}
+
+		/// \internal \brief Guards all other members.
+		std::mutex mutex;
+
+		/// \internal \brief Wakes the worker thread for newly retired objects.
+		std::condition_variable wake;
+
+		/// \internal \brief The objects waiting for their destruction.
+		std::vector<retired_object> retired;
+
+		/// \internal \brief The totals of \ref retired.
+		backlog_type backlog;
+
+		/// \internal \brief Whether the worker thread is running.
+		bool worker_started;
+	};
+
+	/** \internal \brief Returns the shared state.
+	 *
+	 * The state is never destroyed, so objects can still be retired by maps
+	 * destroyed after it would have been, and the worker thread never
+	 * accesses a destroyed state.
+	 */
+	static shared_state &shared() {
+		static shared_state *const state = new shared_state();
+		return *state;
+	}
+
+	/// \internal \brief The loop of the worker thread.
+	static void run() {
+		shared_state &state = shared();
+		std::unique_lock<std::mutex> lock(state.mutex);
+		while(true) {
+			if (state.retired.empty()) {
+				state.wake.wait(lock);
+			}
+			else {
+				state.wake.wait_for(lock, grace_period());
+			}
+			try {
+				reclaim(lock, clock::now() - grace_period());
+			}
+			catch(...) {
+				// out of memory; try again later
+			}
+		}
+	}
+
+	/** \internal \brief Destroys the retired objects no longer in use.
+	 *
+	 * \param lock The lock on the shared mutex, which is released while
+	 *     objects are being destroyed.
+	 * \param cutoff Objects retired after this point are kept.
+	 *
+	 * \return The number of objects destroyed.
+	 */
+	static std::size_t reclaim(
+		std::unique_lock<std::mutex> &lock,
+		clock::time_point cutoff
+	) {
+		shared_state &state = shared();
+
+		std::vector<std::shared_ptr<void>> doomed;
+		doomed.reserve(state.retired.size());
+
+		auto kept = state.retired.begin();
+		for(auto &entry: state.retired) {
+			// a retired object is not reachable through its map anymore, so
+			// once no one else holds a reference, no one will take a new one.
+			if (entry.retired_at <= cutoff && entry.object.use_count() == 1) {
+				doomed.push_back(std::move(entry.object));
+				state.backlog.objects -= 1;
+				state.backlog.bytes -= entry.bytes;
+			}
+			else {
+				if (&*kept != &entry) {
+					*kept = std::move(entry);
+				}
+				++kept;
+			}
+		}
+		state.retired.erase(kept, state.retired.end());
+
+		// destroy outside the lock, so retiring does not wait for it
+		lock.unlock();
+		const std::size_t count = doomed.size();
+		doomed.clear();
+		lock.lock();
+		return count;
+	}
+};
+
+#endif // BACKGROUND_RECLAMATION_HPP_INCLUDED
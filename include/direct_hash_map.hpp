@@ -0,0 +1,949 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef DIRECT_HASH_MAP_HPP_INCLUDED
+#define DIRECT_HASH_MAP_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+
+#include <atomic>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/** \brief A concurrency friendly map for integer keys from a dense range.
+ * \nosubgrouping
+ *
+ * This is an alternative engine to \ref hash_map for keys from
+ * <tt>[0, bucket_count)</tt>, such as IDs handed out in order. Instead of
+ * hashing keys into buckets, it keeps one slot per key of the range: The slot
+ * of a key is its index into an array. Each slot holds an atomic pointer to
+ * the element, which is empty if the key is not present. So \ref find() loads
+ * a single pointer, without hashing, dividing or comparing keys, and
+ * \ref insert() and \ref erase() take effect with a single compare and swap
+ * on it.
+ *
+ * Elements are held by \c std::shared_ptr, like the nodes of \ref hash_map.
+ * An operation holds the element it works on until it is done with it, so
+ * \ref at() and \c operator[] return a reference to an element which has not
+ * been destroyed by a concurrent \ref erase() in the meantime. As with
+ * \ref hash_map, iterators and references do not keep elements alive, and
+ * must not be used after their element has been erased concurrently.
+ * \ref insert_or_assign() assigns to existing elements in place, so it does
+ * not invalidate them.
+ *
+ * The interface follows \ref hash_map, with these differences:
+ *     - Keys outside of <tt>[0, bucket_count())</tt> can not be stored.
+ *         Inserting them throws \c std::out_of_range, looking them up finds
+ *         nothing.
+ *     - There is no hash function, and every slot is a bucket of its own.
+ *
+ * \tparam Key The type for element keys. Must be an integral type.
+ * \tparam T The type for element values.
+ * \tparam Allocator The type of the allocator.
+ */
+template<
+	typename Key,
+	typename T,
+	typename Allocator = std::allocator< std::pair<const Key, T> >
+>
+struct direct_hash_map {
+	static_assert( std::is_integral<Key>::value && !std::is_same<Key, bool>::value,
+		"direct_hash_map requires an integral key type other than bool." );
+
+private:
+/// \name Member Types
+///\{
+	struct slot_table;
+	/// \internal \brief A smart pointer to a slot table.
+	typedef std::shared_ptr<slot_table> table_pointer;
+
+public:
+	/// \brief The type used for element counts and indices.
+	typedef std::size_t                 size_type;
+
+	/// \brief The difference type of two iterators.
+	typedef std::ptrdiff_t              difference_type;
+
+	/// \brief The storage type stored in the map.
+	typedef std::pair<const Key, T>     value_type;
+
+	/// \brief The type for element keys.
+	typedef Key                         key_type;
+
+	/// \brief The type for element values.
+	typedef T                           mapped_type;
+
+	/// \brief The type of the allocator.
+	typedef Allocator                   allocator_type;
+
+private:
+	/// \internal \brief A smart pointer to an element.
+	typedef std::shared_ptr<value_type> element_pointer;
+
+	/** \internal \brief A slot of the table.
+	 *
+	 * Only ever accessed through the atomic functions for
+	 * \c std::shared_ptr.
+	 */
+	typedef element_pointer slot;
+
+	/** \internal \brief Implementation of the iterators of the
+	 *     direct_hash_map.
+	 *
+	 * Like the iterators of \ref hash_map, these refer to the element, but do
+	 * not keep it alive.
+	 *
+	 * \tparam Value The type referred to by the iterator.
+	 */
+	template<typename Value>
+	class iterator_impl {
+		friend struct direct_hash_map;
+
+	public:
+		/// \brief The iterator category.
+		typedef std::forward_iterator_tag iterator_category;
+
+		/// \brief The difference type of two iterators.
+		typedef std::ptrdiff_t          difference_type;
+
+		/// \brief The type referred to by the iterator.
+		typedef Value                   value_type;
+
+		/// \brief A reference to the element.
+		typedef Value &                 reference;
+
+		/// \brief A pointer to the element.
+		typedef Value *                 pointer;
+
+		/// \brief Default constructs an end iterator.
+		iterator_impl()
+		: pos(nullptr)
+		, last(nullptr)
+		, element(nullptr) {}
+
+		/// \brief Converts an iterator to a const_iterator.
+		template<
+			typename Other,
+			typename = std::enable_if_t<std::is_same<const Other, Value>::value>
+		>
+		iterator_impl(const iterator_impl<Other> &other)
+		: pos(other.pos)
+		, last(other.last)
+		, element(other.element) {}
+
+		/** \brief Advances the iterator to the next element.
+		 *
+		 * \pre
+		 *     - <tt>*this</tt> is valid,
+		 *     - <tt>*this != end()</tt>.
+		 *
+		 * \return Returns itself after advancing.
+		 */
+		iterator_impl &operator++() {
+			assert( pos && "cannot increment an end iterator" );
+			++pos;
+			skip_free();
+			return *this;
+		}
+
+		/** \brief Advances this iterator and returns the previous value.
+		 *
+		 * \return An iterator to the element this iterator referred to before
+		 *     the call.
+		 */
+		iterator_impl operator++(int) {
+			iterator_impl copy(*this);
+			++*this;
+			return copy;
+		}
+
+		/** \brief Compares two iterators.
+		 *
+		 * \return
+		 *     - \c true if this iterator equals \c other,
+		 *     - \c false otherwise.
+		 */
+		bool operator==(const iterator_impl &other) const {
+			return pos == other.pos;
+		}
+
+		/** \brief Compares two iterators.
+		 *
+		 * \return
+		 *     - \c true if this iterator differs from \c other,
+		 *     - \c false otherwise.
+		 */
+		bool operator!=(const iterator_impl &other) const {
+			return pos != other.pos;
+		}
+
+		/** \brief Dereferences the iterator.
+		 *
+		 * \return A reference to the element.
+		 */
+		reference operator*() const {
+			assert( element && "cannot dereference invalid iterator" );
+			return *element;
+		}
+
+		/** \brief Dereferences the iterator.
+		 *
+		 * \return A pointer to the element.
+		 */
+		pointer operator->() const {
+			assert( element && "cannot dereference invalid iterator" );
+			return element;
+		}
+
+	private:
+		template<typename Other>
+		friend class iterator_impl;
+
+		/** \internal \brief Creates an iterator to the first element at or
+		 *     after a slot.
+		 */
+		iterator_impl(slot *pos, slot *last)
+		: pos(pos)
+		, last(last)
+		, element(nullptr) {
+			skip_free();
+		}
+
+		/// \internal \brief Creates an iterator to an element already loaded.
+		iterator_impl(slot *pos, slot *last, Value *element)
+		: pos(pos)
+		, last(last)
+		, element(element) {}
+
+		/** \internal \brief Advances to the next slot holding an element.
+		 *
+		 * Becomes an end iterator at the end of the table.
+		 */
+		void skip_free() {
+			for(; pos != last; ++pos) {
+				element = std::atomic_load(pos).get();
+				if (element) {
+					return;
+				}
+			}
+			pos = nullptr;
+			last = nullptr;
+			element = nullptr;
+		}
+
+		/// \internal \brief The slot the iterator refers to.
+		slot *pos;
+
+		/// \internal \brief The end of the table of \ref pos.
+		slot *last;
+
+		/// \internal \brief The element, as loaded from the slot.
+		Value *element;
+	};
+
+public:
+	/// \brief The iterator type for the direct_hash_map.
+	typedef iterator_impl<value_type> iterator;
+
+	/// \brief The const iterator type for the direct_hash_map.
+	typedef iterator_impl<const value_type> const_iterator;
+///\}
+
+
+
+/// \name Member Functions
+///\{
+	/** \brief Creates an empty direct_hash_map.
+	 *
+	 * \param bucket_count The number of slots, and thus the size of the
+	 *     range of keys the map can hold.
+	 * \param allocator The allocator to use.
+	 *
+	 * \pre
+	 *     - <tt>0 < bucket_count</tt>
+	 */
+	explicit direct_hash_map(
+		const size_type bucket_count,
+		const allocator_type &allocator = allocator_type{}
+	)
+	: current_table(slot_table::create(bucket_count, allocator)) {
+		assert( 0 < bucket_count
+			&& "can not have a direct_hash_map without slots" );
+	}
+
+	/** \brief Creates a copy of a direct_hash_map.
+	 *
+	 * \post
+	 *     - <tt>*this == other</tt>
+	 */
+	direct_hash_map(const direct_hash_map &other)
+	: current_table(std::atomic_load(&other.current_table)->copy()) {}
+
+	/** \brief Destructs the direct_hash_map.
+	 *
+	 * \post
+	 *     - All iterators are invalidated.
+	 */
+	~direct_hash_map() = default;
+
+	/** \brief Assigns all elements from another direct_hash_map to this one.
+	 *
+	 * \return A reference to this direct_hash_map.
+	 *
+	 * \post
+	 *     - <tt>*this == other</tt>
+	 */
+	direct_hash_map &operator=(const direct_hash_map &other) {
+		direct_hash_map temp(other);
+		swap(temp);
+		return *this;
+	}
+
+	/** \brief Swaps contents with another direct_hash_map.
+	 *
+	 * \param other The direct_hash_map to swap contents with.
+	 *
+	 * \note This function is not thread safe, for the same reasons as
+	 *     \ref hash_map::swap().
+	 */
+	void swap(direct_hash_map &other) {
+		table_pointer temp = std::atomic_exchange(
+			&other.current_table,
+			current_table
+		);
+		std::atomic_store(&current_table, temp);
+	}
+
+	/** \brief Compares the values in the direct_hash_map.
+	 *
+	 * \param other Another direct_hash_map to compare against.
+	 *
+	 * \pre
+	 *     - \c mapped_type is <tt>==</tt> comparable.
+	 *
+	 * \return
+	 *     - \c true if the contents of the containers are equal,
+	 *     - \c false otherwise.
+	 */
+	bool operator==(const direct_hash_map &other) const {
+		if (this == &other) {
+			return true;
+		}
+		if (size() != other.size()) {
+			return false;
+		}
+		for(const value_type &value: *this) {
+			const const_iterator it = other.find(value.first);
+			if (it == other.end() || !(it->second == value.second)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** \brief Compares the values in the direct_hash_map.
+	 *
+	 * \param other Another direct_hash_map to compare against.
+	 *
+	 * \return
+	 *     - \c true if the contents of the containers differ,
+	 *     - \c false otherwise.
+	 */
+	bool operator!=(const direct_hash_map &other) const {
+		return !operator==(other);
+	}
+
+	/** \brief Changes the range of keys the map can hold.
+	 *
+	 * \param new_bucket_count The new number of slots after rehashing.
+	 *
+	 * \pre
+	 *     - <tt>0 < new_bucket_count</tt>
+	 *     - All keys in the map are less than \c new_bucket_count.
+	 *
+	 * \post
+	 *     - <tt>bucket_count() == new_bucket_count</tt>
+	 *     - <tt>after_rehash == before_rehash</tt>
+	 *
+	 * \note If any allocations fail in the process, the value of the
+	 *     direct_hash_map will be unchanged.
+	 *
+	 * \note This function is not thread safe.
+	 */
+	void rehash(size_type new_bucket_count) {
+		assert( 0 < new_bucket_count
+			&& "can not have a direct_hash_map without slots" );
+
+		std::atomic_store(
+			&current_table, current_table->copy(new_bucket_count)
+		);
+	}
+
+	/** \brief Returns the allocator.
+	 *
+	 * \return A copy of the allocator.
+	 */
+	allocator_type get_allocator() const {
+		return std::atomic_load(&current_table)->allocator;
+	}
+///\}
+
+
+
+/// \name Iterators
+///\{
+/// \note These functions are thread safe.
+	/** \brief Returns an iterator to the first element.
+	 *
+	 * \return An iterator to the first element, or <tt>end()</tt> if the
+	 *     map is empty.
+	 */
+	iterator begin() {
+		const table_pointer table = std::atomic_load(&current_table);
+		return iterator(table->slots, table->slots + table->slot_count);
+	}
+
+	/// \copydoc begin()
+	const_iterator begin() const {
+		return const_cast<direct_hash_map*>(this)->begin();
+	}
+
+	/// \copydoc begin()
+	const_iterator cbegin() const {
+		return begin();
+	}
+
+	/** \brief Returns an iterator past the last element.
+	 *
+	 * \return An iterator past the last element.
+	 */
+	iterator end() {
+		return iterator();
+	}
+
+	/// \copydoc end()
+	const_iterator end() const {
+		return const_iterator();
+	}
+
+	/// \copydoc end()
+	const_iterator cend() const {
+		return end();
+	}
+///\}
+
+
+
+/// \name Capacity
+///\{
+/// \note These functions are thread safe.
+	/** \brief Checks whether the container is empty.
+	 *
+	 * \return
+	 *     - \c true if the container is empty,
+	 *     - \c false otherwise.
+	 */
+	bool empty() const {
+		return 0 == size();
+	}
+
+	/** \brief Returns the number of elements.
+	 *
+	 * \return The number of elements in the container.
+	 */
+	size_type size() const {
+		return std::atomic_load(&current_table)->element_count;
+	}
+
+	/** \brief Returns the maximum possible number of elements.
+	 *
+	 * \return The maximum possible number of elements in the container.
+	 */
+	size_type max_size() const {
+		return max_bucket_count();
+	}
+///\}
+
+
+
+/// \name Modifiers
+///\{
+/// \note These functions are thread safe.
+	/** \brief Clears the contents.
+	 *
+	 * \post
+	 *     - <tt>empty() == true</tt>
+	 *     - All iterators to this direct_hash_map are invalidated.
+	 */
+	void clear() {
+		table_pointer table = std::atomic_load(&current_table);
+		table_pointer new_table = slot_table::create(
+			table->slot_count, table->allocator
+		);
+
+		// See hash_map::clear() for why a failure does not need a retry.
+		std::atomic_compare_exchange_strong(
+			&current_table, &table, new_table
+		);
+	}
+
+	/** \brief Inserts an element into the map.
+	 *
+	 * \param value The value to insert into the map.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if the key of \c value is not less
+	 *     than <tt>bucket_count()</tt>.
+	 *
+	 * \return A pair \c pair as follows:
+	 *     - <tt>pair.first == true</tt>, if \c value was inserted
+	 *         successfully. <tt>pair.second</tt> will be an iterator to the
+	 *         newly inserted element.
+	 *     - <tt>pair.first == false</tt>, if an item with the given key exists
+	 *         already. <tt>pair.second</tt> will be an iterator to the
+	 *         element that blocked the insertion.
+	 */
+	std::pair<bool, iterator> insert(const value_type &value) {
+		const table_pointer table = std::atomic_load(&current_table);
+		slot *const found = table->slot_for_insert(value.first);
+
+		element_pointer new_element;
+		element_pointer element = std::atomic_load(found);
+		while(true) {
+			if (element) {
+				return std::make_pair(false, table->at(found, element.get()));
+			}
+
+			if (!new_element) {
+				new_element = table->create_element(value);
+			}
+
+			// an empty slot: claim it, unless someone else is faster
+			if (std::atomic_compare_exchange_strong(
+				found, &element, new_element
+			)) {
+				++table->element_count;
+				return std::make_pair(true, table->at(found, new_element.get()));
+			}
+			// else element holds whatever claimed the slot
+		}
+	}
+
+	/** \brief Inserts an element into the map.
+	 *
+	 * This function is equivalent to calling <tt>insert(value)</tt>.
+	 *
+	 * \param hint Ignored.
+	 * \param value The value to insert into the map.
+	 *
+	 * \return An iterator to the newly inserted element or to the existing
+	 *     element with they same key as \c value that blocked the insertion.
+	 */
+	iterator insert(const_iterator hint, const value_type &value) {
+		((void)hint); // unused, suppress warning
+		return insert(value).second;
+	}
+
+	/** \brief Inserts an element into the map or modifies an existing one.
+	 *
+	 * Like \ref hash_map::insert_or_assign(), an existing element is
+	 * assigned to in place, so references to it stay valid.
+	 *
+	 * \param key The key of the element in the map.
+	 * \param mapped The value to insert or assign.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if \c key is not less than
+	 *     <tt>bucket_count()</tt>.
+	 *
+	 * \return An iterator to the element with key \c key.
+	 */
+	iterator insert_or_assign(const key_type &key, const mapped_type &mapped) {
+		const table_pointer table = std::atomic_load(&current_table);
+		slot *const found = table->slot_for_insert(key);
+
+		element_pointer new_element;
+		element_pointer element = std::atomic_load(found);
+		while(true) {
+			if (element) {
+				// element keeps the element alive while it is assigned to
+				element->second = mapped;
+				return table->at(found, element.get());
+			}
+
+			if (!new_element) {
+				new_element = table->create_element(value_type(key, mapped));
+			}
+
+			if (std::atomic_compare_exchange_strong(
+				found, &element, new_element
+			)) {
+				++table->element_count;
+				return table->at(found, new_element.get());
+			}
+			// else element holds what has been inserted concurrently
+		}
+	}
+
+	/** \brief Removes an element from the direct_hash_map by its key.
+	 *
+	 * \param key The key of the element in the direct_hash_map.
+	 *
+	 * \return The number of elements erased from the direct_hash_map
+	 *     (0 or 1).
+	 *
+	 * \post
+	 *     - <tt>find(key) == end()</tt>
+	 */
+	size_type erase(const key_type &key) {
+		const table_pointer table = std::atomic_load(&current_table);
+		slot *const found = table->slot_for(key);
+		if (!found) {
+			return 0;
+		}
+
+		element_pointer element = std::atomic_load(found);
+		while(element) {
+			if (std::atomic_compare_exchange_weak(
+				found, &element, element_pointer()
+			)) {
+				--table->element_count;
+				return 1;
+			}
+			// else the element has been replaced or erased concurrently
+		}
+		return 0;
+	}
+
+	/** \brief Removes an element from the direct_hash_map by its iterator.
+	 *
+	 * \param pos An iterator to the element to erase.
+	 *
+	 * \return An iterator to the element after the deleted one.
+	 */
+	iterator erase(const_iterator pos) {
+		assert( pos.pos && "cannot erase an end iterator" );
+		const iterator next(pos.pos + 1, pos.last);
+		erase(pos->first);
+		return next;
+	}
+///\}
+
+
+
+/// \name Lookup
+///\{
+/// \note These functions are thread safe.
+	/** \brief Accesses an element by its key, with bounds-checking.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if no element with the key \c key is
+	 *     stored in the direct_hash_map.
+	 *
+	 * \return A reference to the value of the element requested.
+	 */
+	mapped_type &at(const key_type &key) {
+		const table_pointer table = std::atomic_load(&current_table);
+		slot *const found = table->slot_for(key);
+
+		// hold on to the element until the reference is taken, so a
+		// concurrent erase() can not destroy it in the meantime
+		const element_pointer element = found
+			? std::atomic_load(found)
+			: element_pointer();
+		if (element) {
+			return element->second;
+		}
+		else {
+			throw std::out_of_range("element not found in direct_hash_map");
+		}
+	}
+
+	/// \copydoc at()
+	const mapped_type &at(const key_type &key) const {
+		return const_cast<direct_hash_map*>(this)->at(key);
+	}
+
+	/** \brief Accesses an element by its key, inserting it if necessary.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if \c key is not less than
+	 *     <tt>bucket_count()</tt>.
+	 *
+	 * \return A reference to the value of the element with the key \c key.
+	 */
+	mapped_type &operator[](const key_type &key) {
+		const table_pointer table = std::atomic_load(&current_table);
+		slot *const found = table->slot_for_insert(key);
+
+		// see at() for why the element is held
+		element_pointer new_element;
+		element_pointer element = std::atomic_load(found);
+		while(!element) {
+			if (!new_element) {
+				new_element = table->create_element(
+					value_type(key, mapped_type{})
+				);
+			}
+			if (std::atomic_compare_exchange_strong(
+				found, &element, new_element
+			)) {
+				++table->element_count;
+				element = new_element;
+			}
+		}
+		return element->second;
+	}
+
+	/** \brief Counts the number of elements with a specific key.
+	 *
+	 * \param key The key of the element to count.
+	 *
+	 * \return The number of elements with the key \c key. (0 or 1)
+	 */
+	size_type count(const key_type &key) const {
+		return (find(key) != cend())
+			? 1
+			: 0;
+	}
+
+	/** \brief Finds an element by its key.
+	 *
+	 * \param key The key of the element to fetch.
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	iterator find(const key_type &key) {
+		const table_pointer table = std::atomic_load(&current_table);
+		slot *const found = table->slot_for(key);
+		if (!found) {
+			return end();
+		}
+
+		value_type *const element = std::atomic_load(found).get();
+		return element
+			? table->at(found, element)
+			: end();
+	}
+
+	/// \copydoc find()
+	const_iterator find(const key_type &key) const {
+		return const_cast<direct_hash_map*>(this)->find(key);
+	}
+///\}
+
+
+
+/// \name Bucket Interface
+///\{
+/// \note These functions are thread safe.
+	/** \brief Returns the number of slots.
+	 *
+	 * \return The number of slots, which is the size of the range of keys.
+	 */
+	size_type bucket_count() const {
+		return std::atomic_load(&current_table)->slot_count;
+	}
+
+	/** \brief Returns the maximum possible number of slots.
+	 *
+	 * \return The maximum possible number of slots in the container.
+	 */
+	size_type max_bucket_count() const {
+		return std::numeric_limits<size_type>::max() / sizeof(slot);
+	}
+
+	/** \brief Returns the slot of a key.
+	 *
+	 * \param key The key for which to retrieve the slot index.
+	 *
+	 * \pre
+	 *     - <tt>0 <= key</tt>
+	 *
+	 * \return \c key, converted to \c size_type.
+	 */
+	size_type bucket(const key_type &key) const {
+		assert( !is_negative(key)
+			&& "negative keys have no slot" );
+		return static_cast<size_type>(key);
+	}
+///\}
+
+
+
+/// \internal \name Internals
+///\{ \internal
+private:
+	/// \internal \brief Checks whether a key is negative.
+	static bool is_negative(const key_type &key) noexcept {
+		return is_negative(key, std::is_signed<key_type>{});
+	}
+
+	/// \internal \brief Checks whether a key of a signed type is negative.
+	static bool is_negative(const key_type &key, std::true_type) noexcept {
+		return key < 0;
+	}
+
+	/// \internal \brief Keys of unsigned types are never negative.
+	static bool is_negative(const key_type &, std::false_type) noexcept {
+		return false;
+	}
+
+	/** \internal \brief A fixed size array of slots, one per key.
+	 *
+	 * A slot only ever changes between empty and holding an element of its
+	 * key, and between elements of its key.
+	 */
+	struct slot_table {
+		/// \internal \brief The allocator for slots.
+		typedef typename std::allocator_traits<allocator_type>
+			::template rebind_alloc<slot> slot_allocator_type;
+
+		/// \internal \brief The allocator traits for slots.
+		typedef typename std::allocator_traits<allocator_type>
+			::template rebind_traits<slot> slot_allocator_traits;
+
+		/** \internal
+		 * \brief Creates a slot table.
+		 *
+		 * \param slot_count The number of slots in this table.
+		 * \param allocator The allocator to use for allocating the slots.
+		 */
+		static table_pointer create(
+			size_type slot_count,
+			const allocator_type &allocator
+		) {
+			return std::allocate_shared<slot_table, allocator_type>(
+				allocator, slot_count, allocator
+			);
+		}
+
+		/** \internal \brief Creates a table of empty slots.
+		 *
+		 * \param slot_count The number of slots in this table.
+		 * \param allocator The allocator to use for allocating the slots.
+		 */
+		slot_table(size_type slot_count, const allocator_type &allocator)
+		: slot_count(slot_count)
+		, element_count(0)
+		, allocator(allocator)
+		, slot_allocator(allocator)
+		, slots(slot_allocator_traits::allocate(slot_allocator, slot_count)) {
+			for(size_type n=0; n < slot_count; ++n) {
+				slot_allocator_traits::construct(slot_allocator, slots + n);
+			}
+		}
+
+		slot_table(const slot_table &) = delete;
+		slot_table &operator=(const slot_table &) = delete;
+
+		/// \internal \brief Destroys the slot table along with its elements.
+		~slot_table() {
+			for(size_type n=0; n < slot_count; ++n) {
+				slot_allocator_traits::destroy(slot_allocator, slots + n);
+			}
+			slot_allocator_traits::deallocate(slot_allocator, slots, slot_count);
+		}
+
+		/** \internal \brief Copies the elements into a table of the same size.
+		 *
+		 * \note Concurrent modifications may or may not be copied.
+		 */
+		table_pointer copy() const {
+			return copy(slot_count);
+		}
+
+		/** \internal \brief Copies the elements into a new table.
+		 *
+		 * \param new_slot_count The number of slots of the new table.
+		 *
+		 * \note Concurrent modifications may or may not be copied.
+		 */
+		table_pointer copy(size_type new_slot_count) const {
+			table_pointer new_table = create(new_slot_count, allocator);
+			for(size_type n=0; n < slot_count; ++n) {
+				const element_pointer element = std::atomic_load(slots + n);
+				if (!element) {
+					continue;
+				}
+				assert( n < new_slot_count
+					&& "can not copy a key into a table too small for it" );
+
+				// the new table is not shared yet
+				new_table->slots[n] = new_table->create_element(*element);
+				++new_table->element_count;
+			}
+			return new_table;
+		}
+
+		/** \internal \brief Creates an element which is not in the table yet.
+		 *
+		 * \param value The value of the element.
+		 */
+		element_pointer create_element(const value_type &value) const {
+			return std::allocate_shared<value_type, allocator_type>(
+				allocator, value
+			);
+		}
+
+		/** \internal \brief Returns the slot of a key.
+		 *
+		 * \return The slot, or \c nullptr if the key is out of range.
+		 */
+		slot *slot_for(const key_type &key) const {
+			if (is_negative(key)) {
+				return nullptr;
+			}
+			const size_type n = static_cast<size_type>(key);
+			return (n < slot_count)
+				? slots + n
+				: nullptr;
+		}
+
+		/** \internal \brief Returns the slot of a key for an insertion.
+		 *
+		 * \throw <tt>std::out_of_range</tt> if the key is out of range.
+		 */
+		slot *slot_for_insert(const key_type &key) const {
+			slot *const found = slot_for(key);
+			if (!found) {
+				throw std::out_of_range("key out of range of direct_hash_map");
+			}
+			return found;
+		}
+
+		/// \internal \brief Returns an iterator to an element of this table.
+		iterator at(slot *pos, value_type *element) const {
+			return iterator(pos, slots + slot_count, element);
+		}
+
+		/// \internal \brief The number of slots in \ref slots.
+		const size_type slot_count;
+
+		/// \internal \brief The number of elements held by the slots.
+		std::atomic<size_type> element_count;
+
+		/// \internal \brief The allocator for elements.
+		allocator_type allocator;
+
+		/// \internal \brief The allocator for the slot array.
+		slot_allocator_type slot_allocator;
+
+		/// \internal \brief The slots, indexed by key.
+		slot *const slots;
+	};
+
+	/// \internal \brief The current slot table.
+	table_pointer current_table;
+///\}
+};
+
+#endif // DIRECT_HASH_MAP_HPP_INCLUDED
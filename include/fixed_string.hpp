@@ -0,0 +1,240 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef FIXED_STRING_HPP_INCLUDED
+#define FIXED_STRING_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "hashers.hpp"
+
+/** \brief A string of up to \c N characters stored inline.
+ *
+ * The characters are stored behind a length prefix and padded with zeroes up
+ * to a multiple of 16 bytes, so two strings are equal exactly if all of their
+ * bytes are equal. This allows comparing them a vector at a time, without
+ * looking at their lengths or at individual characters. Unlike
+ * \c std::string, a \c fixed_string never allocates, so using it as the key
+ * of a \c hash_map keeps the key inside the node.
+ *
+ * \tparam N The maximum number of characters. Strings of up to 30 characters
+ *     take 32 bytes, which are compared using one AVX2 or two SSE2
+ *     instructions.
+ */
+template<std::size_t N>
+class alignas(16) fixed_string {
+	static_assert( 0 < N && N <= 255,
+		"fixed_string supports between 1 and 255 characters." );
+
+public:
+	/// \brief The type for sizes.
+	typedef std::size_t size_type;
+
+	/// \brief Creates an empty string.
+	fixed_string() noexcept
+	: bytes() {}
+
+	/** \brief Creates a string from a range of characters.
+	 *
+	 * \param chars The first character.
+	 * \param length The number of characters.
+	 *
+	 * \throw <tt>std::length_error</tt> if <tt>length > max_size()</tt>.
+	 */
+	fixed_string(const char *chars, size_type length)
+	: bytes() {
+		if (length > N) {
+			throw std::length_error("string too long for fixed_string");
+		}
+		bytes[0] = static_cast<unsigned char>(length);
+		std::memcpy(bytes + 1, chars, length);
+	}
+
+	/** \brief Creates a string from a null terminated string.
+	 *
+	 * \param chars The null terminated string.
+	 *
+	 * \throw <tt>std::length_error</tt> if the string is longer than
+	 *     <tt>max_size()</tt>.
+	 */
+	fixed_string(const char *chars)
+	: fixed_string(chars, std::strlen(chars)) {}
+
+	/** \brief Creates a string from a \c std::string.
+	 *
+	 * \param str The string to copy.
+	 *
+	 * \throw <tt>std::length_error</tt> if <tt>str.size() > max_size()</tt>.
+	 */
+	fixed_string(const std::string &str)
+	: fixed_string(str.data(), str.size()) {}
+
+	/** \brief Returns the number of characters.
+	 *
+	 * \return The number of characters.
+	 */
+	size_type size() const noexcept {
+		return bytes[0];
+	}
+
+	/** \brief Returns the number of characters.
+	 *
+	 * \return The number of characters.
+	 */
+	size_type length() const noexcept {
+		return size();
+	}
+
+	/** \brief Checks whether the string is empty.
+	 *
+	 * \return \c true if the string has no characters.
+	 */
+	bool empty() const noexcept {
+		return size() == 0;
+	}
+
+	/** \brief Returns the maximum number of characters.
+	 *
+	 * \return \c N
+	 */
+	static constexpr size_type max_size() noexcept {
+		return N;
+	}
+
+	/** \brief Returns the characters.
+	 *
+	 * \return A pointer to the null terminated characters.
+	 */
+	const char *data() const noexcept {
+		return reinterpret_cast<const char *>(bytes + 1);
+	}
+
+	/** \brief Returns the characters.
+	 *
+	 * \return A pointer to the null terminated characters.
+	 */
+	const char *c_str() const noexcept {
+		return data();
+	}
+
+	/** \brief Copies the string into a \c std::string.
+	 *
+	 * \return A \c std::string with the same characters.
+	 */
+	std::string str() const {
+		return std::string(data(), size());
+	}
+
+	/** \brief Calculates the hash of the string.
+	 *
+	 * All bytes including the padding are hashed at once, so the number of
+	 * steps is known at compile time.
+	 *
+	 * \return The hash of the string.
+	 */
+	std::size_t hash() const noexcept {
+		return bytes_hash(0)(bytes, sizeof(bytes));
+	}
+
+	/** \brief Compares two strings.
+	 *
+	 * \return \c true if both strings have the same characters.
+	 */
+	friend bool operator==(const fixed_string &a, const fixed_string &b) noexcept {
+		return a.equals(b);
+	}
+
+	/** \brief Compares two strings.
+	 *
+	 * \return \c true if the strings have different characters.
+	 */
+	friend bool operator!=(const fixed_string &a, const fixed_string &b) noexcept {
+		return !a.equals(b);
+	}
+
+	/** \brief Compares two strings lexicographically.
+	 *
+	 * \return \c true if \c a comes before \c b.
+	 */
+	friend bool operator<(const fixed_string &a, const fixed_string &b) noexcept {
+		const int result = std::memcmp(
+			a.data(), b.data(), (a.size() < b.size()) ? a.size() : b.size()
+		);
+		return result < 0 || (result == 0 && a.size() < b.size());
+	}
+
+private:
+	/** \internal \brief Compares all bytes of two strings.
+	 *
+	 * \return \c true if all bytes are equal.
+	 */
+	bool equals(const fixed_string &other) const noexcept {
+#if defined(__SSE2__)
+		std::size_t offset = 0;
+#if defined(__AVX2__)
+		for(; offset + 32 <= sizeof(bytes); offset += 32) {
+			const __m256i equal = _mm256_cmpeq_epi8(
+				_mm256_loadu_si256(
+					reinterpret_cast<const __m256i *>(bytes + offset)),
+				_mm256_loadu_si256(
+					reinterpret_cast<const __m256i *>(other.bytes + offset))
+			);
+			if (_mm256_movemask_epi8(equal) != -1) {
+				return false;
+			}
+		}
+#endif
+		for(; offset < sizeof(bytes); offset += 16) {
+			const __m128i equal = _mm_cmpeq_epi8(
+				_mm_loadu_si128(
+					reinterpret_cast<const __m128i *>(bytes + offset)),
+				_mm_loadu_si128(
+					reinterpret_cast<const __m128i *>(other.bytes + offset))
+			);
+			if (_mm_movemask_epi8(equal) != 0xffff) {
+				return false;
+			}
+		}
+		return true;
+#else
+		return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+#endif
+	}
+
+	/** \internal \brief The length, the characters and the padding.
+	 *
+	 * There is always room for at least one padding byte, which terminates
+	 * the characters.
+	 */
+	unsigned char bytes[(N + 2 + 15) / 16 * 16];
+};
+
+namespace std {
+	/// \brief Hashes a \ref fixed_string.
+	template<std::size_t N>
+	struct hash<fixed_string<N>> {
+		/** \brief Calculates the hash of a string.
+		 *
+		 * \param str The string to hash.
+		 *
+		 * \return The hash of \c str.
+		 */
+		std::size_t operator()(const fixed_string<N> &str) const noexcept {
+			return str.hash();
+		}
+	};
+}
+
+#endif // FIXED_STRING_HPP_INCLUDED
@@ -0,0 +1,418 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef FROZEN_HASH_MAP_HPP_INCLUDED
+#define FROZEN_HASH_MAP_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "hash_map.hpp"
+
+/** \brief An immutable copy of a \ref hash_map, laid out for lookups.
+ * \nosubgrouping
+ *
+ * Created by \ref hash_map::freeze(). The elements are stored in one
+ * contiguous array, sorted by bucket, next to an array of their hashes and an
+ * array of the offsets at which every bucket starts. A lookup hashes the key,
+ * maps it to its bucket like the \c hash_map would, and scans the hashes of
+ * that bucket; there are no atomic operations, no reference counting and no
+ * retries.
+ *
+ * As nothing can be modified, all functions are thread safe. To modify the
+ * elements, create a mutable \c hash_map with \ref thaw().
+ *
+ * \tparam Key The type for element keys.
+ * \tparam T The type for element values.
+ * \tparam Hash The type of the hash function.
+ * \tparam KeyEqual The type of the key equality comparator.
+ * \tparam Allocator The type of the allocator.
+ * \tparam Traits The compile time configuration of the \c hash_map. Only
+ *     \c bucket_index_policy is used by the frozen map.
+ */
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename Allocator = std::allocator< std::pair<const Key, T> >,
+	typename Traits = hash_map_traits
+>
+class frozen_hash_map {
+public:
+/// \name Member Types
+///\{
+	/// \brief The mutable map type.
+	typedef hash_map<Key, T, Hash, KeyEqual, Allocator, Traits> map_type;
+
+	/// \brief The type used for element counts and indices.
+	typedef typename map_type::size_type       size_type;
+
+	/// \brief The difference type of two iterators.
+	typedef typename map_type::difference_type difference_type;
+
+	/// \brief The storage type stored in the map.
+	typedef typename map_type::value_type      value_type;
+
+	/// \brief The type for element keys.
+	typedef typename map_type::key_type        key_type;
+
+	/// \brief The type for element values.
+	typedef typename map_type::mapped_type     mapped_type;
+
+	/// \brief The type of the hash function.
+	typedef typename map_type::hasher          hasher;
+
+	/// \brief The type of the key equality comparator.
+	typedef typename map_type::key_equal       key_equal;
+
+	/// \brief The type of the allocator.
+	typedef typename map_type::allocator_type  allocator_type;
+
+	/// \brief The compile time configuration.
+	typedef typename map_type::traits_type     traits_type;
+
+	/// \brief The return type of the hash function.
+	typedef typename map_type::hash_type       hash_type;
+
+	/// \brief A key together with its precomputed hash.
+	typedef typename map_type::hashed_key      hashed_key;
+
+	/// \brief The iterator type for the frozen_hash_map.
+	typedef const value_type *const_iterator;
+
+	/// \brief Elements can not be modified.
+	typedef const_iterator     iterator;
+
+	/// \brief The local iterator type for the frozen_hash_map.
+	typedef const_iterator     const_local_iterator;
+
+	/// \brief Elements can not be modified.
+	typedef const_iterator     local_iterator;
+///\}
+
+
+
+/// \name Member Functions
+///\{
+	/** \brief Copies the elements of a hash_map.
+	 *
+	 * \param map The hash_map to copy.
+	 *
+	 * \post
+	 *     - <tt>thaw() == map</tt>, unless \c map is modified concurrently.
+	 *     - <tt>bucket_count() == map.bucket_count()</tt>
+	 */
+	explicit frozen_hash_map(const map_type &map)
+	: frozen_hash_map(std::atomic_load(&map.current_buckets)) {}
+
+	/** \brief Creates a mutable hash_map with the elements of this map.
+	 *
+	 * \return A hash_map with the same elements, bucket count, hash function,
+	 *     key comparator and allocator.
+	 *
+	 * \note The hash function is not called during this operation.
+	 */
+	map_type thaw() const {
+		map_type map(bucket_count(), hash, keycomp, allocator);
+		for(size_type n = 0; n < elements.size(); ++n) {
+			map.insert_hashed(hashes[n], elements[n]);
+		}
+		return map;
+	}
+///\}
+
+
+
+/// \name Observers
+///\{
+	/// \brief Returns the allocator.
+	allocator_type get_allocator() const {
+		return allocator;
+	}
+
+	/// \brief Returns the hash function.
+	hasher hash_function() const {
+		return hash;
+	}
+
+	/// \brief Returns the key comparison function.
+	key_equal key_eq() const {
+		return keycomp;
+	}
+///\}
+
+
+
+/// \name Iterators
+///\{
+	/// \brief Returns an iterator to the first element.
+	const_iterator begin() const noexcept {
+		return elements.data();
+	}
+
+	/// \brief Returns an iterator to the first element.
+	const_iterator cbegin() const noexcept {
+		return begin();
+	}
+
+	/// \brief Returns an iterator past the last element.
+	const_iterator end() const noexcept {
+		return elements.data() + elements.size();
+	}
+
+	/// \brief Returns an iterator past the last element.
+	const_iterator cend() const noexcept {
+		return end();
+	}
+///\}
+
+
+
+/// \name Capacity
+///\{
+	/// \brief Checks whether the container is empty.
+	bool empty() const noexcept {
+		return elements.empty();
+	}
+
+	/// \brief Returns the number of elements.
+	size_type size() const noexcept {
+		return elements.size();
+	}
+///\}
+
+
+
+/// \name Lookup
+///\{
+	/** \brief Accesses an element by its key, with bounds-checking.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if no element with the key \c key is
+	 *     stored in the map.
+	 *
+	 * \return A constant reference to the element requested.
+	 */
+	const mapped_type &at(const key_type &key) const {
+		const_iterator it = find(key);
+		if (it != end()) {
+			return it->second;
+		}
+		else {
+			throw std::out_of_range("element not found in frozen_hash_map");
+		}
+	}
+
+	/** \brief Counts the number of elements with a specific key.
+	 *
+	 * \param key The key of the element to count.
+	 *
+	 * \return The number of elements with the key \c key. (0 or 1)
+	 */
+	size_type count(const key_type &key) const {
+		return (find(key) != end())
+			? 1
+			: 0;
+	}
+
+	/** \brief Finds an element by its key.
+	 *
+	 * \param key The key of the element to fetch.
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	const_iterator find(const key_type &key) const {
+		return find(key, hash(key));
+	}
+
+	/** \brief Finds an element by its key and precomputed hash.
+	 *
+	 * \param key The key of the element to fetch.
+	 * \param key_hash The hash of \c key.
+	 *
+	 * \pre
+	 *     - <tt>key_hash == hash_function()(key)</tt>
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	const_iterator find(const key_type &key, hash_type key_hash) const {
+		assert( hash(key) == key_hash
+			&& "key_hash must be the hash of the key!" );
+
+		const size_type b_id = bucket_index(static_cast<std::size_t>(key_hash));
+		const size_type last = offsets[b_id + 1];
+		for(size_type n = offsets[b_id]; n != last; ++n) {
+			if (hashes[n] == key_hash && keycomp(elements[n].first, key)) {
+				return elements.data() + n;
+			}
+		}
+		return end();
+	}
+
+	/** \brief Finds an element by its key and precomputed hash.
+	 *
+	 * \param key The key of the element to fetch and its hash.
+	 *
+	 * \return The same as <tt>find(key.key())</tt>.
+	 */
+	const_iterator find(const hashed_key &key) const {
+		return find(key.key(), key.hash());
+	}
+///\}
+
+
+
+/// \name Bucket interface
+///\{
+	/** \brief Returns a bucket local iterator to the beginning of a bucket.
+	 *
+	 * \pre
+	 *     - <tt>bucket_index < bucket_count()</tt>
+	 */
+	const_local_iterator begin(size_type bucket_index) const {
+		return elements.data() + offsets[bucket_index];
+	}
+
+	/** \brief Returns a bucket local iterator to the beginning of a bucket.
+	 *
+	 * \pre
+	 *     - <tt>bucket_index < bucket_count()</tt>
+	 */
+	const_local_iterator cbegin(size_type bucket_index) const {
+		return begin(bucket_index);
+	}
+
+	/** \brief Returns a bucket local iterator to the end of a bucket.
+	 *
+	 * \pre
+	 *     - <tt>bucket_index < bucket_count()</tt>
+	 */
+	const_local_iterator end(size_type bucket_index) const {
+		return elements.data() + offsets[bucket_index + 1];
+	}
+
+	/** \brief Returns a bucket local iterator to the end of a bucket.
+	 *
+	 * \pre
+	 *     - <tt>bucket_index < bucket_count()</tt>
+	 */
+	const_local_iterator cend(size_type bucket_index) const {
+		return end(bucket_index);
+	}
+
+	/// \brief Returns the number of buckets.
+	size_type bucket_count() const noexcept {
+		return offsets.size() - 1;
+	}
+
+	/** \brief Returns the number of elements in a specific bucket.
+	 *
+	 * \pre
+	 *     - <tt>bucket_index < bucket_count()</tt>
+	 */
+	size_type bucket_size(size_type bucket_index) const {
+		return offsets[bucket_index + 1] - offsets[bucket_index];
+	}
+
+	/** \brief Returns the bucket index for a specific key.
+	 *
+	 * \param key The key for which to retrieve the according bucket index.
+	 *
+	 * \return The index of the bucket that holds an element with the key
+	 *     \c key, if there is one.
+	 */
+	size_type bucket(const key_type &key) const {
+		return bucket_index(static_cast<std::size_t>(hash(key)));
+	}
+///\}
+
+
+
+/// \internal \name Internals
+///\{ \internal
+private:
+	/// \internal \brief A smart pointer to a bucket list of the hash_map.
+	typedef typename map_type::bucket_list_pointer bucket_list_pointer;
+
+	/// \internal \brief The smart pointer type used to hold nodes.
+	typedef typename map_type::node_pointer node_pointer;
+
+	/// \internal \brief Maps hashes to buckets.
+	typedef typename traits_type::bucket_index_policy bucket_index_policy;
+
+	/// \internal \brief An allocator for the arrays of offsets and hashes.
+	template<typename U>
+	using rebound_allocator
+		= typename std::allocator_traits<allocator_type>::template rebind_alloc<U>;
+
+	/** \internal \brief Copies the elements of a bucket list.
+	 *
+	 * Walks every bucket once, so every bucket is a consistent snapshot even
+	 * if the \c hash_map is modified concurrently.
+	 *
+	 * \param buckets The bucket list to copy.
+	 */
+	explicit frozen_hash_map(const bucket_list_pointer &buckets)
+	: bucket_index(buckets->bucket_index)
+	, hash(buckets->hash)
+	, keycomp(buckets->keycomp)
+	, allocator(buckets->allocator)
+	, offsets(allocator)
+	, hashes(allocator)
+	, elements(allocator) {
+		offsets.reserve(buckets->bucket_count + 1);
+		hashes.reserve(buckets->node_count);
+		elements.reserve(buckets->node_count);
+
+		for(size_type b_id = 0; b_id < buckets->bucket_count; ++b_id) {
+			offsets.push_back(elements.size());
+			if (!buckets->is_constructed(b_id)) {
+				continue; // never used, so empty
+			}
+
+			node_pointer cur = buckets->buckets[b_id].sentinel;
+			while( !(cur = cur->next_live())->is_sentinel() ) {
+				hashes.push_back(cur->key_hash);
+				elements.push_back(cur->data());
+			}
+		}
+		offsets.push_back(elements.size());
+	}
+
+	/// \internal \brief Maps hashes to buckets like the hash_map did.
+	bucket_index_policy bucket_index;
+
+	/// \internal \brief The hash function.
+	hasher hash;
+
+	/// \internal \brief The key comparator.
+	key_equal keycomp;
+
+	/// \internal \brief The allocator.
+	allocator_type allocator;
+
+	/// \internal \brief The index of the first element of every bucket,
+	///     followed by the number of elements.
+	std::vector<size_type, rebound_allocator<size_type>> offsets;
+
+	/// \internal \brief The hash of every element.
+	std::vector<hash_type, rebound_allocator<hash_type>> hashes;
+
+	/// \internal \brief The elements, sorted by bucket.
+	std::vector<value_type, allocator_type> elements;
+///\}
+};
+
+#endif // FROZEN_HASH_MAP_HPP_INCLUDED
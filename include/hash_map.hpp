@@ -7,7 +7,10 @@
 #define HASH_MAP_HPP_INCLUDED
 
 #include <cassert>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 
 #include <algorithm>
 #include <atomic>
@@ -15,10 +18,489 @@
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <new>
 #include <stdexcept>
 #include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+/** \brief Maps hashes to buckets by the remainder of a division.
+ *
+ * Works with any number of buckets and does not depend on the quality of the
+ * hash function, but needs an integer division on every access. This is the
+ * default \ref hash_map_traits::bucket_index_policy.
+ */
+struct modulo_bucket_index {
+	/** \brief Prepares the mapping for a number of buckets.
+	 *
+	 * \param bucket_count The number of buckets requested.
+	 *
+	 * \pre
+	 *     - <tt>0 < bucket_count</tt>
+	 */
+	explicit modulo_bucket_index(std::size_t bucket_count) noexcept
+	: count(bucket_count) {}
+
+	/** \brief Returns the number of buckets.
+	 *
+	 * \return The number of buckets requested.
+	 */
+	std::size_t bucket_count() const noexcept {
+		return count;
+	}
+
+	/** \brief Maps a hash to a bucket.
+	 *
+	 * \param hash The hash of a key.
+	 *
+	 * \return The index of the bucket for \c hash.
+	 */
+	std::size_t operator()(std::size_t hash) const noexcept {
+		return hash % count;
+	}
+
+private:
+	/// \internal \brief The number of buckets.
+	std::size_t count;
+};
+
+/** \internal \brief Provides the hash mixer for bucket index policies.
+ *
+ * Policies that only use some of the bits of a hash would map the results of
+ * weak hash functions, like the identity function \c std::hash uses for
+ * integers, to few buckets. Mixing spreads every bit of the hash over all
+ * bits of the result.
+ */
+struct mixing_bucket_index {
+protected:
+	/** \internal \brief Mixes the bits of a hash.
+	 *
+	 * This is the finalizer of MurmurHash3.
+	 *
+	 * \param hash The hash to mix.
+	 *
+	 * \return The mixed hash.
+	 */
+	static std::uint64_t mix(std::uint64_t hash) noexcept {
+		hash ^= hash >> 33;
+		hash *= UINT64_C(0xff51afd7ed558ccd);
+		hash ^= hash >> 33;
+		hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+		hash ^= hash >> 33;
+		return hash;
+	}
+};
+
+/** \brief Maps hashes to buckets by masking their mixed bits.
+ *
+ * The number of buckets is rounded up to a power of two, so the bucket can be
+ * determined by a bit mask instead of a division. Hashes are mixed before, so
+ * weak hash functions do not cluster in few buckets.
+ *
+ * \note With this policy, \ref hash_map::bucket_count() may be larger than
+ *     the number of buckets requested.
+ */
+struct mask_bucket_index: mixing_bucket_index {
+	/** \brief Prepares the mapping for a number of buckets.
+	 *
+	 * \param bucket_count The number of buckets requested.
+	 *
+	 * \pre
+	 *     - <tt>0 < bucket_count</tt>
+	 */
+	explicit mask_bucket_index(std::size_t bucket_count) noexcept
+	: mask(0) {
+		while(mask < bucket_count - 1) {
+			mask = (mask << 1) | 1;
+		}
+	}
+
+	/** \brief Returns the number of buckets.
+	 *
+	 * \return The smallest power of two not less than the number of buckets
+	 *     requested.
+	 */
+	std::size_t bucket_count() const noexcept {
+		return mask + 1;
+	}
+
+	/** \brief Maps a hash to a bucket.
+	 *
+	 * \param hash The hash of a key.
+	 *
+	 * \return The index of the bucket for \c hash.
+	 */
+	std::size_t operator()(std::size_t hash) const noexcept {
+		return static_cast<std::size_t>(mix(hash)) & mask;
+	}
+
+private:
+	/// \internal \brief The mask to apply to mixed hashes.
+	std::size_t mask;
+};
+
+/** \brief Maps hashes to buckets by multiplying their mixed bits.
+ *
+ * Uses the upper half of the product of the mixed hash and the number of
+ * buckets (Lemire's "fastrange"), which works with any number of buckets and
+ * needs a multiplication instead of a division.
+ */
+struct fastrange_bucket_index: mixing_bucket_index {
+	/** \brief Prepares the mapping for a number of buckets.
+	 *
+	 * \param bucket_count The number of buckets requested.
+	 *
+	 * \pre
+	 *     - <tt>0 < bucket_count</tt>
+	 */
+	explicit fastrange_bucket_index(std::size_t bucket_count) noexcept
+	: count(bucket_count) {}
+
+	/** \brief Returns the number of buckets.
+	 *
+	 * \return The number of buckets requested.
+	 */
+	std::size_t bucket_count() const noexcept {
+		return count;
+	}
+
+	/** \brief Maps a hash to a bucket.
+	 *
+	 * \param hash The hash of a key.
+	 *
+	 * \return The index of the bucket for \c hash.
+	 */
+	std::size_t operator()(std::size_t hash) const noexcept {
+#if defined(__SIZEOF_INT128__)
+		__extension__ typedef unsigned __int128 uint128;
+		return static_cast<std::size_t>(
+			(uint128(mix(hash)) * count) >> 64
+		);
+#else
+		// the upper 32 bits of the mixed hash are good enough for bucket
+		// counts below 2^32.
+		return static_cast<std::size_t>(
+			(mix(hash) >> 32) * std::uint64_t(count) >> 32
+		);
+#endif
+	}
+
+private:
+	/// \internal \brief The number of buckets.
+	std::size_t count;
+};
+
+/** \brief Maps hashes to buckets by a remainder computed by multiplication.
+ *
+ * Computes the same remainder as \ref modulo_bucket_index, but multiplies by a
+ * precomputed reciprocal of the number of buckets (Lemire's "fastmod")
+ * instead of dividing. Prime bucket counts keep their benefits.
+ *
+ * \note The remainder is computed for a 32 bit hash, so 64 bit hashes are
+ *     folded, and the number of buckets must be less than 2^32. Without
+ *     compiler support for 128 bit integers, this falls back to a division.
+ */
+struct reciprocal_bucket_index {
+	/** \brief Prepares the mapping for a number of buckets.
+	 *
+	 * \param bucket_count The number of buckets requested.
+	 *
+	 * \pre
+	 *     - <tt>0 < bucket_count</tt>
+	 *     - <tt>bucket_count <= 2^32</tt>
+	 */
+	explicit reciprocal_bucket_index(std::size_t bucket_count) noexcept
+	: count(bucket_count)
+	, reciprocal(UINT64_C(0xffffffffffffffff) / bucket_count + 1) {
+		assert( std::uint64_t(bucket_count) <= UINT64_C(0xffffffff) + 1
+			&& "bucket count must be representable in 32 bits" );
+	}
+
+	/** \brief Returns the number of buckets.
+	 *
+	 * \return The number of buckets requested.
+	 */
+	std::size_t bucket_count() const noexcept {
+		return count;
+	}
+
+	/** \brief Maps a hash to a bucket.
+	 *
+	 * \param hash The hash of a key.
+	 *
+	 * \return The index of the bucket for \c hash.
+	 */
+	std::size_t operator()(std::size_t hash) const noexcept {
+		const std::uint32_t folded = static_cast<std::uint32_t>(
+			std::uint64_t(hash) ^ (std::uint64_t(hash) >> 32)
+		);
+#if defined(__SIZEOF_INT128__)
+		__extension__ typedef unsigned __int128 uint128;
+		return static_cast<std::size_t>(
+			(uint128(reciprocal * folded) * count) >> 64
+		);
+#else
+		return folded % count;
+#endif
+	}
+
+private:
+	/// \internal \brief The number of buckets.
+	std::size_t count;
+
+	/// \internal \brief The fixed point reciprocal of \ref count.
+	std::uint64_t reciprocal;
+};
+
+/** \brief Maps hashes to a number of buckets fixed at compile time.
+ *
+ * Takes the remainder of a division like \ref modulo_bucket_index, but the
+ * divisor is a constant, so the compiler replaces the division by a
+ * multiplication. The number of buckets requested at runtime is ignored,
+ * which also makes \ref hash_map::rehash() do nothing.
+ *
+ * \tparam BucketCount The number of buckets.
+ */
+template<std::size_t BucketCount>
+struct static_bucket_index {
+	static_assert( 0 < BucketCount,
+		"can not have a hash_map without buckets" );
+
+	/** \brief Prepares the mapping.
+	 *
+	 * \param bucket_count Ignored.
+	 */
+	explicit static_bucket_index(std::size_t bucket_count) noexcept {
+		((void)bucket_count); // unused, suppress warning
+	}
+
+	/** \brief Returns the number of buckets.
+	 *
+	 * \return \c BucketCount
+	 */
+	std::size_t bucket_count() const noexcept {
+		return BucketCount;
+	}
+
+	/** \brief Maps a hash to a bucket.
+	 *
+	 * \param hash The hash of a key.
+	 *
+	 * \return The index of the bucket for \c hash.
+	 */
+	std::size_t operator()(std::size_t hash) const noexcept {
+		return hash % BucketCount;
+	}
+};
+
+/** \brief Destroys bucket lists replaced in a hash_map right away.
+ *
+ * This is the default \ref hash_map_traits::reclamation_policy: A bucket list
+ * replaced by \c rehash() or \c clear(), or left by the destruction of the
+ * \c hash_map, is destroyed along with its elements by whichever thread
+ * releases it last. See \c background_reclamation.hpp for an alternative.
+ */
+struct immediate_reclamation {
+	/** \brief Releases an object.
+	 *
+	 * \param object The object to release.
+	 * \param bytes The approximate number of bytes held by \c object.
+	 */
+	static void retire(std::shared_ptr<void> object, std::size_t bytes) noexcept {
+		(void)object;
+		(void)bytes;
+	}
+};
+
+/** \brief The compile time configuration of a hash_map.
+ *
+ * To change individual settings, derive from this struct and hide the
+ * members to be changed:
+ *
+ * \code
+ * struct my_traits: hash_map_traits {
+ *     static constexpr bool offline_reorder = true;
+ * };
+ *
+ * hash_map<int, int, std::hash<int>, std::equal_to<int>,
+ *     std::allocator<std::pair<const int, int>>, my_traits> hm(16);
+ * \endcode
+ */
+struct hash_map_traits {
+	/** \brief Whether elements keep track of how often they are found, so
+	 *     they can be reordered offline.
+	 *
+	 * If enabled, \ref hash_map::reorganize() and \ref hash_map::rehash()
+	 * will move frequently found elements towards the front of their buckets,
+	 * where subsequent lookups will reach them with fewer hops.
+	 *
+	 * \note Elements are only reordered by these two functions, which are
+	 *     not thread safe. Lookups and insertions never move elements.
+	 */
+	static constexpr bool offline_reorder = false;
+
+	/** \brief The binary logarithm of the sampling rate for lookup hits.
+	 *
+	 * Only one in <tt>2^hit_sample_shift</tt> hits is counted, so frequently
+	 * found elements are not permanently contended by counter updates.
+	 * Ignored unless \ref offline_reorder is enabled.
+	 */
+	static constexpr unsigned hit_sample_shift = 4;
+
+	/** \brief The bucket size at which a bucket gets a sorted index.
+	 *
+	 * Long buckets are the result of poor hash functions or adversarial keys.
+	 * To keep lookups in such buckets fast, they get an index of their nodes
+	 * sorted by hash, so nodes with a specific hash can be found by binary
+	 * search instead of traversing the whole bucket. A value of \c 0 disables
+	 * indexing.
+	 *
+	 * \note Keys with equal hashes can only be told apart by comparing them,
+	 *     so an index can not help against different keys with the exact same
+	 *     hash.
+	 */
+	static constexpr std::size_t index_threshold = 64;
+
+	/** \brief The bucket size below which a bucket loses its sorted index.
+	 *
+	 * Should be well below \ref index_threshold, so buckets do not keep
+	 * building and dropping indices when their size changes just a little.
+	 */
+	static constexpr std::size_t unindex_threshold = 16;
+
+	/** \brief Whether buckets embed storage for their first element.
+	 *
+	 * At healthy load factors most buckets hold no more than one element. If
+	 * enabled, each bucket carries storage for one node, which is used for
+	 * the first element inserted into the bucket while the storage is free,
+	 * so finding that element does not need to access a separate heap
+	 * allocation. Other elements are allocated as usual.
+	 *
+	 * \note This increases the size of each bucket by about the size of a
+	 *     node, and \ref hash_map::rehash() copies elements stored inside
+	 *     buckets, so \c value_type must be copy constructible and iterators
+	 *     to these elements are invalidated.
+	 */
+	static constexpr bool inline_first_node = false;
+
+	/** \brief Whether elements are stored apart from their nodes.
+	 *
+	 * By default, each node stores its element, so walking a bucket of
+	 * large elements touches a lot of memory which is not needed to find the
+	 * right node. If enabled, nodes only hold their link, the hash of their
+	 * key and a pointer to their element, which is allocated separately.
+	 * Nodes with a different hash are skipped without touching their element,
+	 * so walking a bucket only touches small nodes, at the cost of another
+	 * allocation per element and another cache miss for the element found.
+	 */
+	static constexpr bool out_of_line_values = false;
+
+	/** \brief Whether buckets are constructed on first use.
+	 *
+	 * By default, creating a bucket list constructs all of its buckets, so
+	 * creating, clearing and rehashing a map with many buckets writes all of
+	 * their memory before a single element is inserted. If enabled, the
+	 * buckets are placed into zero-filled memory obtained by \c std::calloc
+	 * and each bucket is constructed by the first operation that accesses
+	 * it. Buckets never accessed are skipped when iterating, copying,
+	 * rehashing and destroying the map, and the operating system does not
+	 * need to provide their pages until they are touched.
+	 *
+	 * \note The memory of the buckets is not obtained from the allocator of
+	 *     the \c hash_map, and accessing a bucket checks whether it has been
+	 *     constructed.
+	 */
+	static constexpr bool lazy_buckets = false;
+
+	/** \brief Whether clear() leaves destroying the elements to later calls.
+	 *
+	 * By default, the elements are destroyed once the bucket list replaced by
+	 * \c clear() is released, which is done by the last thread using it and
+	 * takes time proportional to the number of elements and buckets. If
+	 * enabled, the replaced bucket list is handed to the new one instead.
+	 * Once no operation started before the \c clear() is in progress
+	 * anymore, every insertion and erasure destroys a few of its buckets,
+	 * along with their elements. Combined with \c lazy_buckets, \c clear()
+	 * takes constant time.
+	 *
+	 * An operation counts as in progress while it holds a reference to the
+	 * replaced bucket list. \c at() and \c operator[] hold it until they
+	 * have taken the reference to the element they return. Iterators and
+	 * references do not hold it, so, as without this option, they must not
+	 * be used after a concurrent \c clear().
+	 *
+	 * \note Elements remain alive for a while after \c clear() returns.
+	 */
+	static constexpr bool incremental_clear = false;
+
+	/** \brief The minimum alignment of buckets in bytes.
+	 *
+	 * Buckets are small, so several of them share a cache line by default.
+	 * Insertions and erasures modify their bucket, which slows down all
+	 * threads accessing the other buckets on the same cache line. Setting
+	 * this to the size of a cache line (typically \c 64) gives every bucket
+	 * a cache line of its own at the cost of memory. Must be a power of two
+	 * or \c 0, which uses the natural alignment of buckets.
+	 */
+	static constexpr std::size_t bucket_alignment = 0;
+
+	/** \brief The number of threads destroying a large bucket list.
+	 *
+	 * Destroying a bucket list with many buckets and elements walks and
+	 * frees all of them on a single thread by default. With a value above
+	 * \c 1, lists with at least 65536 buckets and elements are split into
+	 * this many disjoint ranges of buckets, and all but one of them are
+	 * destroyed by additional threads started for this purpose. Combined
+	 * with \c background_reclamation, the thread releasing the map does not
+	 * wait for any of them.
+	 *
+	 * \note The allocator must support destroying and deallocating from
+	 *     several threads at once.
+	 */
+	static constexpr unsigned destruction_threads = 1;
+
+	/** \brief How many buckets ahead traversals prefetch.
+	 *
+	 * Iterating over all elements and \ref hash_map::rehash() prefetch the
+	 * first node of the bucket this many buckets ahead, so the cache misses
+	 * of consecutive buckets overlap instead of being taken one after
+	 * another. A value of \c 0 disables prefetching.
+	 *
+	 * \note The nodes within a bucket can not be prefetched ahead: The
+	 *     address of a node is only known once its predecessor has been
+	 *     loaded, and lookups check it for a deletion marker right away, so
+	 *     prefetching it does not make lookups in long chains any faster.
+	 */
+	static constexpr unsigned prefetch_distance = 4;
+
+	/** \brief How hashes are mapped to buckets.
+	 *
+	 * One of \ref modulo_bucket_index, \ref mask_bucket_index,
+	 * \ref fastrange_bucket_index, \ref reciprocal_bucket_index,
+	 * and \ref static_bucket_index, or any type with the same interface.
+	 */
+	typedef modulo_bucket_index bucket_index_policy;
+
+	/** \brief How replaced bucket lists are destroyed.
+	 *
+	 * Either \ref immediate_reclamation or \c background_reclamation from
+	 * \c background_reclamation.hpp, or any type with a static
+	 * <tt>retire(std::shared_ptr<void> object, std::size_t bytes)</tt>
+	 * function that releases \c object eventually.
+	 */
+	typedef immediate_reclamation reclamation_policy;
+};
+
+template<
+	typename Key,
+	typename T,
+	typename Hash,
+	typename KeyEqual,
+	typename Allocator,
+	typename Traits
+>
+class frozen_hash_map;
 
 /** \brief A concurrency friendly hash map.
  * \nosubgrouping
@@ -28,19 +510,23 @@
  * \tparam Hash The type of the hash function.
  * \tparam KeyEqual The type of the key equality comparator.
  * \tparam Allocator The type of the allocator.
+ * \tparam Traits The compile time configuration. See \ref hash_map_traits.
  */
 template<
 	typename Key,
 	typename T,
 	typename Hash = std::hash<Key>,
 	typename KeyEqual = std::equal_to<Key>,
-	typename Allocator = std::allocator< std::pair<const Key, T> >
+	typename Allocator = std::allocator< std::pair<const Key, T> >,
+	typename Traits = hash_map_traits
 >
 struct hash_map {
 private:
 /// \name Member Types
 ///\{
 	struct node;
+	struct data_node;
+	struct sentinel_node;
 	/// \internal \brief The smart pointer type used to hold nodes.
 	typedef typename node::pointer node_pointer;
 
@@ -48,6 +534,12 @@ private:
 	/// \internal \brief A smart pointer to a bucket list.
 	typedef std::shared_ptr<fixed_size_bucket_list> bucket_list_pointer;
 
+	/// \internal \brief Maps hashes to buckets.
+	typedef typename Traits::bucket_index_policy bucket_index_policy;
+
+	/// \internal \brief Destroys replaced bucket lists.
+	typedef typename Traits::reclamation_policy reclamation_policy;
+
 public:
 	/// \brief The type used for element counts and indices.
 	typedef std::size_t                 size_type;
@@ -73,6 +565,9 @@ public:
 	/// \brief The type of the allocator.
 	typedef Allocator                   allocator_type;
 
+	/// \brief The compile time configuration.
+	typedef Traits                      traits_type;
+
 	/// \brief The return type of the hash function.
 	typedef std::result_of_t<Hash(Key)> hash_type;
 
@@ -196,14 +691,16 @@ public:
 		 */
 		iterator_impl &operator++() {
 			assert( pnode && "cannot increment an end iterator" );
-			std::shared_ptr<node> cur = std::atomic_load(&pnode->next);
+			std::shared_ptr<node> cur = pnode->next_live();
 			if (!IsLocal) {
 				while(cur && cur->is_sentinel()) {
+					prefetch_bucket_ahead(*cur);
+
 					// returns the next bucket or nullptr if this was the last.
 					const auto *bucket = cur->next_bucket();
 					cur = (bucket)
-						? std::atomic_load(&bucket->sentinel->next) // first data
-							//  node or the sentinel itself if the bucket is empty
+						? bucket->sentinel->next_live() // first data node or
+							// the sentinel itself if the bucket is empty
 						: nullptr; // no more bucket
 				}
 			}
@@ -322,6 +819,54 @@ public:
 
 	/// \brief The constant local iterator type for the hash_map.
 	typedef iterator_impl<const value_type, true , true > const_local_iterator;
+
+	/** \brief A key together with its precomputed hash.
+	 *
+	 * Passing a \c hashed_key instead of a key spares the \c hash_map from
+	 * calculating the hash itself. This pays off if the same key is used with
+	 * several operations or several maps, or if its hash is already known.
+	 *
+	 * \note A \c hashed_key refers to its key and does not copy it, so the
+	 *     key must outlive the \c hashed_key.
+	 */
+	class hashed_key {
+	public:
+		/** \brief Creates a hashed key from a key and its hash.
+		 *
+		 * \param key The key.
+		 * \param key_hash The hash of \c key.
+		 *
+		 * \pre
+		 *     - \c key_hash is the hash the hash function of the maps this
+		 *         \c hashed_key is used with calculates for \c key.
+		 */
+		hashed_key(const key_type &key, hash_type key_hash) noexcept
+		: key_ptr(&key)
+		, key_hash(key_hash) {}
+
+		/** \brief Returns the key.
+		 *
+		 * \return The key.
+		 */
+		const key_type &key() const noexcept {
+			return *key_ptr;
+		}
+
+		/** \brief Returns the hash of the key.
+		 *
+		 * \return The hash of the key.
+		 */
+		hash_type hash() const noexcept {
+			return key_hash;
+		}
+
+	private:
+		/// \internal \brief The key.
+		const key_type *key_ptr;
+
+		/// \internal \brief The hash of the key.
+		hash_type key_hash;
+	};
 ///\}
 
 
@@ -366,34 +911,48 @@ public:
 		// copy node bucket by bucket
 		const size_type bucket_count = current_buckets->bucket_count;
 		for(size_type b_id=0; b_id < bucket_count; ++b_id) {
-			const node_pointer sentinel
-				= current_buckets->buckets[b_id].sentinel;
+			if (!other.current_buckets->is_constructed(b_id)) {
+				continue; // never used, so empty
+			}
+
+			const typename fixed_size_bucket_list::bucket &bucket
+				= current_buckets->bucket_at(b_id);
+			const node_pointer sentinel = bucket.sentinel;
 
 			const_local_iterator begin = other.cbegin(b_id);
 			const const_local_iterator end = other.cend(b_id);
 
 			node_pointer prev = sentinel;
 			while(begin != end) {
-				node_pointer new_node =
-					node::create_with_data(current_buckets->allocator, *begin);
+				node_pointer new_node = bucket.create_node(
+					current_buckets->allocator, begin.pnode->key_hash, *begin
+				);
 				prev->next = new_node;
+				update_first_hint(*prev, new_node);
 				prev = new_node;
+				++bucket.size;
 				// buckets list ends in nullptr, but buckets destructor can
 				// cope with that, should an exception be thrown.
 
 				++begin;
 			}
 			prev->next = sentinel; // close the circle
+			bucket.update_index(current_buckets->allocator);
 		}
 		current_buckets->node_count = other.size();
 	}
 
 	/** \brief Destructs the hash_map.
+	 *
+	 * The elements are destroyed as determined by
+	 * \c traits_type::reclamation_policy.
 	 *
 	 * \post
 	 *     - All iterators are invalidated.
 	 */
-	~hash_map() = default;
+	~hash_map() {
+		retire_bucket_list(std::move(current_buckets));
+	}
 
 	/** \brief Assigns all elements from another hash_map to this one.
 	 *
@@ -534,20 +1093,30 @@ public:
 	 *     - <tt>0 < new_bucket_count</tt>
 	 *
 	 * \post
-	 *     - <tt>bucket_count() == new_bucket_count</tt>
+	 *     - <tt>bucket_count() == new_bucket_count</tt>, unless the
+	 *         \c traits_type::bucket_index_policy rounds bucket counts.
 	 *     - <tt>after_rehash == before_rehash</tt>
 	 *
 	 * \note If any allocations fail in the process, the value of the hash_map
 	 *     will be unchanged.
 	 *
-	 * \note If the hash function throws during this operation, the behavior is
-	 *     undefined.
+	 * \note The hash function is not called during this operation, as the
+	 *     hashes of all keys are stored along with the elements.
+	 *
+	 * \note If \c traits_type::offline_reorder is enabled, this also performs
+	 *     the work of \ref reorganize() on the rehashed elements.
+	 *
+	 * \note If \c traits_type::inline_first_node is enabled, elements stored
+	 *     inside buckets are copied and iterators to them are invalidated.
 	 */
 	void rehash(size_type new_bucket_count) {
 		assert( 0 < new_bucket_count
 			&& "can not rehash without buckets" );
 
-		if (new_bucket_count == current_buckets->bucket_count) {
+		if (
+			bucket_index_policy(new_bucket_count).bucket_count()
+				== current_buckets->bucket_count
+		) {
 			// nothing to do
 			return;
 		}
@@ -560,64 +1129,154 @@ public:
 				current_buckets->allocator
 			);
 
+		copy_inline_nodes(
+			std::integral_constant<bool, Traits::inline_first_node>(),
+			*current_buckets, *new_buckets
+		);
+
 		// if we have reached this point, nothing bad will be happening.
 		// all memory required is allocated already, the rest is pointer
 		// manipulation and hash calculation / key comparison.
 
 		auto begin = current_buckets->buckets;
 		const auto end = begin + current_buckets->bucket_count;
-		while (begin != end) {
-			node_pointer cur = begin->sentinel->next;
+		for(; begin != end; ++begin) {
+			const size_type b_id = size_type(begin - current_buckets->buckets);
+			if (!current_buckets->is_constructed(b_id)) {
+				continue; // never used, so empty
+			}
+			if (
+				Traits::prefetch_distance < size_type(end - begin) &&
+				current_buckets->is_constructed(b_id + Traits::prefetch_distance)
+			) {
+				prefetch(begin[Traits::prefetch_distance].sentinel->next.get());
+			}
+
+			node_pointer cur = begin->sentinel->next_live();
 
 			// unlink the list from the old bucket.
 			begin->sentinel->next = begin->sentinel;
 
 			// for all data nodes ...
 			while(!cur->is_sentinel()) {
-				node_pointer next = cur->next;
+				// skips deleted nodes that have not been unlinked yet
+				node_pointer next = cur->next_live();
 
-				// find target bucket and insert node.
-				// rehashing likely changes the node sorting anyway, so we
-				// won't put extra effort into preserving the node order, but
-				// just insert in the beginning.
-				const auto &target_bucket = new_buckets
-					->bucket_for_key(cur->data().first);
+				if (Traits::prefetch_distance && !next->is_sentinel()) {
+					prefetch(&new_buckets->bucket_for_hash(next->key_hash));
+				}
 
-				cur->next = target_bucket.sentinel->next;
-				target_bucket.sentinel->next = cur;
-				++new_buckets->node_count;
+				if (!begin->stores(cur.get())) { // copied already otherwise
+					new_buckets->link_front(cur);
+				}
 
 				cur = next;
 				assert( cur
 					&& "must not encounter null node during rehashing!");
 			}
+		}
 
-			++begin;
+		const auto new_end = new_buckets->buckets + new_buckets->bucket_count;
+		for(auto b=new_buckets->buckets; b != new_end; ++b) {
+			if (!new_buckets->is_constructed(size_type(b - new_buckets->buckets))) {
+				continue; // received no nodes
+			}
+			if (Traits::offline_reorder) {
+				// all nodes have just been prepended to their new buckets, so
+				// this is the time to establish a useful order.
+				b->reorder_by_hits(new_buckets->allocator);
+			}
+			else {
+				b->update_index(new_buckets->allocator);
+			}
 		}
 
-		new decltype(current_buckets)(current_buckets); // leak
-		current_buckets = new_buckets;
+		bucket_list_pointer old_buckets = std::move(current_buckets);
+		current_buckets = std::move(new_buckets);
+		retire_bucket_list(std::move(old_buckets));
 	}
-///\}
 
-
-
-/// \name Observers
-///\{
-	/** \brief Returns the allocator.
+	/** \brief Copies the elements into an immutable, read optimized map.
 	 *
-	 * \return The allocator used by this hash_map.
+	 * The \ref frozen_hash_map stores the elements in contiguous arrays,
+	 * sorted by bucket, and looks them up without atomic operations or
+	 * reference counting. Use \ref frozen_hash_map::thaw() to get a mutable
+	 * \c hash_map back.
+	 *
+	 * \return A \ref frozen_hash_map with the elements of this hash_map.
+	 *
+	 * \note This function requires <tt>frozen_hash_map.hpp</tt>.
+	 *
+	 * \note Elements inserted or erased concurrently may or may not be
+	 *     part of the result.
 	 */
-	allocator_type get_allocator() const {
-		return current_buckets->allocator;
+	frozen_hash_map<Key, T, Hash, KeyEqual, Allocator, Traits> freeze() const {
+		return frozen_hash_map<Key, T, Hash, KeyEqual, Allocator, Traits>(*this);
 	}
 
-	/** \brief Returns the hash function.
+	/** \brief Moves frequently found elements to the front of their buckets.
 	 *
-	 * \return The hash function used by this hash_map.
-	 */
-	hasher hash_function() const {
-		return current_buckets->hash;
+	 * Elements are sorted by the number of times they have been found by
+	 * lookups or rejected insertions since the last call to this function or
+	 * \ref rehash(), so the most frequently accessed elements can be found
+	 * with the fewest hops.
+	 *
+	 * \pre
+	 *     - <tt>traits_type::offline_reorder == true</tt>
+	 *
+	 * \post
+	 *     - <tt>after_reorganize == before_reorganize</tt>
+	 *     - All iterators are still valid, but the iteration order may have
+	 *         changed.
+	 *
+	 * \note This function is not thread safe.
+	 */
+	void reorganize() {
+		static_assert( Traits::offline_reorder,
+			"reorganize() requires offline_reorder" );
+
+		const auto end = current_buckets->buckets
+			+ current_buckets->bucket_count;
+		for(auto b=current_buckets->buckets; b != end; ++b) {
+			if (current_buckets->is_constructed(size_type(b - current_buckets->buckets))) {
+				b->reorder_by_hits(current_buckets->allocator);
+			}
+		}
+	}
+///\}
+
+
+
+/// \name Observers
+///\{
+	/** \brief Returns the allocator.
+	 *
+	 * \return The allocator used by this hash_map.
+	 */
+	allocator_type get_allocator() const {
+		return current_buckets->allocator;
+	}
+
+	/** \brief Returns the hash function.
+	 *
+	 * \return The hash function used by this hash_map.
+	 */
+	hasher hash_function() const {
+		return current_buckets->hash;
+	}
+
+	/** \brief Calculates the hash of a key.
+	 *
+	 * \param key The key to hash.
+	 *
+	 * \return A \ref hashed_key referring to \c key and its hash, which can
+	 *     be used with this \c hash_map and with every other \c hash_map with
+	 *     an equal hash function.
+	 *
+	 * \note The result refers to \c key, which must outlive it.
+	 */
+	hashed_key hash_key(const key_type &key) const {
+		return hashed_key(key, current_buckets->hash(key));
 	}
 
 	/** \brief Returns the key comparison function.
@@ -639,16 +1298,14 @@ public:
 	 */
 	iterator begin() {
 		typedef const typename fixed_size_bucket_list::bucket *bucket_pointer;
-		bucket_pointer
-			current_bucket = current_buckets->buckets;
-		const bucket_pointer
-			end_bucket = current_bucket + current_buckets->bucket_count;
-		while(current_bucket != end_bucket) {
-			node_pointer first = std::atomic_load(&current_bucket->sentinel->next);
+		bucket_pointer current_bucket
+			= current_buckets->constructed_from(current_buckets->buckets);
+		while(current_bucket) {
+			node_pointer first = current_bucket->sentinel->next_live();
 			if (!first->is_sentinel()) {
 				return iterator(first.get());
 			}
-			++current_bucket;
+			current_bucket = first->next_bucket();
 		}
 		return iterator(nullptr);
 	}
@@ -736,6 +1393,10 @@ public:
 ///\{
 /// \note These functions are thread safe.
 	/** \brief Clears the contents.
+	 *
+	 * Publishes a new, empty bucket list. If \c Traits::incremental_clear is
+	 * enabled, the elements are destroyed by later insertions and erasures
+	 * rather than all at once.
 	 *
 	 * \post
 	 *     - <tt>empty() == true</tt>
@@ -753,6 +1414,9 @@ public:
 			buckets->keycomp,
 			buckets->allocator
 		);
+		if (Traits::incremental_clear) {
+			new_buckets->retire(buckets);
+		}
 
 		// If the following operation fails, the hash_map has been resized or
 		// concurrently cleared. In either case there is no need to try again:
@@ -760,9 +1424,14 @@ public:
 		// a resize() is not thread safe, so the result of this operation is
 		// undefined - retaining the resized version is a sane option for
 		// implementing this UB.
-		std::atomic_compare_exchange_strong(
-			&current_buckets, &buckets, new_buckets
-		);
+		if (
+			std::atomic_compare_exchange_strong(
+				&current_buckets, &buckets, new_buckets
+			) &&
+			!Traits::incremental_clear
+		) {
+			retire_bucket_list(std::move(buckets));
+		}
 	}
 
 	/** \brief Inserts an element into the map.
@@ -791,50 +1460,33 @@ public:
 		assert( buckets
 			&& "can not work with an empty bucket list!" );
 
-		node_pointer new_node;
-		node_pointer prev, cur;
-		while(true) {
-			if (buckets->find(value.first, prev, cur)) {
-				return std::make_pair(false, iterator(cur.get()));
-			}
-			else {
-				assert( cur->is_sentinel()
-					&& "will only append to the end of a list!" );
-
-				if (!new_node) {
-					new_node = node::create_with_data(
-						buckets->allocator,
-						value
-					);
-				}
-
-				// configure the node for insertion at this place
-				new_node->next = cur;
+		return insert_hashed(buckets, buckets->hash(value.first), value);
+	}
 
-				// current situataion:
-				//
-				// ... --> prev --(expected)--> cur (= end of list)
-				//                               ^
-				//                 new_node -----+
-				//
-				// now attempt to relink prev->next to new_node, but ONLY
-				// if it is still pointing to cur; otherwise someone else
-				// beat us to it and we have to retry!
-				if (std::atomic_compare_exchange_weak(
-					// this invalidates cur, but we have no use for it after
-					// this call anyway; either we're done and don't need it,
-					// or we need to start the search again and don't need it.
-					&prev->next, &cur, new_node
-				)) {
-					++buckets->node_count;
-					return std::make_pair(true, iterator(new_node.get()));
-				}
+	/** \brief Inserts an element with a precomputed hash into the map.
+	 *
+	 * This function is equivalent to calling <tt>insert(value)</tt>, but
+	 * uses \c key_hash instead of calculating the hash of the key.
+	 *
+	 * \param key_hash The hash of the key of \c value.
+	 * \param value The value to insert into the map.
+	 *
+	 * \pre
+	 *     - <tt>key_hash == hash_function()(value.first)</tt>
+	 *
+	 * \return The same as <tt>insert(value)</tt>.
+	 */
+	std::pair<bool, iterator> insert_hashed(
+		hash_type key_hash,
+		const value_type &value
+	) {
+		bucket_list_pointer buckets = std::atomic_load(&current_buckets);
+		assert( buckets
+			&& "can not work with an empty bucket list!" );
+		assert( buckets->hash(value.first) == key_hash
+			&& "key_hash must be the hash of the key!" );
 
-				// someone beat us to it - tough luck; reset and try again ...
-				// ... in a moment
-				std::this_thread::yield();
-			}
-		}
+		return insert_hashed(buckets, key_hash, value);
 	}
 
 	/** \brief Inserts an element into the map.
@@ -880,10 +1532,11 @@ public:
 		assert( buckets
 			&& "can not work with an empty bucket list!" );
 
+		const hash_type key_hash = buckets->hash(key);
 		node_pointer new_node;
 		node_pointer prev, cur;
 		while(true) {
-			if (buckets->find(key, prev, cur)) {
+			if (buckets->find(key, key_hash, prev, cur)) {
 				cur->data().second = mapped;
 				return iterator(cur.get());
 			}
@@ -892,8 +1545,9 @@ public:
 					&& "will only append to the end of a list!" );
 
 				if (!new_node) {
-					new_node = node::create_with_data(
+					new_node = buckets->bucket_for_hash(key_hash).create_node(
 						buckets->allocator,
+						key_hash,
 						std::make_pair(key, mapped)
 					);
 				}
@@ -910,13 +1564,16 @@ public:
 				// now attempt to relink prev->next to new_node, but ONLY
 				// if it is still pointing to cur; otherwise someone else
 				// beat us to it and we have to retry!
-				if (std::atomic_compare_exchange_weak(
+				if (relink(
 					// this invalidates cur, but we have no use for it after
 					// this call anyway; either we're done and don't need it,
 					// or we need to start the search again and don't need it.
-					&prev->next, &cur, new_node
+					prev, cur, new_node
 				)) {
 					++buckets->node_count;
+					buckets->bucket_for_hash(key_hash)
+						.count_change(1, buckets->allocator);
+					buckets->reclaim_retired();
 					return iterator(new_node.get());
 				}
 
@@ -948,76 +1605,78 @@ public:
 		assert( buckets
 			&& "can not work with an empty bucket list!" );
 
-		node_pointer prev, cur;
-		while(true) {
-			if (!buckets->find(key, prev, cur)) {
-				return 0;
-			}
-			else {
-				node_pointer next = std::atomic_exchange(&cur->next, node_pointer{});
-				if (!next) {
-					// someone else is trying to delete this node at the same
-					// time - we will leave them be, but we must not return yet
-					// because at this point a subsequent find() may still find
-					// the node and return it, which would be in violation with
-					// our post-condition.
-					// instead we'll check their progress ... in a moment
-					std::this_thread::yield();
-					continue;
-				}
+		return erase_hashed(buckets, key, buckets->hash(key));
+	}
 
-				// At this point, this node is marked for deletion.
-				// All traversions made through this by thread-safe operations
-				// have either completed successfully or will result in retrys
-				// until the node is completely unlinked.
-				// A potential insertion after this node will fail, because
+	/** \brief Removes an element with a precomputed hash from the hash_map.
+	 *
+	 * This function is equivalent to calling <tt>erase(key)</tt>, but uses
+	 * \c key_hash instead of calculating the hash of the key.
+	 *
+	 * \param key The key of the element in the hash_map.
+	 * \param key_hash The hash of \c key.
+	 *
+	 * \pre
+	 *     - <tt>key_hash == hash_function()(key)</tt>
+	 *
+	 * \return The same as <tt>erase(key)</tt>.
+	 */
+	size_type erase(const key_type &key, hash_type key_hash) {
+		bucket_list_pointer buckets = std::atomic_load(&current_buckets);
+		assert( buckets
+			&& "can not work with an empty bucket list!" );
+		assert( buckets->hash(key) == key_hash
+			&& "key_hash must be the hash of the key!" );
 
-				// current situataion:
-				//
-				// ... --> prev               next --> ...
-				//            |               ^
-				// (expected) +----> cur --//-+ (severed)
+		return erase_hashed(buckets, key, key_hash);
+	}
 
-				// now attempt to relink prev->next to next, but ONLY
-				// if it is still pointing to cur; otherwise someone else
-				// has concurrently deleted prev or cur (only deletion is
-				// possible, because insertion only happens at the end, i.e.
-				// after this node) while we were preparing for deletion and
-				// we need to retry.
+	/** \brief Removes an element with a precomputed hash from the hash_map.
+	 *
+	 * \param key The key of the element and its hash.
+	 *
+	 * \return The same as <tt>erase(key.key())</tt>.
+	 */
+	size_type erase(const hashed_key &key) {
+		return erase(key.key(), key.hash());
+	}
 
-				// we will need cur if the exchange fails, so we pass a copy:
-				node_pointer expected_value = cur;
-				if (std::atomic_compare_exchange_strong(
-					&prev->next, &expected_value, next
-				)) {
-					--buckets->node_count;
-					return 1;
-				}
+	/** \brief Inserts several elements into the map.
+	 *
+	 * This function is equivalent to calling
+	 * <tt>insert(std::make_pair(keys[i], mapped[i]))</tt> for every element
+	 * in order, but hashes the keys in batches and prefetches their buckets
+	 * ahead of the insertions. If the hash function offers a \c hash_batch()
+	 * member, like \c integer_hash does, it is used to hash the batches.
+	 *
+	 * \param keys The keys of the elements to insert.
+	 * \param mapped The values of the elements to insert.
+	 * \param count The number of elements to insert.
+	 *
+	 * \return The number of elements inserted.
+	 *
+	 * \note The insertions are not atomic as a whole.
+	 */
+	size_type insert_bulk(
+		const key_type *keys,
+		const mapped_type *mapped,
+		size_type count
+	) {
+		bucket_list_pointer buckets = std::atomic_load(&current_buckets);
+		assert( buckets
+			&& "can not work with an empty bucket list!" );
 
-				// ruled out concurrent insertion
-				//     (only happens at end of list)
-				// ruled out concurrent erase of same node
-				//     (subsequent operations retry on cur->next==nullptr),
-				// prev->next can only change by erase(prev) - which means that
-				// prev->next should be a nullptr. So we roll back.
-				// But just as we roll back, so could erase(prev), if it
-				// collided with an erase(prev->prev); which would then restore
-				// prev->next. But then prev->next would be cur again, so the
-				// only two possible values for expected_value are nullptr and
-				// cur - but we atomically checked against cur, so only nullptr
-				// is left as an option.
-				// This needed to be documented, but is far too long for an
-				// assertion message.
-
-				assert( !expected_value && "failed to exchange prev->next, "
-					"but prev->next is not a nullptr, either" );
-
-				// someone beat us to it - tough luck; relink next to cur,
-				std::atomic_store(&cur->next, next);
-				// then reset and try again ... in a moment
-				std::this_thread::yield();
+		size_type num_inserted = 0;
+		for_each_hashed(buckets, keys, count,
+			[&](size_type n, hash_type key_hash) {
+				if (insert_hashed(
+					buckets, key_hash, value_type(keys[n], mapped[n])
+				).first) {
+					++num_inserted;
+				}
 			}
-		}
+		);
+		return num_inserted;
 	}
 
 	/** \brief Removes an element from the hash_map by its iterator.
@@ -1081,7 +1740,13 @@ public:
 	 * \return A reference to the element requested.
 	 */
 	mapped_type &at(const key_type &key) {
-		iterator it = find(key);
+		// hold on to the bucket list until the element is dereferenced, so
+		// a concurrent clear() can not destroy it in the meantime
+		bucket_list_pointer buckets = std::atomic_load(&current_buckets);
+		assert( buckets
+			&& "can not work with an empty bucket list!" );
+
+		iterator it = find_hashed(buckets, key, buckets->hash(key));
 		if (it != end()) {
 			return it->second;
 		}
@@ -1100,13 +1765,7 @@ public:
 	 * \return A constant reference to the element requested.
 	 */
 	const mapped_type &at(const key_type &key) const {
-		const_iterator it = find(key);
-		if (it != cend()) {
-			return it->second;
-		}
-		else {
-			throw std::out_of_range("element not found in hash_map");
-		}
+		return const_cast<hash_map&>(*this).at(key);
 	}
 
 	/** \brief Accesses an element by its key.
@@ -1129,7 +1788,14 @@ public:
 	mapped_type&
 #endif
 	operator[](const key_type &key) {
-		auto result = insert(std::make_pair(key, mapped_type{}));
+		// see at() for why the bucket list is held
+		bucket_list_pointer buckets = std::atomic_load(&current_buckets);
+		assert( buckets
+			&& "can not work with an empty bucket list!" );
+
+		auto result = insert_hashed(
+			buckets, buckets->hash(key), std::make_pair(key, mapped_type{})
+		);
 		return result.second->second;
 	}
 
@@ -1159,13 +1825,7 @@ public:
 		assert( buckets
 			&& "can not work with an empty bucket list!" );
 
-		node_pointer prev, cur;
-		if (buckets->find(key, prev, cur)) {
-			return iterator(cur.get());
-		}
-		else {
-			return end();
-		}
+		return find_hashed(buckets, key, buckets->hash(key));
 	}
 
 	/** \brief Finds an element by its key.
@@ -1181,6 +1841,117 @@ public:
 		return const_cast<hash_map&>(*this).find(key);
 	}
 
+	/** \brief Finds an element by its key and precomputed hash.
+	 *
+	 * This function is equivalent to calling <tt>find(key)</tt>, but uses
+	 * \c key_hash instead of calculating the hash of the key.
+	 *
+	 * \param key The key of the element to fetch.
+	 * \param key_hash The hash of \c key.
+	 *
+	 * \pre
+	 *     - <tt>key_hash == hash_function()(key)</tt>
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	iterator find(const key_type &key, hash_type key_hash) {
+		bucket_list_pointer buckets = std::atomic_load(&current_buckets);
+		assert( buckets
+			&& "can not work with an empty bucket list!" );
+		assert( buckets->hash(key) == key_hash
+			&& "key_hash must be the hash of the key!" );
+
+		return find_hashed(buckets, key, key_hash);
+	}
+
+	/** \brief Finds an element by its key and precomputed hash.
+	 *
+	 * \param key The key of the element to fetch.
+	 * \param key_hash The hash of \c key.
+	 *
+	 * \pre
+	 *     - <tt>key_hash == hash_function()(key)</tt>
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	const_iterator find(const key_type &key, hash_type key_hash) const {
+		return const_cast<hash_map&>(*this).find(key, key_hash);
+	}
+
+	/** \brief Finds an element by its key and precomputed hash.
+	 *
+	 * \param key The key of the element to fetch and its hash.
+	 *
+	 * \return The same as <tt>find(key.key())</tt>.
+	 */
+	iterator find(const hashed_key &key) {
+		return find(key.key(), key.hash());
+	}
+
+	/** \brief Finds an element by its key and precomputed hash.
+	 *
+	 * \param key The key of the element to fetch and its hash.
+	 *
+	 * \return The same as <tt>find(key.key())</tt>.
+	 */
+	const_iterator find(const hashed_key &key) const {
+		return const_cast<hash_map&>(*this).find(key);
+	}
+
+	/** \brief Finds several elements by their keys.
+	 *
+	 * This function is equivalent to calling <tt>find(keys[i])</tt> for
+	 * every key in order, but hashes the keys in batches and prefetches their
+	 * buckets ahead of the lookups. If the hash function offers a
+	 * \c hash_batch() member, like \c integer_hash does, it is used to hash
+	 * the batches.
+	 *
+	 * \param keys The keys of the elements to fetch.
+	 * \param count The number of keys.
+	 * \param[out] results Receives an iterator to the element for every key,
+	 *     or <tt>end()</tt> if no such element exists.
+	 */
+	void find_bulk(
+		const key_type *keys,
+		size_type count,
+		iterator *results
+	) {
+		bucket_list_pointer buckets = std::atomic_load(&current_buckets);
+		assert( buckets
+			&& "can not work with an empty bucket list!" );
+
+		for_each_hashed(buckets, keys, count,
+			[&](size_type n, hash_type key_hash) {
+				results[n] = find_hashed(buckets, keys[n], key_hash);
+			}
+		);
+	}
+
+	/** \brief Finds several elements by their keys.
+	 *
+	 * \param keys The keys of the elements to fetch.
+	 * \param count The number of keys.
+	 * \param[out] results Receives an iterator to the element for every key,
+	 *     or <tt>end()</tt> if no such element exists.
+	 */
+	void find_bulk(
+		const key_type *keys,
+		size_type count,
+		const_iterator *results
+	) const {
+		bucket_list_pointer buckets = std::atomic_load(&current_buckets);
+		assert( buckets
+			&& "can not work with an empty bucket list!" );
+
+		for_each_hashed(buckets, keys, count,
+			[&](size_type n, hash_type key_hash) {
+				results[n] = find_hashed(buckets, keys[n], key_hash);
+			}
+		);
+	}
+
 	/** \brief Returns an iterator range for all elements with a specific key.
 	 *
 	 * \param key The key of the element to fetch.
@@ -1195,26 +1966,23 @@ public:
 		assert( buckets
 			&& "can not work with an empty bucket list!" );
 
-		while(true) {
-			node_pointer prev, cur;
-			if (!buckets->find(key, prev, cur)) {
-				// cur is the buckets sentinel, i.e. the end of the bucket
-				return std::make_pair(
-					local_iterator(cur.get()),
-					local_iterator(cur.get())
-				);
-			}
-			else if (node_pointer next = std::atomic_load(&cur->next)) {
-				return std::make_pair(
-					local_iterator(cur.get()),
-					local_iterator(next.get())
-				);
-			}
-			else {
-				// cur->next was nullptr, which means the node is being erased
-				// concurrently. We need to retry and check whether the node is
-				// gone (or maybe a new node with the same key awaits us)
-			}
+		node_pointer cur = buckets->lookup(key, buckets->hash(key));
+		if (cur->is_sentinel()) {
+			// cur is the buckets sentinel, i.e. the end of the bucket
+			return std::make_pair(
+				local_iterator(cur.get()),
+				local_iterator(cur.get())
+			);
+		}
+		else {
+			// if cur is erased concurrently, the range will still be a valid
+			// range of the bucket, but the erase operation invalidates its
+			// first iterator, just like it would invalidate the result of
+			// find().
+			return std::make_pair(
+				local_iterator(cur.get()),
+				local_iterator(cur->next_live().get())
+			);
 		}
 	}
 
@@ -1257,8 +2025,8 @@ public:
 			&& "can not work with an empty bucket list!" );
 
 		const typename fixed_size_bucket_list::bucket &bucket
-			= buckets->buckets[bucket_index];
-		return local_iterator(std::atomic_load(&bucket.sentinel->next).get());
+			= buckets->bucket_at(bucket_index);
+		return local_iterator(bucket.sentinel->next_live().get());
 	}
 
 	/** \brief Returns a bucket local iterator to the beginning of a bucket.
@@ -1305,7 +2073,7 @@ public:
 			&& "can not work with an empty bucket list!" );
 
 		const typename fixed_size_bucket_list::bucket &bucket
-			= buckets->buckets[bucket_index];
+			= buckets->bucket_at(bucket_index);
 		return local_iterator(bucket.sentinel.get());
 	}
 
@@ -1370,9 +2138,12 @@ public:
 			&& "can not work with an empty bucket list!" );
 
 		size_type count = 0;
+		if (!buckets->is_constructed(bucket_index)) {
+			return count;
+		}
 
 		node_pointer cur = buckets->buckets[bucket_index].sentinel;
-		while( !(cur = std::atomic_load(&cur->next))->is_sentinel() ) {
+		while( !(cur = cur->next_live())->is_sentinel() ) {
 			++count;
 		}
 
@@ -1391,7 +2162,7 @@ public:
 		assert( buckets
 			&& "can not work with an empty bucket list!" );
 
-		return &buckets->bucket_for_key(key) - buckets->buckets;
+		return buckets->bucket_index(static_cast<std::size_t>(buckets->hash(key)));
 	}
 ///\}
 
@@ -1400,6 +2171,60 @@ public:
 /// \internal \name Internals
 ///\{ \internal
 private:
+	template<typename, typename, std::size_t, std::size_t, typename, typename, typename>
+	friend struct static_hash_map;
+
+	template<typename, typename, typename, typename, typename, typename>
+	friend class frozen_hash_map;
+
+	/** \internal \brief Estimates the memory needed by a map of fixed size.
+	 *
+	 * Accounts for two bucket lists, so the map can be cleared while the
+	 * previous list is still in use, and for one data node and one marker
+	 * node per element. Every allocation is assumed to be rounded up to
+	 * \c alignof(std::max_align_t) and to carry a control block of the size
+	 * assumed by \ref inline_node_slot.
+	 *
+	 * \param bucket_count The number of buckets.
+	 * \param capacity The number of elements.
+	 *
+	 * \return The number of bytes needed.
+	 */
+	static constexpr std::size_t storage_estimate(
+		size_type bucket_count,
+		size_type capacity
+	) noexcept {
+		constexpr std::size_t control_block
+			= sizeof(allocator_type) + 5 * sizeof(void *);
+
+		const std::size_t bucket_list =
+			rounded(sizeof(fixed_size_bucket_list) + control_block) +
+			rounded(
+				bucket_count * sizeof(typename fixed_size_bucket_list::bucket)
+					+ alignof(typename fixed_size_bucket_list::bucket) - 1
+			);
+		const std::size_t element =
+			rounded(sizeof(data_node) + control_block) +
+			rounded(sizeof(node) + control_block) +
+			(Traits::out_of_line_values
+				? rounded(sizeof(value_type) + sizeof(allocator_type))
+				: 0);
+
+		return 2 * bucket_list + capacity * element;
+	}
+
+	/** \internal \brief Rounds the size of an allocation up.
+	 *
+	 * \param bytes The number of bytes requested.
+	 *
+	 * \return \c bytes, rounded up to a multiple of
+	 *     \c alignof(std::max_align_t).
+	 */
+	static constexpr std::size_t rounded(std::size_t bytes) noexcept {
+		return (bytes + alignof(std::max_align_t) - 1)
+			/ alignof(std::max_align_t) * alignof(std::max_align_t);
+	}
+
 	/** \internal
 	 * \brief Checks whether bucket-wise comparison with another
 	 *     hash_map is possible.
@@ -1441,17 +2266,494 @@ private:
 		return false;
 	}
 
-	/// \internal \brief Represents a data or sentinel node inside a bucket.
-	struct node {
-		/// \internal \brief The smart pointer type used to hold nodes.
-		typedef std::shared_ptr<node> pointer;
+	/** \internal
+	 * \brief Copies the nodes stored inside buckets for rehashing.
+	 *
+	 * Nodes stored inside the buckets of \c from must not outlive them, so
+	 * they are copied into new nodes, which are linked into \c to right away.
+	 * If an exception is thrown, \c from is unchanged.
+	 *
+	 * \param from The bucket list to copy from.
+	 * \param to The bucket list to link the copies into.
+	 */
+	static void copy_inline_nodes(
+		std::true_type,
+		const fixed_size_bucket_list &from,
+		fixed_size_bucket_list &to
+	) {
+		const auto end = from.buckets + from.bucket_count;
+		for(auto b = from.buckets; b != end; ++b) {
+			if (!from.is_constructed(size_type(b - from.buckets))) {
+				continue;
+			}
+			node_pointer cur = b->sentinel->next_live();
+			while(!cur->is_sentinel() && !b->stores(cur.get())) {
+				cur = cur->next_live();
+			}
+			if (!cur->is_sentinel()) {
+				to.link_front(to.bucket_for_hash(cur->key_hash).create_node(
+					to.allocator, cur->key_hash, cur->data()
+				));
+			}
+		}
+	}
 
-		/// \internal \brief The pointer type to point to buckets.
-		typedef const typename fixed_size_bucket_list::bucket *bucket_pointer;
+	/** \internal
+	 * \brief Does nothing, because buckets do not store nodes.
+	 */
+	static void copy_inline_nodes(
+		std::false_type,
+		const fixed_size_bucket_list &,
+		fixed_size_bucket_list &
+	) {}
 
-		/// \internal \brief A pointer to the next node in the bucket.
+	/** \internal \brief Hashes several keys using the batch interface.
+	 *
+	 * This overload is used if the hash function has a \c hash_batch()
+	 * member.
+	 *
+	 * \param hash The hash function.
+	 * \param keys The keys to hash.
+	 * \param count The number of keys.
+	 * \param[out] hashes Receives the hashes of the keys.
+	 */
+	template<typename H>
+	static auto hash_keys(
+		int,
+		const H &hash,
+		const key_type *keys,
+		size_type count,
+		hash_type *hashes
+	) -> decltype(hash.hash_batch(keys, count, hashes), void()) {
+		hash.hash_batch(keys, count, hashes);
+	}
+
+	/** \internal \brief Hashes several keys one by one.
+	 *
+	 * This overload is a fallback, in case the hash function has no
+	 * \c hash_batch() member.
+	 */
+	static void hash_keys(
+		long,
+		const hasher &hash,
+		const key_type *keys,
+		size_type count,
+		hash_type *hashes
+	) {
+		for(size_type n = 0; n < count; ++n) {
+			hashes[n] = hash(keys[n]);
+		}
+	}
+
+	/** \internal \brief Calls a function for several keys and their hashes.
+	 *
+	 * The keys are hashed in batches of \ref bulk_batch_size, and the
+	 * buckets of a batch are prefetched before the function is called for
+	 * any of its keys, so their cache misses overlap.
+	 *
+	 * \param buckets The bucket list the keys are used with.
+	 * \param keys The keys.
+	 * \param count The number of keys.
+	 * \param f The function to call with the index of every key and its
+	 *     hash, in order.
+	 */
+	template<typename F>
+	static void for_each_hashed(
+		const bucket_list_pointer &buckets,
+		const key_type *keys,
+		size_type count,
+		F &&f
+	) {
+		hash_type hashes[bulk_batch_size];
+		for(size_type first = 0; first < count; first += bulk_batch_size) {
+			const size_type batch = (count - first < bulk_batch_size)
+				? count - first
+				: bulk_batch_size;
+			hash_keys(0, buckets->hash, keys + first, batch, hashes);
+			for(size_type n = 0; n < batch; ++n) {
+				prefetch(&buckets->bucket_for_hash(hashes[n]));
+			}
+			for(size_type n = 0; n < batch; ++n) {
+				f(first + n, hashes[n]);
+			}
+		}
+	}
+
+	/** \internal \brief The number of keys hashed at a time by bulk
+	 *     operations.
+	 */
+	static constexpr size_type bulk_batch_size = 16;
+
+	/** \internal \brief The number of buckets of a retired bucket list
+	 *     destroyed per insertion or erasure if \c Traits::incremental_clear
+	 *     is enabled.
+	 */
+	static constexpr size_type reclaim_batch_size = 16;
+
+	/** \internal \brief The minimum number of buckets and nodes of a bucket
+	 *     list destroyed using \c Traits::destruction_threads threads.
+	 */
+	static constexpr size_type parallel_destruction_threshold = 1 << 16;
+
+	/** \internal \brief Hands a replaced bucket list to the reclamation
+	 *     policy.
+	 *
+	 * \param buckets The bucket list, or \c nullptr.
+	 */
+	static void retire_bucket_list(bucket_list_pointer buckets) noexcept {
+		if (buckets) {
+			const std::size_t bytes = buckets->allocated_bytes();
+			reclamation_policy::retire(std::move(buckets), bytes);
+		}
+	}
+
+	/** \internal \brief Hints that memory will be read soon.
+	 *
+	 * \param p The address to prefetch.
+	 */
+	static void prefetch(const void *p) noexcept {
+#if defined(__GNUC__)
+		__builtin_prefetch(p);
+#else
+		(void)p;
+#endif
+	}
+
+	/** \internal \brief Prefetches the first node of a later bucket.
+	 *
+	 * Prefetches the first node of the bucket \c Traits::prefetch_distance
+	 * buckets after the one of \c sentinel, so iterating over all elements
+	 * does not need to wait for every bucket to be loaded in turn.
+	 *
+	 * \param sentinel The sentinel of the current bucket.
+	 */
+	static void prefetch_bucket_ahead(const node &sentinel) noexcept {
+		if (Traits::prefetch_distance) {
+			const sentinel_node &current
+				= static_cast<const sentinel_node &>(sentinel);
+			current.prefetch_ahead(current.following_bucket);
+		}
+	}
+
+	/** \internal \brief Relinks the successor of a node.
+	 *
+	 * Atomically replaces <tt>prev->next</tt> with \c desired, but only if it
+	 * still refers to \c expected. If \c prev is a sentinel, its hint for the
+	 * first node of the bucket is updated as well.
+	 *
+	 * \param prev The node to relink.
+	 * \param[in,out] expected The expected successor of \c prev. Receives the
+	 *     actual successor if it is not the expected one.
+	 * \param desired The new successor of \c prev.
+	 *
+	 * \return
+	 *     - \c true if \c prev has been relinked,
+	 *     - \c false otherwise.
+	 */
+	static bool relink(
+		const node_pointer &prev,
+		node_pointer &expected,
+		const node_pointer &desired
+	) {
+		if (!std::atomic_compare_exchange_strong(
+			&prev->next, &expected, desired
+		)) {
+			return false;
+		}
+		update_first_hint(*prev, desired);
+		return true;
+	}
+
+	/** \internal \brief Updates the first node hint of a sentinel.
+	 *
+	 * \param prev A node that has just been given a new successor.
+	 * \param next The new successor of \c prev.
+	 */
+	static void update_first_hint(
+		const node &prev,
+		const node_pointer &next
+	) noexcept {
+		if (Traits::prefetch_distance && prev.is_sentinel()) {
+			static_cast<const sentinel_node &>(prev)
+				.first_hint.store(next.get(), std::memory_order_relaxed);
+		}
+	}
+
+	/** \internal \brief Inserts an element into a bucket list.
+	 *
+	 * \param buckets The bucket list to insert into.
+	 * \param key_hash The hash of the key of \c value.
+	 * \param value The value to insert.
+	 *
+	 * \return The same as \ref insert().
+	 */
+	static std::pair<bool, iterator> insert_hashed(
+		const bucket_list_pointer &buckets,
+		hash_type key_hash,
+		const value_type &value
+	) {
+		node_pointer new_node;
+		node_pointer prev, cur;
+		while(true) {
+			if (buckets->find(value.first, key_hash, prev, cur)) {
+				return std::make_pair(false, iterator(cur.get()));
+			}
+			else {
+				assert( cur->is_sentinel()
+					&& "will only append to the end of a list!" );
+
+				if (!new_node) {
+					new_node = buckets->bucket_for_hash(key_hash).create_node(
+						buckets->allocator,
+						key_hash,
+						value
+					);
+				}
+
+				// configure the node for insertion at this place
+				new_node->next = cur;
+
+				// current situataion:
+				//
+				// ... --> prev --(expected)--> cur (= end of list)
+				//                               ^
+				//                 new_node -----+
+				//
+				// now attempt to relink prev->next to new_node, but ONLY
+				// if it is still pointing to cur; otherwise someone else
+				// beat us to it and we have to retry!
+				if (relink(
+					// this invalidates cur, but we have no use for it after
+					// this call anyway; either we're done and don't need it,
+					// or we need to start the search again and don't need it.
+					prev, cur, new_node
+				)) {
+					++buckets->node_count;
+					buckets->bucket_for_hash(key_hash)
+						.count_change(1, buckets->allocator);
+					buckets->reclaim_retired();
+					return std::make_pair(true, iterator(new_node.get()));
+				}
+
+				// someone beat us to it - tough luck; reset and try again ...
+				// ... in a moment
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	/** \internal \brief Removes an element from a bucket list.
+	 *
+	 * \param buckets The bucket list to remove from.
+	 * \param key The key of the element.
+	 * \param key_hash The hash of \c key.
+	 *
+	 * \return The same as \ref erase().
+	 */
+	static size_type erase_hashed(
+		const bucket_list_pointer &buckets,
+		const key_type &key,
+		hash_type key_hash
+	) {
+		node_pointer marker;
+		node_pointer prev, cur;
+		while(true) {
+			if (!buckets->find(key, key_hash, prev, cur)) {
+				return 0;
+			}
+			else {
+				node_pointer next = std::atomic_load(&cur->next);
+				if (next->is_marker()) {
+					// someone else has deleted this node just now. find() will
+					// help them unlinking it and then check whether a node with
+					// the same key has been inserted since.
+					continue;
+				}
+
+				if (!marker) {
+					marker = node::create_marker(buckets->allocator);
+				}
+
+				// configure the marker to preserve the successor of cur
+				marker->next = next;
+
+				// current situataion:
+				//
+				// ... --> prev --> cur --(expected)--> next --> ...
+				//                                      ^
+				//                  marker -------------+
+				//
+				// now attempt to relink cur->next to marker, but ONLY if it is
+				// still pointing to next. If this succeeds, cur is logically
+				// deleted: From now on, cur->next will never change again,
+				// so neither an insert after cur nor another erase of cur can
+				// succeed, while traversals can still step over cur.
+				// Otherwise either a node has been appended to cur or cur
+				// has been deleted by someone else, and we have to retry.
+				if (std::atomic_compare_exchange_strong(
+					&cur->next, &next, marker
+				)) {
+					--buckets->node_count;
+					buckets->reclaim_retired();
+
+					// now attempt to physically unlink cur by relinking
+					// prev->next to next, but ONLY if it is still pointing to
+					// cur. If someone else concurrently deleted prev, this
+					// fails, in which case another traversal of the bucket
+					// will unlink cur (unless someone else already did).
+					// If cur has been found through the index of the bucket,
+					// prev is unknown, and unlinking is left to the next
+					// rebuild of the index.
+					node_pointer expected = cur;
+					if (prev && !relink(prev, expected, marker->next)) {
+						buckets->find(key, key_hash, prev, cur);
+					}
+					buckets->bucket_for_hash(key_hash)
+						.count_change(-1, buckets->allocator);
+					return 1;
+				}
+
+				// someone beat us to it - tough luck; reset and try again ...
+				// ... in a moment
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	/** \internal \brief Finds an element in a bucket list.
+	 *
+	 * \param buckets The bucket list to search.
+	 * \param key The key of the element.
+	 * \param key_hash The hash of \c key.
+	 *
+	 * \return The same as \ref find().
+	 */
+	static iterator find_hashed(
+		const bucket_list_pointer &buckets,
+		const key_type &key,
+		hash_type key_hash
+	) {
+		node_pointer cur = buckets->lookup(key, key_hash);
+		if (!cur->is_sentinel()) {
+			return iterator(cur.get());
+		}
+		else {
+			return iterator(nullptr);
+		}
+	}
+
+	/** \internal \brief Counts the lookup hits of a node.
+	 *
+	 * This is the disabled variant, which does not take up any space.
+	 *
+	 * \tparam Enabled Whether hits are counted.
+	 */
+	template<bool Enabled, typename = void>
+	struct hit_counter {
+		/// \internal \brief Does nothing.
+		void record_hit() noexcept {}
+
+		/// \internal \brief Returns \c 0.
+		std::uint32_t hits() const noexcept {
+			return 0;
+		}
+
+		/// \internal \brief Does nothing.
+		void decay_hits() noexcept {}
+	};
+
+	/** \internal \brief Counts the lookup hits of a node.
+	 *
+	 * Hits are sampled as configured by \c Traits::hit_sample_shift, so the
+	 * counter approximates the number of hits divided by the sampling rate.
+	 */
+	template<typename Dummy>
+	struct hit_counter<true, Dummy> {
+		/// \internal \brief Initializes the counter with zero hits.
+		hit_counter() noexcept
+		: hit_count(0) {}
+
+		/// \internal \brief Counts a hit, if it is sampled.
+		void record_hit() noexcept {
+			constexpr std::uint32_t sample_mask =
+				(std::uint32_t(1) << Traits::hit_sample_shift) - 1;
+
+			// xorshift32 - cheap and good enough to pick samples
+			static thread_local std::uint32_t state = 1 | static_cast<std::uint32_t>(
+				std::hash<std::thread::id>()(std::this_thread::get_id())
+			);
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+
+			if (
+				0 == (state & sample_mask) &&
+				// saturate instead of overflowing to zero
+				hit_count.load(std::memory_order_relaxed)
+					!= std::numeric_limits<std::uint32_t>::max()
+			) {
+				hit_count.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		/// \internal \brief Returns the number of sampled hits.
+		std::uint32_t hits() const noexcept {
+			return hit_count.load(std::memory_order_relaxed);
+		}
+
+		/// \internal \brief Halves the number of hits to let old hits fade.
+		void decay_hits() noexcept {
+			hit_count.store(hits() / 2, std::memory_order_relaxed);
+		}
+
+	private:
+		/// \internal \brief The number of sampled hits.
+		std::atomic<std::uint32_t> hit_count;
+	};
+
+	/** \internal \brief Represents a node inside a bucket.
+	 *
+	 * This is the part common to all kinds of nodes. Data nodes are
+	 * \ref data_node objects, sentinel nodes are \ref sentinel_node objects
+	 * and marker nodes are plain \c node objects.
+	 */
+	struct node: hit_counter<Traits::offline_reorder> {
+	private:
+		/// \internal \brief The different roles a node can play in a bucket.
+		enum class node_kind : unsigned char {
+			sentinel, ///< \internal Front and end of a bucket.
+			data,     ///< \internal Holds a \c value_type object.
+			marker    ///< \internal Marks its predecessor as deleted.
+		};
+
+		/** \internal \brief Indicates the role of this node.
+		 *
+		 * This is the first member, so it shares the padding behind the hit
+		 * counter instead of adding padding of its own behind \c key_hash.
+		 *
+		 * \note A node only becomes a data node once its \c value_type object
+		 *     has been constructed successfully.
+		 */
+		node_kind kind;
+
+	public:
+		/// \internal \brief The smart pointer type used to hold nodes.
+		typedef std::shared_ptr<node> pointer;
+
+		/// \internal \brief The pointer type to point to buckets.
+		typedef const typename fixed_size_bucket_list::bucket *bucket_pointer;
+
+		/// \internal \brief A pointer to the next node in the bucket.
 		pointer next;
 
+		/** \internal \brief The hash of the key of a data node.
+		 *
+		 * Caching the hash allows to skip most key comparisons of unequal
+		 * keys and to move nodes to other buckets without rehashing them.
+		 * Unused in sentinel and marker nodes.
+		 */
+		hash_type key_hash;
+
 		/** \internal \brief Accesses the data stored.
 		 *
 		 * \pre
@@ -1461,9 +2763,9 @@ private:
 		 *      object stored in this node.
 		 */
 		const value_type &data() const {
-			assert( !is_sentinel()
-				&& "must not access data of a sentinel node" );
-			return *reinterpret_cast<const value_type *>(data_);
+			assert( !is_sentinel() && !is_marker()
+				&& "must only access data of a data node" );
+			return static_cast<const data_node *>(this)->value();
 		}
 
 		/** \internal \brief Accesses the data stored.
@@ -1475,9 +2777,9 @@ private:
 		 *      object stored in this node.
 		 */
 		value_type &data() {
-			assert( !is_sentinel()
-				&& "must not access data of a sentinel node" );
-			return *reinterpret_cast<value_type *>(data_);
+			assert( !is_sentinel() && !is_marker()
+				&& "must only access data of a data node" );
+			return static_cast<data_node *>(this)->value();
 		}
 
 		/** \internal \brief Determines the next bucket.
@@ -1490,7 +2792,9 @@ private:
 		bucket_pointer next_bucket() const {
 			assert( is_sentinel()
 				&& "can not get next bucket from a data node" );
-			return *reinterpret_cast<const bucket_pointer *>(data_);
+			const sentinel_node *sentinel
+				= static_cast<const sentinel_node *>(this);
+			return sentinel->constructed_from(sentinel->following_bucket);
 		}
 
 		/** \internal \brief Checks whether the node is a sentinel node.
@@ -1500,34 +2804,64 @@ private:
 		 *     - \c false otherwise.
 		 */
 		bool is_sentinel() const noexcept {
-			return !initialized;
+			return kind == node_kind::sentinel;
 		}
 
-		/** \internal \brief Creates a sentinel node.
+		/** \internal \brief Checks whether the node is a deletion marker.
+		 *
+		 * Marker nodes are never found at the front of a bucket. They are
+		 * only ever linked as the immediate successor of a data node that has
+		 * been logically deleted, and their own next-pointer refers to the
+		 * successor the deleted node had at the time of its deletion.
+		 *
+		 * \return
+		 *     - \c true if this node is a marker node,
+		 *     - \c false otherwise.
+		 */
+		bool is_marker() const noexcept {
+			return kind == node_kind::marker;
+		}
+
+		/** \internal \brief Finds the next node not logically deleted.
+		 *
+		 * Deletion markers and the data nodes marked by them are skipped.
+		 * This never modifies the node list, so it can be used by read-only
+		 * traversals of any kind.
+		 *
+		 * \return A pointer to the next live data node or the next sentinel.
+		 */
+		pointer next_live() const {
+			pointer cur = std::atomic_load(&next);
+			if (cur->is_marker()) {
+				// this node is deleted itself, but markers are immutable and
+				// refer to the successor at the time of deletion.
+				cur = cur->next;
+			}
+			while(!cur->is_sentinel()) {
+				pointer succ = std::atomic_load(&cur->next);
+				if (!succ->is_marker()) {
+					break;
+				}
+				cur = succ->next;
+			}
+			return cur;
+		}
+
+		/** \internal \brief Creates a deletion marker node.
 		 *
 		 * \param alloc The allocator to use to allocate the node.
-		 * \param next_bucket A pointer to the next bucket or \c nullptr if no
-		 *     bucket follows.
 		 *
 		 * \return A \c node_pointer to the new node.
 		 *
 		 * \post
-		 *     - \c is_data() returns \c false
-		 *     - \c is_sentinel() returns \c true
+		 *     - \c is_marker() returns \c true
 		 *
 		 * \note While this function does not throw itself, it will forward
 		 *     exceptions thrown by the allocator called.
-		 *
-		 * \note While next_bucket needs to point to the location of the next
-		 *     bucket, the bucket it not accessed from this function and thus
-		 *     does not (yet) need to exist.
 		 */
-		static pointer create_sentinel(
-			const allocator_type &alloc,
-			bucket_pointer next_bucket
-		) {
+		static pointer create_marker(const allocator_type &alloc) {
 			pointer new_node = std::allocate_shared<node>(alloc);
-			new (new_node->data_) bucket_pointer(next_bucket);
+			new_node->kind = node_kind::marker;
 			return new_node;
 		}
 
@@ -1536,10 +2870,14 @@ private:
 		 *
 		 * Creates a data node and emplaces a \c value_type object into it.
 		 *
+		 * \tparam NodeAllocator The type of the allocator.
 		 * \tparam Args Types of arguments passed to the constructor of
 		 *     \c value_type.
 		 *
 		 * \param alloc The allocator to use to allocate the node.
+		 * \param value_alloc The allocator to use to allocate the element,
+		 *     if it is stored apart from the node.
+		 * \param key_hash The hash of the key of the constructed element.
 		 * \param args These arguments are forwarded to the constructor of
 		 *     \c value_type.
 		 *
@@ -1554,14 +2892,18 @@ private:
 		 * \note While this function does not throw itself, it will forward
 		 *     exceptions thrown by the allocator or the constructor called.
 		 */
-		template<typename... Args>
+		template<typename NodeAllocator, typename... Args>
 		static pointer create_with_data(
-			const allocator_type &alloc,
+			const NodeAllocator &alloc,
+			const allocator_type &value_alloc,
+			hash_type key_hash,
 			Args&&... args
 		) {
-			pointer new_node = std::allocate_shared<node>(alloc);
-			new (new_node->data_) value_type(std::forward<Args>(args)...);
-			new_node->initialized = true; // must come after initialization
+			std::shared_ptr<data_node> new_node
+				= std::allocate_shared<data_node>(alloc);
+			new_node->key_hash = key_hash;
+			new_node->construct_value(value_alloc, std::forward<Args>(args)...);
+			new_node->kind = node_kind::data; // must come after initialization
 				// to avoid calling the dtor on an uninitialized object in
 				// case the ctor throws!
 			return new_node;
@@ -1569,141 +2911,1077 @@ private:
 
 		/// \internal \brief Initializes an empty (sentinel) node.
 		node() noexcept
-		: next()
-		, initialized(false) {}
+		: kind(node_kind::sentinel)
+		, next()
+		, key_hash() {}
+	};
+
+	/** \internal \brief Stores the element of a data node.
+	 *
+	 * This is the default variant, which stores the element inside the node.
+	 *
+	 * \tparam OutOfLine Whether the element is stored apart from the node.
+	 */
+	template<bool OutOfLine, typename = void>
+	struct value_storage {
+		/// \internal \brief Constructs the \c value_type object.
+		template<typename... Args>
+		void construct_value(const allocator_type &, Args&&... args) {
+			new (storage) value_type(std::forward<Args>(args)...);
+		}
+
+		/// \internal \brief Destroys the \c value_type object.
+		void destroy_value() noexcept {
+			value().~value_type();
+		}
+
+		/// \internal \brief Accesses the \c value_type object.
+		const value_type &value() const {
+			return *reinterpret_cast<const value_type *>(storage);
+		}
+
+		/// \internal \brief Accesses the \c value_type object.
+		value_type &value() {
+			return *reinterpret_cast<value_type *>(storage);
+		}
+
+		/// \internal \brief Aligned storage for \c value_type.
+		alignas(value_type) char storage[sizeof(value_type)];
+	};
+
+	/** \internal \brief Stores the element of a data node.
+	 *
+	 * This is the variant for \c Traits::out_of_line_values, which keeps the
+	 * element in an allocation of its own and only a pointer in the node.
+	 */
+	template<typename Dummy>
+	struct value_storage<true, Dummy> {
+		/// \internal \brief Initializes the storage without an element.
+		value_storage() noexcept
+		: block(nullptr) {}
+
+		// the node owns the element
+		value_storage(const value_storage &) = delete;
+		value_storage &operator=(const value_storage &) = delete;
+
+		/// \internal \brief Allocates and constructs the \c value_type object.
+		template<typename... Args>
+		void construct_value(const allocator_type &allocator, Args&&... args) {
+			block_allocator alloc(allocator);
+			value_block *new_block = block_allocator_traits::allocate(alloc, 1);
+			try {
+				new (new_block) value_block(alloc, std::forward<Args>(args)...);
+			}
+			catch(...) {
+				block_allocator_traits::deallocate(alloc, new_block, 1);
+				throw;
+			}
+			block = new_block;
+		}
+
+		/// \internal \brief Destroys and deallocates the \c value_type object.
+		void destroy_value() noexcept {
+			block_allocator alloc(block->allocator);
+			block->~value_block();
+			block_allocator_traits::deallocate(alloc, block, 1);
+		}
+
+		/// \internal \brief Accesses the \c value_type object.
+		const value_type &value() const {
+			return block->value;
+		}
+
+		/// \internal \brief Accesses the \c value_type object.
+		value_type &value() {
+			return block->value;
+		}
+
+	private:
+		struct value_block;
+
+		/// \internal \brief The allocator for element allocations.
+		typedef typename std::allocator_traits<allocator_type>
+			::template rebind_alloc<value_block> block_allocator;
+
+		/// \internal \brief The traits of \ref block_allocator.
+		typedef std::allocator_traits<block_allocator> block_allocator_traits;
+
+		/** \internal \brief The allocation holding an element.
+		 *
+		 * The allocator is kept along with the element, so the node does not
+		 * need to store it.
+		 */
+		struct value_block {
+			/// \internal \brief Constructs the element.
+			template<typename... Args>
+			explicit value_block(const block_allocator &allocator, Args&&... args)
+			: allocator(allocator)
+			, value(std::forward<Args>(args)...) {}
+
+			/// \internal \brief The allocator which allocated this block.
+			block_allocator allocator;
+
+			/// \internal \brief The element.
+			value_type value;
+		};
+
+		/// \internal \brief The element, if constructed.
+		value_block *block;
+	};
+
+	/// \internal \brief Represents a data node inside a bucket.
+	struct data_node: node, value_storage<Traits::out_of_line_values> {
+		/// \internal \brief Initializes a data node without data.
+		data_node() noexcept = default;
 
 		/** \internal
-		 * \brief Destroys a node.
+		 * \brief Destroys a data node.
 		 *
-		 * If this node is a data node, the data object held by it will be
-		 * destructed as well.
+		 * If the \c value_type object has been constructed, it is destroyed
+		 * as well.
 		 */
-		~node() noexcept {
+		~data_node() noexcept {
 			// assumes no destructor throws - otherwise all hell is loose
 			// during destruction of a non-empty hash_map anyway.
-			if (is_sentinel()) {
-				reinterpret_cast<bucket_pointer*>(data_)->~bucket_pointer();
+			if (!this->is_sentinel()) {
+				this->destroy_value();
 			}
-			else {
-				data().~value_type();
+		}
+	};
+
+	/** \internal \brief Links a sentinel node to its bucket list.
+	 *
+	 * This is the default variant, in which all buckets are constructed along
+	 * with their list and no buckets are prefetched, so no link is needed.
+	 *
+	 * \tparam Linked Whether the sentinel needs to know its bucket list.
+	 */
+	template<bool Linked, typename = void>
+	struct bucket_list_link {
+		/// \internal \brief Does not link anything.
+		explicit bucket_list_link(const fixed_size_bucket_list *) noexcept {}
+
+		/// \internal \brief Returns \c bucket, which is constructed.
+		typename node::bucket_pointer constructed_from(
+			typename node::bucket_pointer bucket
+		) const noexcept {
+			return bucket;
+		}
+
+		/// \internal \brief Does not prefetch anything.
+		void prefetch_ahead(typename node::bucket_pointer) const noexcept {}
+	};
+
+	/** \internal \brief Links a sentinel node to its bucket list.
+	 *
+	 * This is the variant for \c Traits::lazy_buckets, in which the bucket
+	 * following a sentinel may not have been constructed yet, and for
+	 * \c Traits::prefetch_distance, which needs the bounds of the list.
+	 */
+	template<typename Dummy>
+	struct bucket_list_link<true, Dummy> {
+		/// \internal \brief Links to \c list.
+		explicit bucket_list_link(const fixed_size_bucket_list *list) noexcept
+		: list(list) {}
+
+		/** \internal \brief Finds the first constructed bucket.
+		 *
+		 * Buckets which have not been constructed are empty, so traversals
+		 * skip them rather than constructing them.
+		 *
+		 * \param bucket The bucket to start at, or \c nullptr.
+		 *
+		 * \return The first constructed bucket at or after \c bucket, or
+		 *     \c nullptr if there is none.
+		 */
+		typename node::bucket_pointer constructed_from(
+			typename node::bucket_pointer bucket
+		) const noexcept {
+			return Traits::lazy_buckets
+				? list->constructed_from(bucket)
+				: bucket;
+		}
+
+		/** \internal \brief Prefetches buckets ahead of a bucket.
+		 *
+		 * \param following The bucket following the sentinel, or \c nullptr.
+		 */
+		void prefetch_ahead(
+			typename node::bucket_pointer following
+		) const noexcept {
+			if (following) {
+				list->prefetch_ahead(following - 1);
 			}
 		}
 
+		/// \internal \brief The bucket list of the sentinel.
+		const fixed_size_bucket_list *list;
+	};
+
+	/** \internal \brief Represents the sentinel node of a bucket.
+	 *
+	 * Sentinels are embedded into their buckets, so they are neither allocated
+	 * individually nor owned by any \c node_pointer. Pointers to them are
+	 * created using the aliasing constructor of \c std::shared_ptr with an
+	 * empty owner; they compare equal to each other, so they can take part in
+	 * atomic compare and swap operations just like any other node pointer.
+	 */
+	struct sentinel_node
+	: node
+	, bucket_list_link<Traits::lazy_buckets || Traits::prefetch_distance> {
+		/** \internal \brief Creates a sentinel node.
+		 *
+		 * \param following_bucket A pointer to the next bucket or \c nullptr
+		 *     if no bucket follows.
+		 * \param list The bucket list of the sentinel.
+		 *
+		 * \note While following_bucket needs to point to the location of the
+		 *     next bucket, the bucket it not accessed from this function and
+		 *     thus does not (yet) need to exist.
+		 */
+		sentinel_node(
+			typename node::bucket_pointer following_bucket,
+			const fixed_size_bucket_list *list
+		) noexcept
+		: node()
+		, bucket_list_link<
+			Traits::lazy_buckets || Traits::prefetch_distance
+		>(list)
+		, following_bucket(following_bucket)
+		, first_hint(nullptr) {}
+
+		// sentinels are bound to their bucket
+		sentinel_node(const sentinel_node &) = delete;
+		sentinel_node &operator=(const sentinel_node &) = delete;
+
+		/// \internal \brief A pointer to the following bucket, if any.
+		const typename node::bucket_pointer following_bucket;
+
+		/** \internal \brief The first node of the bucket, as far as known.
+		 *
+		 * This is only used to prefetch the first node of the bucket without
+		 * taking a reference to it, so it may be outdated and must never be
+		 * dereferenced.
+		 */
+		mutable std::atomic<const node *> first_hint;
+	};
+
+	/** \internal \brief Storage for a data node embedded into a bucket.
+	 *
+	 * This is the disabled variant, which does not take up any space and
+	 * leaves all node allocations to the allocator of the \c hash_map.
+	 *
+	 * \tparam Enabled Whether buckets embed storage for a data node.
+	 */
+	template<bool Enabled, typename = void>
+	struct inline_node_slot {
+		/// \internal \brief Returns \c allocator.
+		const allocator_type &node_allocator(
+			const allocator_type &allocator
+		) const noexcept {
+			return allocator;
+		}
+
+		/// \internal \brief Returns \c false.
+		bool stores(const node *) const noexcept {
+			return false;
+		}
+	};
+
+	/** \internal \brief Storage for a data node embedded into a bucket.
+	 *
+	 * The storage is large enough to hold a data node along with the control
+	 * block of its \c node_pointer. It is handed out by \ref slot_allocator
+	 * to the first data node allocated while the slot is free, so lookups
+	 * find that node right next to the sentinel of the bucket instead of at
+	 * some unrelated heap location. All other nodes are allocated by the
+	 * allocator of the \c hash_map.
+	 */
+	template<typename Dummy>
+	struct inline_node_slot<true, Dummy> {
+		/** \internal \brief Allocates from an inline node slot if possible.
+		 *
+		 * Single objects are placed into the slot if it is free and large
+		 * enough, all other allocations are forwarded to the allocator of the
+		 * \c hash_map.
+		 *
+		 * \tparam U The type to allocate.
+		 */
+		template<typename U>
+		struct slot_allocator {
+			/// \internal \brief The type to allocate.
+			typedef U value_type;
+
+			/// \internal \brief Obtains the allocator for another type.
+			template<typename V>
+			struct rebind {
+				/// \internal \brief The allocator for \c V.
+				typedef slot_allocator<V> other;
+			};
+
+			/** \internal \brief Creates an allocator.
+			 *
+			 * \param allocator The allocator to forward to.
+			 * \param slot The slot to allocate from.
+			 */
+			slot_allocator(
+				const allocator_type &allocator,
+				const inline_node_slot *slot
+			) noexcept
+			: allocator(allocator)
+			, slot(slot) {}
+
+			/// \internal \brief Copies an allocator.
+			slot_allocator(const slot_allocator &) noexcept = default;
+
+			/// \internal \brief Assigns an allocator.
+			slot_allocator &operator=(const slot_allocator &) noexcept = default;
+
+			/// \internal \brief Copies an allocator for another type.
+			template<typename V>
+			slot_allocator(const slot_allocator<V> &other) noexcept
+			: allocator(other.allocator)
+			, slot(other.slot) {}
+
+			/// \internal \brief Allocates storage for \c n objects.
+			U *allocate(std::size_t n) {
+				if (n == 1) {
+					if (void *p = slot->claim(sizeof(U), alignof(U))) {
+						return static_cast<U *>(p);
+					}
+				}
+				rebound_allocator a(allocator);
+				return std::allocator_traits<rebound_allocator>::allocate(a, n);
+			}
+
+			/// \internal \brief Deallocates storage for \c n objects.
+			void deallocate(U *p, std::size_t n) noexcept {
+				if (!slot->release(p)) {
+					rebound_allocator a(allocator);
+					std::allocator_traits<rebound_allocator>::deallocate(a, p, n);
+				}
+			}
+
+			/// \internal \brief Compares two allocators.
+			template<typename V>
+			bool operator==(const slot_allocator<V> &other) const noexcept {
+				return slot == other.slot && allocator == other.allocator;
+			}
+
+			/// \internal \brief Compares two allocators.
+			template<typename V>
+			bool operator!=(const slot_allocator<V> &other) const noexcept {
+				return !operator==(other);
+			}
+
+			/// \internal \brief The allocator to forward to.
+			allocator_type allocator;
+
+			/// \internal \brief The slot to allocate from.
+			const inline_node_slot *slot;
+
+		private:
+			/// \internal \brief The allocator to forward to, rebound to \c U.
+			typedef typename std::allocator_traits<allocator_type>
+				::template rebind_alloc<U> rebound_allocator;
+		};
+
+		/// \internal \brief Initializes an unused slot.
+		inline_node_slot() noexcept
+		: claimed(false) {}
+
+		// the slot is bound to its bucket
+		inline_node_slot(const inline_node_slot &) = delete;
+		inline_node_slot &operator=(const inline_node_slot &) = delete;
+
+		/// \internal \brief Destroys the slot.
+		~inline_node_slot() noexcept {
+			assert( !claimed.load(std::memory_order_relaxed)
+				&& "inline node must not outlive its bucket" );
+		}
+
+		/** \internal \brief Creates an allocator for data nodes.
+		 *
+		 * \param allocator The allocator to use if the slot is not available.
+		 *
+		 * \return An allocator using this slot, if possible.
+		 */
+		slot_allocator<data_node> node_allocator(
+			const allocator_type &allocator
+		) const noexcept {
+			return slot_allocator<data_node>(allocator, this);
+		}
+
+		/** \internal \brief Checks whether a node is stored in this slot.
+		 *
+		 * \param pnode The node to check.
+		 *
+		 * \return
+		 *     - \c true if \c pnode is stored in this slot,
+		 *     - \c false otherwise.
+		 */
+		bool stores(const node *pnode) const noexcept {
+			const char *p = reinterpret_cast<const char *>(pnode);
+			return std::less_equal<const char *>()(storage, p) &&
+				std::less<const char *>()(p, storage + sizeof(storage));
+		}
+
 	private:
-		/** \internal \brief Indicates whether this nodes \c data_ member contains a
-		 *     \c value_type object.
+		/** \internal \brief Claims the slot.
 		 *
-		 * \note Also governs whether the node is seen as a sentinel node or
-		 *     a data node: A node is a data node iff initialized is true.
+		 * \param size The number of bytes requested.
+		 * \param alignment The alignment requested.
+		 *
+		 * \return A pointer to the storage, or \c nullptr if the request
+		 *     does not fit or the slot is in use.
 		 */
-		bool initialized;
+		void *claim(std::size_t size, std::size_t alignment) const noexcept {
+			if (
+				size <= sizeof(storage) &&
+				alignment <= alignof(storage_alignment) &&
+				!claimed.load(std::memory_order_relaxed) &&
+				!claimed.exchange(true, std::memory_order_acquire)
+			) {
+				return storage;
+			}
+			return nullptr;
+		}
 
-		/** \internal
-		 * \brief Aligned storage for \c value_type.
+		/** \internal \brief Releases the slot.
+		 *
+		 * \param p The pointer to release.
+		 *
+		 * \return
+		 *     - \c true if \c p was the storage of this slot,
+		 *     - \c false otherwise.
+		 */
+		bool release(const void *p) const noexcept {
+			if (p != storage) {
+				return false;
+			}
+			claimed.store(false, std::memory_order_release);
+			return true;
+		}
+
+		/// \internal \brief The alignment of the storage.
+		struct alignas(std::max_align_t) alignas(data_node) storage_alignment {};
+
+		/// \internal \brief Whether the storage is in use.
+		mutable std::atomic<bool> claimed;
+
+		/** \internal \brief The storage for a node.
 		 *
-		 * Doubles as the storage for a pointer to the next bucket
-		 * in sentinel nodes to allow for lightweight iterators.
+		 * Leaves room for the control block of the \c node_pointer, which
+		 * typically consists of a vtable pointer, two reference counts and
+		 * the allocator.
 		 */
-		alignas(value_type) alignas(bucket_pointer)
-			char data_[std::max(sizeof(value_type), sizeof(bucket_pointer))];
+		alignas(storage_alignment) mutable char storage[
+			sizeof(data_node) + sizeof(allocator_type) + 5 * sizeof(void *)
+		];
 	};
 
-	/// \internal \brief Represents a bucket list.
-	struct fixed_size_bucket_list {
-		/// \internal \brief Stores a list of nodes for a reduced hash.
-		struct bucket {
-			/** \internal \brief Creates a bucket.
+	/// \internal \brief Represents a bucket list.
+	struct fixed_size_bucket_list {
+		/** \internal \brief A sorted index over the nodes of a long bucket.
+		 *
+		 * The index is an immutable snapshot of the data nodes of a bucket
+		 * sorted by their hash, so a lookup can find the nodes with a
+		 * specific hash by binary search instead of traversing the bucket.
+		 *
+		 * Nodes are never removed from the index: Instead, candidates found
+		 * are checked for being deleted. Nodes inserted after the index was
+		 * built all come after \c tail, as long as \c tail itself is not
+		 * deleted, because insertions only take place at the end of a bucket.
+		 */
+		struct sorted_index {
+			/// \internal \brief An index entry: a node and its hash.
+			typedef std::pair<hash_type, node_pointer> entry;
+
+			/// \internal \brief The allocator for index entries.
+			typedef typename std::allocator_traits<allocator_type>
+				::template rebind_alloc<entry> entry_allocator_type;
+
+			/** \internal \brief Creates an empty index.
+			 *
+			 * \param allocator The allocator to use for the entries.
+			 * \param changes The change count of the bucket at the time the
+			 *     index is built.
+			 */
+			sorted_index(const allocator_type &allocator, size_type changes)
+			: entries(entry_allocator_type(allocator))
+			, tail()
+			, changes(changes)
+			, rebuild_after(0) {}
+
+			/** \internal \brief Finds an indexed data node by its key.
+			 *
+			 * \param key The key to look for.
+			 * \param key_hash The hash of \c key.
+			 * \param keycomp A comparator for key equality comparison.
+			 *
+			 * \return A pointer to the indexed data node with the key \c key
+			 *     that is not deleted, or \c nullptr if there is none.
+			 */
+			node_pointer find(
+				const key_type &key,
+				hash_type key_hash,
+				const key_equal &keycomp
+			) const {
+				auto candidate = std::lower_bound(
+					entries.begin(), entries.end(), key_hash,
+					[](const entry &e, hash_type h) { return e.first < h; }
+				);
+				for(; candidate != entries.end() && candidate->first == key_hash; ++candidate) {
+					const node_pointer &cur = candidate->second;
+					if (
+						!std::atomic_load(&cur->next)->is_marker() &&
+						keycomp(key, cur->data().first)
+					) {
+						return cur;
+					}
+				}
+				return nullptr;
+			}
+
+			/// \internal \brief The indexed nodes, sorted by their hashes.
+			std::vector<entry, entry_allocator_type> entries;
+
+			/// \internal \brief The last node in the bucket when indexing.
+			node_pointer tail;
+
+			/// \internal \brief The change count of the bucket when indexing.
+			const size_type changes;
+
+			/** \internal \brief The number of changes after which the index
+			 *     is rebuilt.
+			 *
+			 * Nodes inserted since indexing need to be traversed, so the
+			 * index must not grow too old. Choosing the square root of the
+			 * number of nodes balances the costs of these traversals and the
+			 * costs of rebuilding.
+			 */
+			size_type rebuild_after;
+		};
+
+		/// \internal \brief A smart pointer to an index.
+		typedef std::shared_ptr<const sorted_index> index_pointer;
+
+		/** \internal \brief The alignment of buckets.
+		 *
+		 * This is \c Traits::bucket_alignment, unless the members of a
+		 * bucket require a stricter alignment.
+		 */
+		static constexpr std::size_t bucket_alignment = std::max({
+			Traits::bucket_alignment,
+			alignof(inline_node_slot<Traits::inline_first_node>),
+			alignof(sentinel_node),
+			alignof(node_pointer),
+			alignof(index_pointer),
+			alignof(std::atomic<size_type>)
+		});
+
+		/// \internal \brief Stores a list of nodes for a reduced hash.
+		struct alignas(bucket_alignment) bucket
+		: inline_node_slot<Traits::inline_first_node> {
+			/** \internal \brief Creates a bucket.
+			 *
+			 * \param is_last Whether this is the last bucket in the list.
+			 * \param list The list the bucket belongs to.
+			 */
+			bucket(bool is_last, const fixed_size_bucket_list *list)
+			: sentinel_storage(
+				/* following_bucket = */ is_last ? nullptr : this + 1,
+				list
+			)
+			, sentinel(node_pointer(), &sentinel_storage)
+			, size(0)
+			, changes(0)
+			, indexed(false)
+			, indexing(false)
+			, index() {
+				// the sentinel does not own itself, so the circle can be
+				// closed without creating a cyclic structure of owning
+				// pointers.
+				sentinel->next = sentinel;
+			}
+
+			// can't copy or assign buckets
+			bucket(const bucket &) = delete;
+			bucket &operator=(const bucket &) = delete;
+
+			/** \internal
+			 * \brief Destroys the bucket.
+			 *
+			 * All nodes held by the bucket are unlinked and, if not held by
+			 * another entity, destructed in the process.
+			 */
+			~bucket() {
+				index.reset();
+
+				node_pointer current = sentinel;
+				while(current) {
+					node_pointer next = current->next;
+					current->next = nullptr;
+					current = next;
+				}
+			}
+
+			/** \internal \brief Creates a data node for this bucket.
+			 *
+			 * If \c Traits::inline_first_node is enabled and the inline slot
+			 * of this bucket is free, the node is created inside the bucket.
+			 *
+			 * \tparam Args Types of arguments passed to the constructor of
+			 *     \c value_type.
+			 *
+			 * \param allocator The allocator to use if the node is not
+			 *     created inside the bucket.
+			 * \param key_hash The hash of the key of the constructed element.
+			 * \param args These arguments are forwarded to the constructor
+			 *     of \c value_type.
+			 *
+			 * \return A \c node_pointer to the new node.
+			 *
+			 * \note The node is not linked into the bucket.
+			 */
+			template<typename... Args>
+			node_pointer create_node(
+				const allocator_type &allocator,
+				hash_type key_hash,
+				Args&&... args
+			) const {
+				return node::create_with_data(
+					this->node_allocator(allocator),
+					allocator,
+					key_hash,
+					std::forward<Args>(args)...
+				);
+			}
+
+			/** \internal \brief Finds the node for a key.
+			 *
+			 * Logically deleted nodes encountered on the way are unlinked
+			 * from the bucket, so the nodes returned are always adjacent at
+			 * the time they were observed.
+			 *
+			 * \param key The key to look for.
+			 * \param key_hash The hash of \c key.
+			 * \param keycomp A comparator for key equality comparison.
+			 * \param[out] prev A node_pointer to store a pointer to the
+			 *     node before the found one in.
+			 * \param[out] cur A node_pointer to store a pointer to the
+			 *     found node in.
+			 *
+			 * \return
+			 *     - \c true if \c key was found in the bucket,
+			 *     - \c false if \c key was <em>not</em> found in the bucket.
+			 *
+			 * \post
+			 *     - <tt>prev->next == cur</tt>, conceptually. This may change
+			 *         if either node is concurrently removed.
+			 *     - \c prev is not a marker node and \c cur is neither a
+			 *         marker node nor marked for deletion, conceptually.
+			 *     - iff the return value is \c true:
+			 *         <tt>cur->is_sentinel() == false</tt> and
+			 *         <tt>keycomp(key, cur.data().first) == true</tt>.
+			 *         If \c cur was found through the index of the bucket,
+			 *         its predecessor is not known and \c prev is empty.
+			 *     - iff the return value is \c false:
+			 *         <tt>cur->is_sentinel() == true</tt> and
+			 *         <tt>cur == sentinel</tt>.
+			 */
+			bool find(
+				const key_type &key,
+				hash_type key_hash,
+				const key_equal &keycomp,
+				node_pointer &prev,
+				node_pointer &cur
+			) const {
+				bool found;
+				if (indexed.load(std::memory_order_acquire)) {
+					if (index_pointer idx = std::atomic_load(&index)) {
+						if ((cur = idx->find(key, key_hash, keycomp))) {
+							cur->record_hit();
+							prev = nullptr;
+							return true;
+						}
+						// not indexed; but maybe inserted since indexing
+						if (find_after(idx->tail, key, key_hash, keycomp, prev, cur, found)) {
+							return found;
+						}
+						// idx->tail has been deleted; fall back to a full
+						// traversal.
+					}
+				}
+
+				find_after(sentinel, key, key_hash, keycomp, prev, cur, found);
+				return found;
+			}
+
+			/** \internal \brief Looks up the node for a key.
+			 *
+			 * Other than \ref find(), this function never modifies the
+			 * bucket and never restarts: Logically deleted nodes are simply
+			 * stepped over, so concurrent erase operations can not keep it
+			 * from making progress.
+			 *
+			 * \param key The key to look for.
+			 * \param key_hash The hash of \c key.
+			 * \param keycomp A comparator for key equality comparison.
+			 *
+			 * \return A pointer to the data node with the key \c key, or the
+			 *     sentinel if no such node exists in the bucket.
+			 */
+			node_pointer lookup(
+				const key_type &key,
+				hash_type key_hash,
+				const key_equal &keycomp
+			) const {
+				node_pointer cur;
+				if (indexed.load(std::memory_order_acquire)) {
+					if (index_pointer idx = std::atomic_load(&index)) {
+						if ((cur = idx->find(key, key_hash, keycomp))) {
+							cur->record_hit();
+							return cur;
+						}
+						cur = std::atomic_load(&idx->tail->next);
+						if (cur->is_marker()) {
+							// idx->tail has been deleted; fall back to a full
+							// traversal.
+							cur = nullptr;
+						}
+					}
+				}
+				if (!cur) {
+					cur = std::atomic_load(&sentinel->next);
+				}
+
+				while(!cur->is_sentinel()) {
+					node_pointer next = std::atomic_load(&cur->next);
+					if (next->is_marker()) {
+						// cur has been logically deleted: skip it.
+						cur = next->next;
+					}
+					else if (
+						cur->key_hash == key_hash &&
+						keycomp(key, cur->data().first)
+					) {
+						cur->record_hit();
+						break;
+					}
+					else {
+						cur = std::move(next);
+					}
+				}
+				return cur;
+			}
+
+			/** \internal
+			 * \brief Sorts the nodes of the bucket by their number of hits.
+			 *
+			 * Nodes with more hits are moved to the front. The order of
+			 * nodes with the same number of hits is preserved. Afterwards,
+			 * the number of hits of all nodes is halved, so the order can
+			 * adapt to changing access patterns.
+			 *
+			 * \param allocator The allocator to use for a new index.
+			 *
+			 * \note This function is not thread safe.
+			 */
+			void reorder_by_hits(const allocator_type &allocator) {
+				node_pointer rest = sentinel->next_live();
+				sentinel->next = sentinel;
+
+				// insertion sort - allocation free and fast enough for the
+				// short lists buckets are supposed to hold.
+				while(!rest->is_sentinel()) {
+					node_pointer cur = std::move(rest);
+					rest = cur->next_live();
+
+					const std::uint32_t hits = cur->hits();
+					node_pointer prev = sentinel;
+					while(
+						!prev->next->is_sentinel() &&
+						hits <= prev->next->hits()
+					) {
+						prev = prev->next;
+					}
+					cur->next = prev->next;
+					prev->next = cur;
+					update_first_hint(*prev, cur);
+				}
+
+				for(
+					node_pointer cur = sentinel->next;
+					!cur->is_sentinel();
+					cur = cur->next
+				) {
+					cur->decay_hits();
+				}
+
+				if (indexed.load(std::memory_order_relaxed)) {
+					// the tail of the index may have moved anywhere
+					drop_index();
+				}
+				update_index(allocator);
+			}
+
+			/** \internal \brief Records a successful insertion or erasure.
+			 *
+			 * \param delta \c 1 for an insertion, <tt>-1</tt> for an erasure.
+			 * \param allocator The allocator to use for a new index.
+			 */
+			void count_change(int delta, const allocator_type &allocator) const {
+				if (0 < delta) {
+					++size;
+				}
+				else {
+					--size;
+				}
+				++changes;
+				update_index(allocator);
+			}
+
+			/** \internal \brief Builds, rebuilds or drops the index as needed.
 			 *
-			 * \param allocator The allocator to use for allocating the
-			 *     sentinel nodes.
-			 * \param is_last Whether this is the last bucket in the list.
+			 * A bucket gets indexed when it grows to
+			 * \c Traits::index_threshold nodes and stops being indexed when
+			 * it shrinks below \c Traits::unindex_threshold nodes. In between,
+			 * the index is rebuilt when the bucket has changed too much since
+			 * it was built or when its tail has been deleted.
+			 *
+			 * \param allocator The allocator to use for a new index.
+			 *
+			 * \note If the index can not be built due to a lack of memory, the
+			 *     bucket is simply left without an index.
 			 */
-			bucket(const allocator_type &allocator, bool is_last)
-			: sentinel(node::create_sentinel(
-				allocator,
-				/* next_bucket = */ is_last
-					? nullptr
-					: this + 1
-			)) {
-				// introducing a cyclic structure of owning pointers -
-				// however on destruction of the bucket, all nodes in it will
-				// get unlinked, so this won't leak.
-				sentinel->next = sentinel;
+			void update_index(const allocator_type &allocator) const {
+				if (0 == Traits::index_threshold) {
+					return;
+				}
+
+				const size_type current_size = approximate_size();
+				if (!indexed.load(std::memory_order_acquire)) {
+					if (Traits::index_threshold <= current_size) {
+						build_index(allocator);
+					}
+				}
+				else if (current_size < Traits::unindex_threshold) {
+					drop_index();
+				}
+				else if (index_pointer idx = std::atomic_load(&index)) {
+					if (
+						idx->rebuild_after <
+							changes.load(std::memory_order_relaxed) - idx->changes ||
+						std::atomic_load(&idx->tail->next)->is_marker()
+					) {
+						build_index(allocator);
+					}
+				}
 			}
 
-			// can't copy or assign buckets
-			bucket(const bucket &) = delete;
-			bucket &operator=(const bucket &) = delete;
+		private:
+			/// \internal \brief Storage for the sentinel node of the bucket.
+			sentinel_node sentinel_storage;
 
-			/** \internal
-			 * \brief Destroys the bucket.
+		public:
+			/** \internal \brief A sentinel node representing the front of the
+			 *      node list held by the bucket.
 			 *
-			 * All nodes held by the bucket are unlinked and, if not held by
-			 * another entity, destructed in the process.
+			 * This is a non-owning pointer to \ref sentinel_storage.
 			 */
-			~bucket() {
-				node_pointer current = sentinel;
-				while(current) {
-					node_pointer next = current->next;
-					current->next = nullptr;
-					current = next;
-				}
+			const node_pointer sentinel;
+
+			/** \internal \brief The number of data nodes in the bucket.
+			 *
+			 * This may be off by the number of operations in progress and
+			 * even become negative for a moment, as an erase operation may
+			 * count its change before the insert operation of the same node.
+			 */
+			mutable std::atomic<difference_type> size;
+
+		private:
+			/// \internal \brief Returns \ref size, but no less than \c 0.
+			size_type approximate_size() const noexcept {
+				return static_cast<size_type>(std::max<difference_type>(
+					0, size.load(std::memory_order_relaxed)
+				));
 			}
 
-			/** \internal \brief Finds the node for a key.
+			/** \internal \brief Finds the node for a key after a given node.
+			 *
+			 * This implements \ref find() for a traversal starting after
+			 * \c head.
 			 *
+			 * \param head The node to start the traversal after.
 			 * \param key The key to look for.
+			 * \param key_hash The hash of \c key.
 			 * \param keycomp A comparator for key equality comparison.
-			 * \param[out] prev A node_pointer to store a pointer to the
-			 *     node before the found one in.
-			 * \param[out] cur A node_pointer to store a pointer to the
-			 *     found node in.
+			 * \param[out] prev See \ref find().
+			 * \param[out] cur See \ref find().
+			 * \param[out] found The result of \ref find().
 			 *
 			 * \return
-			 *     - \c true if \c key was found in the bucket,
-			 *     - \c false if \c key was <em>not</em> found in the bucket.
-			 *
-			 * \post
-			 *     - <tt>prev->next == cur</tt>, conceptually. This may change
-			 *         if either node is concurrently removed.
-			 *     - iff the return value is \c true:
-			 *         <tt>cur->is_sentinel() == false</tt> and
-			 *         <tt>keycomp(key, cur.data().first) == true</tt>.
-			 *     - iff the return value is \c false:
-			 *         <tt>cur->is_sentinel() == true</tt> and
-			 *         <tt>cur == sentinel</tt>.
+			 *     - \c true if the traversal has been completed,
+			 *     - \c false if \c head has been deleted, in which case the
+			 *         traversal can not be completed. This will never happen
+			 *         if \c head is the sentinel.
 			 */
-			bool find(
+			bool find_after(
+				const node_pointer &head,
 				const key_type &key,
+				hash_type key_hash,
 				const key_equal &keycomp,
 				node_pointer &prev,
-				node_pointer &cur
+				node_pointer &cur,
+				bool &found
 			) const {
 				while(true) {
-					prev = sentinel;
-					while(cur = std::atomic_load(&prev->next)) {
-						if (cur->is_sentinel()) {
-							assert(cur == this->sentinel
-								&& "encountered alien sentinel node!");
-							return false;
+					prev = head;
+					cur = std::atomic_load(&prev->next);
+					if (cur->is_marker()) {
+						return false;
+					}
+					while(!cur->is_sentinel()) {
+						assert( !cur->is_marker()
+							&& "markers must only be reached through their "
+								"deleted predecessor!" );
+
+						node_pointer next = std::atomic_load(&cur->next);
+						if (next->is_marker()) {
+							// cur has been logically deleted. Markers never
+							// change, so help the eraser by unlinking cur, but
+							// ONLY if prev still refers to it: prev may have
+							// been deleted in the meantime, and then it's prevs
+							// predecessor we would need to work on instead.
+							node_pointer expected = cur;
+							if (!relink(prev, expected, next->next)) {
+								break;
+							}
+							cur = next->next;
 						}
-						else if (keycomp(key, cur->data().first)) {
+						else if (
+							cur->key_hash == key_hash &&
+							keycomp(key, cur->data().first)
+						) {
+							cur->record_hit();
+							found = true;
 							return true;
 						}
 						else {
-							prev = cur;
+							prev = std::move(cur);
+							cur = std::move(next);
 						}
 					}
-					// cur is nullptr: we ran into a node in the process of
-					//     being unlinked.
-					// -> try again from the start ... in a moment
-					std::this_thread::yield();
+
+					if (cur->is_sentinel()) {
+						assert(cur == this->sentinel
+							&& "encountered alien sentinel node!");
+						found = false;
+						return true;
+					}
+					// prev was deleted while we were trying to unlink its
+					// successor, so we lost our foothold in the bucket.
+					// -> try again from the start
 				}
 			}
 
-			/// \internal \brief A sentinel node representing the front of the
-			///     node list held by the bucket.
-			const node_pointer sentinel;
+			/** \internal \brief Builds a new index for the bucket.
+			 *
+			 * Deleted nodes that have not been unlinked yet are unlinked in
+			 * the process. If another thread is updating the index at the
+			 * same time, this function does nothing.
+			 *
+			 * \param allocator The allocator to use for the new index.
+			 */
+			void build_index(const allocator_type &allocator) const {
+				if (indexing.exchange(true, std::memory_order_acquire)) {
+					return; // someone else is on it
+				}
+
+				try {
+					std::shared_ptr<sorted_index> idx
+						= std::allocate_shared<sorted_index>(
+							allocator,
+							allocator,
+							changes.load(std::memory_order_relaxed)
+						);
+					idx->entries.reserve(approximate_size());
+
+					node_pointer prev, cur;
+					do {
+						idx->entries.clear();
+						prev = sentinel;
+						cur = std::atomic_load(&prev->next);
+						while(!cur->is_sentinel()) {
+							node_pointer next = std::atomic_load(&cur->next);
+							if (next->is_marker()) {
+								// unlink, like find() does; restart on failure
+								node_pointer expected = cur;
+								if (!relink(prev, expected, next->next)) {
+									break;
+								}
+								cur = next->next;
+							}
+							else {
+								idx->entries.emplace_back(cur->key_hash, cur);
+								prev = std::move(cur);
+								cur = std::move(next);
+							}
+						}
+					} while(!cur->is_sentinel());
+
+					std::sort(
+						idx->entries.begin(), idx->entries.end(),
+						[](
+							const typename sorted_index::entry &lhs,
+							const typename sorted_index::entry &rhs
+						) {
+							return lhs.first < rhs.first;
+						}
+					);
+					idx->tail = prev; // the last node that was not deleted
+					idx->rebuild_after = 2 * static_cast<size_type>(std::sqrt(
+						static_cast<double>(idx->entries.size())
+					));
+
+					std::atomic_store(&index, index_pointer(std::move(idx)));
+					indexed.store(true, std::memory_order_release);
+				}
+				catch(const std::bad_alloc &) {
+					// the index is an optimization only
+				}
+
+				indexing.store(false, std::memory_order_release);
+			}
+
+			/** \internal \brief Drops the index of the bucket.
+			 *
+			 * If another thread is updating the index at the same time, this
+			 * function does nothing.
+			 */
+			void drop_index() const {
+				if (indexing.exchange(true, std::memory_order_acquire)) {
+					return; // someone else is on it
+				}
+
+				indexed.store(false, std::memory_order_relaxed);
+				std::atomic_store(&index, index_pointer());
+
+				indexing.store(false, std::memory_order_release);
+			}
+
+			/// \internal \brief The number of insertions and erasures so far.
+			mutable std::atomic<size_type> changes;
+
+			/// \internal \brief Whether the bucket currently has an index.
+			mutable std::atomic<bool> indexed;
+
+			/// \internal \brief Whether the index is being updated.
+			mutable std::atomic<bool> indexing;
+
+			/// \internal \brief The index of the bucket, if any.
+			mutable index_pointer index;
 		};
 
 		/// \internal \brief The allocator for buckets.
@@ -1714,6 +3992,15 @@ private:
 		typedef typename std::allocator_traits<allocator_type>
 			::template rebind_traits<bucket> bucket_allocator_traits;
 
+		/// \internal \brief The allocator for the memory of the buckets.
+		typedef typename std::allocator_traits<allocator_type>
+			::template rebind_alloc<char> storage_allocator_type;
+
+		/// \internal \brief The allocator traits for the memory of the
+		///     buckets.
+		typedef typename std::allocator_traits<allocator_type>
+			::template rebind_traits<char> storage_allocator_traits;
+
 		/** \internal
 		 * \brief Creates a bucket list.
 		 *
@@ -1735,24 +4022,40 @@ private:
 
 		/** \internal \brief Creates a bucket list.
 		 *
-		 * \param bucket_count The number of buckets in this list.
+		 * \param requested_bucket_count The number of buckets requested for
+		 *     this list. The bucket index policy may round it up.
 		 * \param hash The hash function used for keys.
 		 * \param keycomp The comparison function used for keys.
 		 * \param allocator The allocator to use for allocating the buckets.
 		 */
 		fixed_size_bucket_list(
-			size_type bucket_count,
+			size_type requested_bucket_count,
 			const hasher &hash,
 			const key_equal &keycomp,
 			const allocator_type &allocator
 		)
-		: bucket_count(bucket_count)
+		: bucket_index(requested_bucket_count)
+		, bucket_count(bucket_index.bucket_count())
 		, node_count(0)
 		, hash(hash)
 		, keycomp(keycomp)
 		, allocator(allocator)
 		, bucket_allocator(allocator)
-		, buckets(bucket_allocator_traits::allocate(bucket_allocator, bucket_count)) {
+		, storage_allocator(allocator)
+		, storage(allocate_storage())
+		, states(Traits::lazy_buckets
+			? reinterpret_cast<bucket_state *>(storage + storage_size(bucket_count))
+			: nullptr
+		)
+		, retired()
+		, has_retired(false)
+		, reclaimed(0)
+		, buckets(align_buckets(storage)) {
+			if (Traits::lazy_buckets) {
+				// buckets are constructed by bucket_at()
+				return;
+			}
+
 			size_type n=0;
 			try {
 				// construct all buckets
@@ -1760,8 +4063,8 @@ private:
 					bucket_allocator_traits::construct(
 						bucket_allocator,
 						buckets + n,
-						this->allocator,
-						/* is_last = */ (bucket_count - n == 1)
+						/* is_last = */ (bucket_count - n == 1),
+						this
 					);
 				}
 			}
@@ -1775,9 +4078,7 @@ private:
 						bucket_allocator, buckets+n
 					);
 				}
-				bucket_allocator_traits::deallocate(
-					bucket_allocator, buckets, bucket_count
-				);
+				deallocate_storage();
 				throw;
 			}
 		}
@@ -1787,18 +4088,120 @@ private:
 
 		/// \internal \brief Destroys the bucket list.
 		~fixed_size_bucket_list() {
-			// destruct all buckets in reverse order
-			size_type n=bucket_count;
-			while(n) {
-				--n;
-				bucket_allocator_traits::destroy(
-					bucket_allocator, buckets+n
-				);
+			// all buckets but those destroyed by reclaim_buckets() already
+			const size_type first = reclaimed.load(std::memory_order_relaxed);
+			size_type last = bucket_count;
+
+			// large lists are split into disjoint ranges of buckets, all but
+			// the first of which are destroyed by helper threads
+			std::vector<std::thread> helpers;
+			const size_type work
+				= bucket_count - first + node_count.load(std::memory_order_relaxed);
+			if (
+				1 < Traits::destruction_threads &&
+				parallel_destruction_threshold <= work
+			) {
+				const size_type range_size
+					= (bucket_count - first) / Traits::destruction_threads + 1;
+				try {
+					helpers.reserve(Traits::destruction_threads - 1);
+					while(helpers.size() + 1 < Traits::destruction_threads) {
+						const size_type begin = (last - first < range_size)
+							? first
+							: last - range_size;
+						helpers.emplace_back([this, begin, last] {
+							destroy_buckets(begin, last);
+						});
+						last = begin;
+					}
+				}
+				catch(...) {
+					// no more threads; the remaining buckets are destroyed
+					// by this one
+				}
+			}
+
+			destroy_buckets(first, last);
+			for(auto &helper: helpers) {
+				helper.join();
+			}
+			deallocate_storage();
+		}
+
+		/** \internal \brief Retrieves a bucket by its index.
+		 *
+		 * If \c Traits::lazy_buckets is enabled, the bucket is constructed
+		 * if this is its first use. If several threads use a bucket for the
+		 * first time at once, one of them constructs it while the others
+		 * wait for it.
+		 *
+		 * \param n The index of the bucket.
+		 *
+		 * \return The bucket.
+		 */
+		const bucket &bucket_at(size_type n) const {
+			if (
+				Traits::lazy_buckets &&
+				states[n].load(std::memory_order_acquire) != bucket_constructed
+			) {
+				construct_bucket(n);
+			}
+			return buckets[n];
+		}
+
+		/** \internal \brief Checks whether a bucket has been constructed.
+		 *
+		 * \param n The index of the bucket.
+		 *
+		 * \return
+		 *     - \c true if the bucket can be accessed through \c buckets,
+		 *     - \c false if it has never been used, which means it is empty.
+		 */
+		bool is_constructed(size_type n) const noexcept {
+			return !Traits::lazy_buckets ||
+				states[n].load(std::memory_order_acquire) == bucket_constructed;
+		}
+
+		/** \internal \brief Finds the first constructed bucket.
+		 *
+		 * \param first The bucket to start at, or \c nullptr.
+		 *
+		 * \return The first constructed bucket at or after \c first, or
+		 *     \c nullptr if there is none.
+		 */
+		const bucket *constructed_from(const bucket *first) const noexcept {
+			if (first) {
+				for(size_type n = size_type(first - buckets); n < bucket_count; ++n) {
+					if (is_constructed(n)) {
+						return buckets + n;
+					}
+				}
+			}
+			return nullptr;
+		}
+
+		/** \internal \brief Prefetches the buckets ahead of a bucket.
+		 *
+		 * The target is computed from the index of \c current, so no bucket
+		 * in between is touched. The first node of the bucket
+		 * \c Traits::prefetch_distance buckets ahead is prefetched through
+		 * its hint, which has been prefetched along with its bucket one
+		 * distance earlier; the bucket twice as far ahead is prefetched for
+		 * the next round.
+		 *
+		 * \param current The bucket currently visited.
+		 */
+		void prefetch_ahead(const bucket *current) const noexcept {
+			const size_type n = size_type(current - buckets)
+				+ Traits::prefetch_distance;
+			if (n + Traits::prefetch_distance < bucket_count) {
+				prefetch(buckets + n + Traits::prefetch_distance);
+			}
+			if (n < bucket_count && is_constructed(n)) {
+				prefetch(static_cast<const sentinel_node *>(
+					buckets[n].sentinel.get()
+				)->first_hint.load(std::memory_order_relaxed));
 			}
-			// deallocate bucket list
-			bucket_allocator_traits::deallocate(
-				bucket_allocator, buckets, bucket_count
-			);
 		}
 
 		/** \internal \brief Retrieves the bucket for a specific key value.
@@ -1808,13 +4211,51 @@ private:
 		 * \return The bucket associated with the key passed.
 		 */
 		const bucket &bucket_for_key(const key_type &key) const {
-			return buckets[hash(key) % bucket_count];
+			return bucket_for_hash(hash(key));
+		}
+
+		/** \internal \brief Retrieves the bucket for a specific hash value.
+		 *
+		 * \param key_hash The hash of a key.
+		 *
+		 * \return The bucket associated with keys with the hash passed.
+		 */
+		const bucket &bucket_for_hash(hash_type key_hash) const {
+			return bucket_at(bucket_index(static_cast<std::size_t>(key_hash)));
+		}
+
+		/** \internal \brief Links a data node into its bucket.
+		 *
+		 * The node is inserted at the front of the bucket - behind a node
+		 * stored inside the bucket, though, so that node remains the first
+		 * one to be found.
+		 *
+		 * \param new_node The node to link.
+		 *
+		 * \warning This function is not thread safe. It is meant for
+		 *     populating bucket lists that are not yet visible to other
+		 *     threads.
+		 */
+		void link_front(const node_pointer &new_node) {
+			const bucket &target_bucket = bucket_for_hash(new_node->key_hash);
+
+			node_pointer after = target_bucket.sentinel;
+			if (target_bucket.stores(after->next.get())) {
+				after = after->next;
+			}
+			// moving avoids touching the reference count of the successor
+			new_node->next = std::move(after->next);
+			after->next = new_node;
+			update_first_hint(*after, new_node);
+			++target_bucket.size;
+			++node_count;
 		}
 
 
 		/** \internal \brief Finds the node for a key.
 		 *
 		 * \param key The key to look for.
+		 * \param key_hash The hash of \c key.
 		 * \param[out] prev A node_pointer to store a pointer to the
 		 *     node before the found one in.
 		 * \param[out] cur A node_pointer to store a pointer to the
@@ -1825,23 +4266,98 @@ private:
 		 *     - \c false if \c key was <em>not</em> found in the map.
 		 *
 		 * \post
-		 *     - <tt>prev->next == cur</tt>, conceptually. This may change
-		 *         if either node is concurrently removed.
-		 *     - iff the return value is \c true:
-		 *         <tt>cur->is_sentinel() == false</tt> and
-		 *         <tt>keycomp(key, cur.data().first) == true</tt>.
-		 *     - iff the return value is \c false:
-		 *         <tt>cur->is_sentinel() == true</tt> and
-		 *         <tt>cur == sentinel</tt>.
+		 *     - See \ref bucket::find().
 		 */
 		bool find(
 			const key_type &key,
+			hash_type key_hash,
 			node_pointer &prev,
 			node_pointer &cur
 		) const {
-			return bucket_for_key(key).find(key, keycomp, prev, cur);
+			return bucket_for_hash(key_hash).find(
+				key, key_hash, keycomp, prev, cur
+			);
+		}
+
+		/** \internal \brief Looks up the node for a key.
+		 *
+		 * \param key The key to look for.
+		 * \param key_hash The hash of \c key.
+		 *
+		 * \return A pointer to the data node with the key \c key, or the
+		 *     sentinel of its bucket if no such node exists.
+		 */
+		node_pointer lookup(const key_type &key, hash_type key_hash) const {
+			return bucket_for_hash(key_hash).lookup(key, key_hash, keycomp);
+		}
+
+		/** \internal \brief Estimates the memory held by the bucket list.
+		 *
+		 * \return The number of bytes of the list, its buckets and its
+		 *     nodes, not counting memory held by the elements themselves or
+		 *     by a retired list.
+		 */
+		std::size_t allocated_bytes() const noexcept {
+			return sizeof(*this)
+				+ storage_size(bucket_count)
+				+ (Traits::lazy_buckets ? bucket_count * sizeof(bucket_state) : 0)
+				+ node_count.load(std::memory_order_relaxed) * sizeof(data_node);
+		}
+
+		/** \internal \brief Hands over the bucket list replaced by this one.
+		 *
+		 * The buckets of \c previous are destroyed incrementally by
+		 * \ref reclaim_retired(), rather than all at once by the thread
+		 * releasing \c previous last.
+		 *
+		 * \param previous The bucket list replaced by this one.
+		 *
+		 * \warning This function is not thread safe. It is meant to be called
+		 *     before this bucket list is published.
+		 */
+		void retire(bucket_list_pointer previous) noexcept {
+			retired = std::move(previous);
+			has_retired.store(true, std::memory_order_release);
+		}
+
+		/** \internal \brief Destroys some buckets of the retired bucket list.
+		 *
+		 * Does nothing while other threads may still be using the retired
+		 * bucket list, i.e. while operations started before it was replaced
+		 * are in progress. Once all of its buckets are destroyed, the list is
+		 * released and the list it replaced in turn is reclaimed next.
+		 */
+		void reclaim_retired() {
+			if (
+				!Traits::incremental_clear ||
+				!has_retired.load(std::memory_order_relaxed)
+			) {
+				return;
+			}
+
+			bucket_list_pointer list = std::atomic_load(&retired);
+			// only this reference and our own are left, and as the retired
+			// list is not reachable through current_buckets anymore, no other
+			// thread can obtain a new reference but another reclaimer - which
+			// would then see three references and back off. Operations which
+			// dereference the nodes they found, like at(), keep their own
+			// reference until they are done.
+			if (!list || list.use_count() != 2) {
+				return;
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (list->reclaim_buckets(reclaim_batch_size)) {
+				bucket_list_pointer next = std::move(list->retired);
+				const bool has_next = bool(next);
+				if (std::atomic_compare_exchange_strong(&retired, &list, next)) {
+					has_retired.store(has_next, std::memory_order_relaxed);
+				}
+			}
 		}
 
+		const bucket_index_policy bucket_index;
+
 		/// \internal \brief The number of buckets in the list.
 		const size_type bucket_count;
 
@@ -1858,8 +4374,196 @@ private:
 		const allocator_type allocator;
 
 	private:
+		/** \internal \brief Determines the memory required for buckets.
+		 *
+		 * Allocators are not required to support over-aligned types, so
+		 * buckets are placed into a sufficiently large character array by
+		 * \ref align_buckets().
+		 *
+		 * \param bucket_count The number of buckets.
+		 *
+		 * \return The number of characters to allocate.
+		 */
+		static size_type storage_size(size_type bucket_count) noexcept {
+			return bucket_count * sizeof(bucket) + alignof(bucket) - 1;
+		}
+
+		/// \internal \brief The state of a bucket if \c Traits::lazy_buckets
+		///     is enabled.
+		typedef std::atomic<unsigned char> bucket_state;
+
+		/// \internal \brief A bucket that has not been used yet. As memory
+		///     is zero-filled, this must be \c 0.
+		static constexpr unsigned char bucket_unused = 0;
+
+		/// \internal \brief A bucket being constructed.
+		static constexpr unsigned char bucket_constructing = 1;
+
+		/// \internal \brief A constructed bucket.
+		static constexpr unsigned char bucket_constructed = 2;
+
+		/** \internal \brief Allocates the memory for the buckets.
+		 *
+		 * If \c Traits::lazy_buckets is enabled, this is zero-filled memory
+		 * from \c std::calloc, followed by a state for every bucket.
+		 * Otherwise, it is obtained from the allocator.
+		 *
+		 * \return Memory of \ref storage_size() characters, plus one
+		 *     \ref bucket_state per bucket if \c Traits::lazy_buckets is
+		 *     enabled.
+		 */
+		char *allocate_storage() {
+			if (Traits::lazy_buckets) {
+				void *p = std::calloc(
+					storage_size(bucket_count) + bucket_count * sizeof(bucket_state),
+					1
+				);
+				if (!p) {
+					throw std::bad_alloc();
+				}
+				return static_cast<char *>(p);
+			}
+			return storage_allocator_traits::allocate(
+				storage_allocator, storage_size(bucket_count)
+			);
+		}
+
+		/// \internal \brief Deallocates the memory for the buckets.
+		void deallocate_storage() noexcept {
+			if (Traits::lazy_buckets) {
+				std::free(storage);
+			}
+			else {
+				storage_allocator_traits::deallocate(
+					storage_allocator, storage, storage_size(bucket_count)
+				);
+			}
+		}
+
+		/** \internal \brief Destroys a range of buckets in reverse order.
+		 *
+		 * \param first The index of the first bucket to destroy.
+		 * \param last The index past the last bucket to destroy.
+		 *
+		 * \note Ranges which do not overlap can be destroyed by different
+		 *     threads at the same time.
+		 */
+		void destroy_buckets(size_type first, size_type last) noexcept {
+			size_type n=last;
+			while(n > first) {
+				--n;
+				if (!is_constructed(n)) {
+					continue;
+				}
+				if (
+					first + Traits::prefetch_distance <= n &&
+					is_constructed(n - Traits::prefetch_distance)
+				) {
+					prefetch(
+						buckets[n - Traits::prefetch_distance].sentinel->next.get()
+					);
+				}
+				bucket_allocator_traits::destroy(
+					bucket_allocator, buckets+n
+				);
+			}
+		}
+
+		/** \internal \brief Destroys the next few buckets of a retired list.
+		 *
+		 * \param count The maximum number of buckets to destroy.
+		 *
+		 * \return
+		 *     - \c true if all buckets have been destroyed,
+		 *     - \c false otherwise.
+		 *
+		 * \pre
+		 *     - No other thread uses this bucket list.
+		 */
+		bool reclaim_buckets(size_type count) {
+			size_type n = reclaimed.load(std::memory_order_relaxed);
+			const size_type last = (bucket_count - n < count)
+				? bucket_count
+				: n + count;
+			for(; n != last; ++n) {
+				if (is_constructed(n)) {
+					bucket_allocator_traits::destroy(
+						bucket_allocator, buckets+n
+					);
+				}
+				reclaimed.store(n + 1, std::memory_order_relaxed);
+			}
+			return last == bucket_count;
+		}
+
+		/** \internal \brief Constructs a bucket on its first use.
+		 *
+		 * \param n The index of the bucket.
+		 *
+		 * \post
+		 *     - <tt>is_constructed(n) == true</tt>
+		 */
+		void construct_bucket(size_type n) const {
+			unsigned char state = bucket_unused;
+			if (states[n].compare_exchange_strong(
+				state, bucket_constructing, std::memory_order_acquire
+			)) {
+				// constructing a bucket does not allocate and does not throw
+				bucket_allocator_traits::construct(
+					bucket_allocator,
+					buckets + n,
+					/* is_last = */ (bucket_count - n == 1),
+					this
+				);
+				states[n].store(bucket_constructed, std::memory_order_release);
+			}
+			else {
+				while(states[n].load(std::memory_order_acquire) != bucket_constructed) {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		/** \internal \brief Determines the location of the first bucket.
+		 *
+		 * \param storage Memory of \ref storage_size() characters.
+		 *
+		 * \return The first address in \c storage suitably aligned for a
+		 *     bucket.
+		 */
+		static bucket *align_buckets(char *storage) noexcept {
+			const std::uintptr_t mask = alignof(bucket) - 1;
+			const std::uintptr_t address
+				= reinterpret_cast<std::uintptr_t>(storage);
+			return reinterpret_cast<bucket *>(
+				storage + (((address + mask) & ~mask) - address)
+			);
+		}
+
+		/// \internal \brief The allocator used to construct buckets.
+		mutable bucket_allocator_type bucket_allocator;
+
 		/// \internal \brief The allocator used to handle bucket allocation.
-		bucket_allocator_type bucket_allocator;
+		storage_allocator_type storage_allocator;
+
+		/// \internal \brief The memory holding the buckets.
+		char * const storage;
+
+		/// \internal \brief The state of every bucket if
+		///     \c Traits::lazy_buckets is enabled, \c nullptr otherwise.
+		bucket_state * const states;
+
+		/// \internal \brief The bucket list replaced by this one, while its
+		///     buckets are being reclaimed. Accessed atomically.
+		bucket_list_pointer retired;
+
+		/// \internal \brief Whether \ref retired may be set. Checked before
+		///     accessing \ref retired, which is much more expensive.
+		std::atomic<bool> has_retired;
+
+		/// \internal \brief The number of leading buckets destroyed by
+		///     \ref reclaim_buckets().
+		std::atomic<size_type> reclaimed;
 
 	public:
 		/// \internal \brief A pointer to the start of the bucket list.
@@ -1880,6 +4584,7 @@ namespace std {
 	 * \tparam Hash The \c hasher of the \c hash_map.
 	 * \tparam KeyEqual The \c key_equal of the \c hash_map.
 	 * \tparam Allocator The \c allocator of the \c hash_map.
+	 * \tparam Traits The \c traits_type of the \c hash_map.
 	 *
 	 * \param lhs One hash_map.
 	 * \param rhs The other hash_map.
@@ -1894,11 +4599,11 @@ namespace std {
 	 */
 	template<
 		typename Key, typename T, typename Hash,
-		typename KeyEqual, typename Allocator
+		typename KeyEqual, typename Allocator, typename Traits
 	>
 	void swap(
-		::hash_map<Key, T, Hash, KeyEqual, Allocator> &lhs,
-		::hash_map<Key, T, Hash, KeyEqual, Allocator> &rhs
+		::hash_map<Key, T, Hash, KeyEqual, Allocator, Traits> &lhs,
+		::hash_map<Key, T, Hash, KeyEqual, Allocator, Traits> &rhs
 	) {
 		lhs.swap(rhs);
 	}
@@ -0,0 +1,593 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef HASHERS_HPP_INCLUDED
+#define HASHERS_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <atomic>
+#include <random>
+#include <type_traits>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+/// \internal \brief Whether vector kernels are selected at runtime.
+#define HASHERS_RUNTIME_DISPATCH 1
+#include <immintrin.h>
+#else
+#define HASHERS_RUNTIME_DISPATCH 0
+#endif
+
+/** \brief The base class of all hashers with a seed.
+ *
+ * Default constructed hashers get a random seed, which is different for every
+ * hasher constructed. Since a \c hash_map keeps the hasher it has been
+ * constructed with, this seeds every map individually, so the distribution of
+ * keys to buckets can neither be predicted nor be provoked from the outside.
+ * Copies share the seed of the original.
+ */
+struct seeded_hash {
+	/// \brief Creates a hasher with a random seed.
+	seeded_hash()
+	: seed(random_seed()) {}
+
+	/** \brief Creates a hasher with a specific seed.
+	 *
+	 * \param seed The seed to use. Hashers with equal seeds produce equal
+	 *     hashes.
+	 */
+	explicit seeded_hash(std::uint64_t seed) noexcept
+	: seed(seed) {}
+
+	/** \brief Compares two hashers.
+	 *
+	 * \return \c true if both hashers produce the same hashes.
+	 */
+	bool operator==(const seeded_hash &other) const noexcept {
+		return seed == other.seed;
+	}
+
+	/** \brief Compares two hashers.
+	 *
+	 * \return \c true if the hashers produce different hashes.
+	 */
+	bool operator!=(const seeded_hash &other) const noexcept {
+		return seed != other.seed;
+	}
+
+	/// \brief The seed of this hasher.
+	std::uint64_t seed;
+
+protected:
+	/** \internal \brief Mixes the bits of a 64 bit value.
+	 *
+	 * This is the finalizer of MurmurHash3. It is a bijection, so different
+	 * values never result in the same mixed value.
+	 */
+	static std::uint64_t mix(std::uint64_t value) noexcept {
+		value ^= value >> 33;
+		value *= UINT64_C(0xff51afd7ed558ccd);
+		value ^= value >> 33;
+		value *= UINT64_C(0xc4ceb9fe1a85ec53);
+		value ^= value >> 33;
+		return value;
+	}
+
+private:
+	/** \internal \brief Creates a new random seed.
+	 *
+	 * The random device is only queried once. Subsequent seeds are derived
+	 * from its result and a counter, so hashers are cheap to create.
+	 */
+	static std::uint64_t random_seed() {
+		static const std::uint64_t base = [] {
+			std::random_device device;
+			return (std::uint64_t(device()) << 32) ^ device();
+		}();
+		static std::atomic<std::uint64_t> counter{0};
+
+		return mix(
+			base + counter.fetch_add(
+				UINT64_C(0x9e3779b97f4a7c15), std::memory_order_relaxed
+			)
+		);
+	}
+};
+
+/** \brief A hasher for integers.
+ *
+ * Unlike \c std::hash, which is the identity function for integers in common
+ * standard libraries, this mixes all bits of the key into all bits of the
+ * hash, so keys differing only in a few bits do not cluster in few buckets.
+ * Different keys of up to 64 bits never have the same hash.
+ */
+struct integer_hash: seeded_hash {
+	using seeded_hash::seeded_hash;
+
+	/** \brief Calculates the hash of an integer.
+	 *
+	 * \tparam T An integral or enumeration type of up to 64 bits.
+	 *
+	 * \param value The value to hash.
+	 *
+	 * \return The hash of \c value.
+	 */
+	template<typename T>
+	std::size_t operator()(T value) const noexcept {
+		static_assert(
+			(std::is_integral<T>::value || std::is_enum<T>::value) &&
+				sizeof(T) <= sizeof(std::uint64_t),
+			"integer_hash can only hash integers of up to 64 bits." );
+		return static_cast<std::size_t>(mix(std::uint64_t(value) ^ seed));
+	}
+
+	/** \brief Calculates the hashes of several integers.
+	 *
+	 * The result is the same as calling <tt>(*this)(keys[i])</tt> for every
+	 * key, but 64 bit keys are hashed 8 or 16 at a time using AVX2 or
+	 * AVX-512, if the processor supports it.
+	 *
+	 * \tparam T An integral or enumeration type of up to 64 bits.
+	 *
+	 * \param keys The first of the keys to hash.
+	 * \param count The number of keys to hash.
+	 * \param[out] hashes Receives the \c count hashes.
+	 */
+	template<typename T>
+	void hash_batch(
+		const T *keys,
+		std::size_t count,
+		std::size_t *hashes
+	) const noexcept {
+		std::size_t done = 0;
+#if HASHERS_RUNTIME_DISPATCH
+		if (sizeof(T) == sizeof(std::uint64_t) &&
+			sizeof(std::size_t) == sizeof(std::uint64_t)
+		) {
+			switch(vector_width()) {
+				case 16: done = hash_batch_avx512(keys, count, hashes); break;
+				case 8:  done = hash_batch_avx2(keys, count, hashes);   break;
+				default: break;
+			}
+		}
+#endif
+		for(; done < count; ++done) {
+			hashes[done] = (*this)(keys[done]);
+		}
+	}
+
+#if HASHERS_RUNTIME_DISPATCH
+private:
+	/** \internal \brief Returns how many keys the kernels hash at a time.
+	 *
+	 * \return 16 with AVX-512, 8 with AVX2 and 0 if neither is supported.
+	 */
+	static unsigned vector_width() noexcept {
+		static const unsigned width
+			= (__builtin_cpu_supports("avx512f") &&
+				__builtin_cpu_supports("avx512dq")) ? 16
+			: __builtin_cpu_supports("avx2") ? 8
+			: 0;
+		return width;
+	}
+
+	/** \internal \brief Multiplies 64 bit lanes, keeping the lower half.
+	 *
+	 * AVX2 has no 64 bit multiplication, so it is composed of three 32 bit
+	 * multiplications.
+	 */
+	__attribute__((target("avx2")))
+	static __m256i multiply_avx2(__m256i a, __m256i b) noexcept {
+		const __m256i cross = _mm256_add_epi64(
+			_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+			_mm256_mul_epu32(a, _mm256_srli_epi64(b, 32))
+		);
+		return _mm256_add_epi64(
+			_mm256_mul_epu32(a, b),
+			_mm256_slli_epi64(cross, 32)
+		);
+	}
+
+	/// \internal \brief \ref seeded_hash::mix() for 4 lanes.
+	__attribute__((target("avx2")))
+	static __m256i mix_avx2(__m256i value) noexcept {
+		const __m256i c1 = _mm256_set1_epi64x(
+			static_cast<long long>(UINT64_C(0xff51afd7ed558ccd)));
+		const __m256i c2 = _mm256_set1_epi64x(
+			static_cast<long long>(UINT64_C(0xc4ceb9fe1a85ec53)));
+		value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 33));
+		value = multiply_avx2(value, c1);
+		value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 33));
+		value = multiply_avx2(value, c2);
+		value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 33));
+		return value;
+	}
+
+	/** \internal \brief Hashes 64 bit keys 8 at a time using AVX2.
+	 *
+	 * \return The number of keys hashed, which is \c count rounded down to
+	 *     a multiple of 8.
+	 */
+	__attribute__((target("avx2")))
+	std::size_t hash_batch_avx2(
+		const void *keys,
+		std::size_t count,
+		std::size_t *hashes
+	) const noexcept {
+		const __m256i *in = static_cast<const __m256i *>(keys);
+		__m256i *out = reinterpret_cast<__m256i *>(hashes);
+		const __m256i seeds = _mm256_set1_epi64x(static_cast<long long>(seed));
+		const std::size_t done = count & ~std::size_t(7);
+		for(std::size_t n = 0; n < done; n += 8, in += 2, out += 2) {
+			// two independent vectors hide the latency of the multiplications
+			const __m256i lo = _mm256_loadu_si256(in);
+			const __m256i hi = _mm256_loadu_si256(in + 1);
+			_mm256_storeu_si256(out, mix_avx2(_mm256_xor_si256(lo, seeds)));
+			_mm256_storeu_si256(out + 1, mix_avx2(_mm256_xor_si256(hi, seeds)));
+		}
+		return done;
+	}
+
+	/** \internal \brief Shifts all 64 bit lanes right by 33 bits.
+	 *
+	 * \c _mm512_srli_epi64() passes an undefined vector as the unused source
+	 * of the masked instruction, which GCC reports as maybe uninitialized.
+	 * With all lanes selected, the zeroing variant is the same instruction.
+	 */
+	__attribute__((target("avx512f")))
+	static __m512i shift_avx512(__m512i value) noexcept {
+		return _mm512_maskz_srli_epi64(__mmask8(0xff), value, 33);
+	}
+
+	/** \internal \brief \ref seeded_hash::mix() for 8 lanes.
+	 *
+	 * The multipliers are passed in, so they are built once per batch.
+	 */
+	__attribute__((target("avx512f,avx512dq")))
+	static __m512i mix_avx512(__m512i value, __m512i c1, __m512i c2) noexcept {
+		value = _mm512_xor_si512(value, shift_avx512(value));
+		value = _mm512_mullo_epi64(value, c1);
+		value = _mm512_xor_si512(value, shift_avx512(value));
+		value = _mm512_mullo_epi64(value, c2);
+		value = _mm512_xor_si512(value, shift_avx512(value));
+		return value;
+	}
+
+	/** \internal \brief Hashes 64 bit keys 16 at a time using AVX-512.
+	 *
+	 * \return The number of keys hashed, which is \c count rounded down to
+	 *     a multiple of 16.
+	 */
+	__attribute__((target("avx512f,avx512dq")))
+	std::size_t hash_batch_avx512(
+		const void *keys,
+		std::size_t count,
+		std::size_t *hashes
+	) const noexcept {
+		const char *in = static_cast<const char *>(keys);
+		char *out = reinterpret_cast<char *>(hashes);
+		const __m512i seeds = _mm512_set1_epi64(static_cast<long long>(seed));
+		const __m512i c1 = _mm512_set1_epi64(
+			static_cast<long long>(UINT64_C(0xff51afd7ed558ccd)));
+		const __m512i c2 = _mm512_set1_epi64(
+			static_cast<long long>(UINT64_C(0xc4ceb9fe1a85ec53)));
+		const std::size_t done = count & ~std::size_t(15);
+		for(std::size_t n = 0; n < done; n += 16, in += 128, out += 128) {
+			const __m512i lo = _mm512_loadu_si512(in);
+			const __m512i hi = _mm512_loadu_si512(in + 64);
+			_mm512_storeu_si512(out,
+				mix_avx512(_mm512_xor_si512(lo, seeds), c1, c2));
+			_mm512_storeu_si512(out + 64,
+				mix_avx512(_mm512_xor_si512(hi, seeds), c1, c2));
+		}
+		return done;
+	}
+#endif
+};
+
+/** \brief A hasher for contiguous sequences of bytes, like strings.
+ *
+ * This is a variant of wyhash, which processes 16 to 48 bytes per step using
+ * 64 x 64 -> 128 bit multiplications.
+ */
+struct bytes_hash: seeded_hash {
+	using seeded_hash::seeded_hash;
+
+	/** \brief Calculates the hash of a sequence.
+	 *
+	 * \tparam Sequence A type with the members \c data() and \c size()
+	 *     referring to a contiguous sequence of trivially copyable elements,
+	 *     like \c std::string or \c std::vector.
+	 *
+	 * \param sequence The sequence to hash.
+	 *
+	 * \return The hash of the bytes of the elements of \c sequence.
+	 */
+	template<typename Sequence>
+	std::size_t operator()(const Sequence &sequence) const noexcept {
+		static_assert( std::is_trivially_copyable<
+				std::remove_pointer_t<decltype(sequence.data())>>::value,
+			"bytes_hash can only hash sequences of trivially copyable "
+			"elements." );
+		return (*this)(
+			sequence.data(), sizeof(*sequence.data()) * sequence.size()
+		);
+	}
+
+	/** \brief Calculates the hash of a range of bytes.
+	 *
+	 * \param data The first byte to hash.
+	 * \param size The number of bytes to hash.
+	 *
+	 * \return The hash of the bytes.
+	 */
+	std::size_t operator()(const void *data, std::size_t size) const noexcept {
+		const unsigned char *p = static_cast<const unsigned char *>(data);
+		std::uint64_t state = seed ^ mum(seed ^ secret[0], secret[1]);
+		std::uint64_t a, b;
+
+		if (size <= 16) {
+			if (size >= 4) {
+				const std::size_t middle = (size >> 3) << 2;
+				a = (read32(p) << 32) | read32(p + middle);
+				b = (read32(p + size - 4) << 32) | read32(p + size - 4 - middle);
+			}
+			else if (size > 0) {
+				a = (std::uint64_t(p[0]) << 16)
+					| (std::uint64_t(p[size >> 1]) << 8)
+					| p[size - 1];
+				b = 0;
+			}
+			else {
+				a = b = 0;
+			}
+		}
+		else {
+			std::size_t rest = size;
+			if (rest > 48) {
+				std::uint64_t state1 = state, state2 = state;
+				do {
+					state = mum(read64(p) ^ secret[1], read64(p + 8) ^ state);
+					state1 = mum(read64(p + 16) ^ secret[2], read64(p + 24) ^ state1);
+					state2 = mum(read64(p + 32) ^ secret[3], read64(p + 40) ^ state2);
+					p += 48;
+					rest -= 48;
+				} while(rest > 48);
+				state ^= state1 ^ state2;
+			}
+			while(rest > 16) {
+				state = mum(read64(p) ^ secret[1], read64(p + 8) ^ state);
+				p += 16;
+				rest -= 16;
+			}
+			a = read64(p + rest - 16);
+			b = read64(p + rest - 8);
+		}
+
+		multiply(a ^ secret[1], b ^ state, a, b);
+		return static_cast<std::size_t>(
+			mum(a ^ secret[0] ^ size, b ^ secret[1])
+		);
+	}
+
+private:
+	/// \internal \brief Constants of wyhash.
+	static constexpr std::uint64_t secret[4] = {
+		UINT64_C(0xa0761d6478bd642f), UINT64_C(0xe7037ed1a0b428db),
+		UINT64_C(0x8ebc6af09c88c6e3), UINT64_C(0x589965cc75374cc3)
+	};
+
+	/** \internal \brief Multiplies two 64 bit values.
+	 *
+	 * \param a The first factor.
+	 * \param b The second factor.
+	 * \param[out] lo Receives the lower half of the 128 bit product.
+	 * \param[out] hi Receives the upper half of the 128 bit product.
+	 */
+	static void multiply(
+		std::uint64_t a,
+		std::uint64_t b,
+		std::uint64_t &lo,
+		std::uint64_t &hi
+	) noexcept {
+#if defined(__SIZEOF_INT128__)
+		__extension__ typedef unsigned __int128 uint128;
+		const uint128 product = uint128(a) * b;
+		lo = std::uint64_t(product);
+		hi = std::uint64_t(product >> 64);
+#else
+		const std::uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+		const std::uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+		const std::uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+		const std::uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+		const std::uint64_t cross
+			= (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+		hi = hi_hi + (hi_lo >> 32) + (cross >> 32);
+		lo = (cross << 32) | (lo_lo & 0xffffffff);
+#endif
+	}
+
+	/// \internal \brief Multiplies and folds the 128 bit product.
+	static std::uint64_t mum(std::uint64_t a, std::uint64_t b) noexcept {
+		std::uint64_t lo, hi;
+		multiply(a, b, lo, hi);
+		return lo ^ hi;
+	}
+
+	/// \internal \brief Reads 8 unaligned bytes.
+	static std::uint64_t read64(const unsigned char *p) noexcept {
+		std::uint64_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	/// \internal \brief Reads 4 unaligned bytes.
+	static std::uint64_t read32(const unsigned char *p) noexcept {
+		std::uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+};
+
+#if __cplusplus < 201703L
+constexpr std::uint64_t bytes_hash::secret[4];
+#endif
+
+/** \brief A hasher based on the CRC32C checksum.
+ *
+ * If the processor supports SSE4.2, which is checked at runtime, the checksum
+ * is calculated by the \c crc32 instruction, which processes 8 bytes per
+ * instruction. Otherwise a table based software implementation is used,
+ * which yields the same results.
+ *
+ * \note CRC32C produces 32 bit hashes. Its speed comes at the price of being
+ *     linear, so it is less robust against deliberate collisions than
+ *     \ref bytes_hash, even when seeded.
+ */
+struct crc32c_hash: seeded_hash {
+	using seeded_hash::seeded_hash;
+
+	/** \brief Calculates the hash of an integer.
+	 *
+	 * \tparam T An integral or enumeration type of up to 64 bits.
+	 *
+	 * \param value The value to hash.
+	 *
+	 * \return The hash of \c value.
+	 */
+	template<typename T>
+	std::enable_if_t<
+		std::is_integral<T>::value || std::is_enum<T>::value,
+		std::size_t
+	> operator()(T value) const noexcept {
+		static_assert( sizeof(T) <= sizeof(std::uint64_t),
+			"crc32c_hash can only hash integers of up to 64 bits." );
+		const std::uint64_t bits = std::uint64_t(value);
+		return update(static_cast<std::uint32_t>(seed), &bits, sizeof(bits));
+	}
+
+	/** \brief Calculates the hash of a sequence.
+	 *
+	 * \tparam Sequence A type with the members \c data() and \c size()
+	 *     referring to a contiguous sequence of trivially copyable elements,
+	 *     like \c std::string or \c std::vector.
+	 *
+	 * \param sequence The sequence to hash.
+	 *
+	 * \return The hash of the bytes of the elements of \c sequence.
+	 */
+	template<typename Sequence>
+	std::enable_if_t<
+		!std::is_integral<Sequence>::value && !std::is_enum<Sequence>::value,
+		std::size_t
+	> operator()(const Sequence &sequence) const noexcept {
+		static_assert( std::is_trivially_copyable<
+				std::remove_pointer_t<decltype(sequence.data())>>::value,
+			"crc32c_hash can only hash sequences of trivially copyable "
+			"elements." );
+		return update(
+			static_cast<std::uint32_t>(seed),
+			sequence.data(), sizeof(*sequence.data()) * sequence.size()
+		);
+	}
+
+	/** \brief Calculates the CRC32C checksum of a range of bytes.
+	 *
+	 * \param data The first byte to checksum.
+	 * \param size The number of bytes to checksum.
+	 * \param crc The checksum of preceding data, if any.
+	 *
+	 * \return The checksum, as defined by RFC 3720.
+	 */
+	static std::uint32_t checksum(
+		const void *data,
+		std::size_t size,
+		std::uint32_t crc = 0
+	) noexcept {
+		return ~update(~crc, data, size);
+	}
+
+private:
+	/** \internal \brief Updates a raw CRC32C state.
+	 *
+	 * \param crc The state before processing the data.
+	 * \param data The first byte to process.
+	 * \param size The number of bytes to process.
+	 *
+	 * \return The state after processing the data.
+	 */
+	static std::uint32_t update(
+		std::uint32_t crc,
+		const void *data,
+		std::size_t size
+	) noexcept {
+#if HASHERS_RUNTIME_DISPATCH
+		if (has_sse42()) {
+			return update_sse42(crc, data, size);
+		}
+#endif
+		static const lookup_table table;
+		const unsigned char *p = static_cast<const unsigned char *>(data);
+		for(; size; ++p, --size) {
+			crc = table.entries[(crc ^ *p) & 0xff] ^ (crc >> 8);
+		}
+		return crc;
+	}
+
+#if HASHERS_RUNTIME_DISPATCH
+	/** \internal \brief Checks whether the \c crc32 instruction is available.
+	 *
+	 * \return \c true if the processor supports SSE4.2.
+	 */
+	static bool has_sse42() noexcept {
+		static const bool supported = __builtin_cpu_supports("sse4.2");
+		return supported;
+	}
+
+	/// \internal \brief \ref update() using the \c crc32 instruction.
+	__attribute__((target("sse4.2")))
+	static std::uint32_t update_sse42(
+		std::uint32_t crc,
+		const void *data,
+		std::size_t size
+	) noexcept {
+		const unsigned char *p = static_cast<const unsigned char *>(data);
+		std::uint64_t state = crc;
+		for(; size >= 8; p += 8, size -= 8) {
+			std::uint64_t chunk;
+			std::memcpy(&chunk, p, sizeof(chunk));
+			state = _mm_crc32_u64(state, chunk);
+		}
+		crc = static_cast<std::uint32_t>(state);
+		for(; size; ++p, --size) {
+			crc = _mm_crc32_u8(crc, *p);
+		}
+		return crc;
+	}
+#endif
+
+	/// \internal \brief The lookup table of the software implementation.
+	struct lookup_table {
+		/// \internal \brief Calculates the table.
+		lookup_table() noexcept
+		: entries() {
+			for(std::uint32_t byte = 0; byte < 256; ++byte) {
+				std::uint32_t crc = byte;
+				for(int bit = 0; bit < 8; ++bit) {
+					// 0x82f63b78 is the reversed Castagnoli polynomial
+					crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+				}
+				entries[byte] = crc;
+			}
+		}
+
+		/// \internal \brief The checksum state updates for every byte.
+		std::uint32_t entries[256];
+	};
+};
+
+#endif // HASHERS_HPP_INCLUDED
@@ -0,0 +1,1014 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef INSERT_ONLY_HASH_MAP_HPP_INCLUDED
+#define INSERT_ONLY_HASH_MAP_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "hash_map.hpp"
+
+/** \brief A concurrency friendly hash map for elements that are never erased.
+ * \nosubgrouping
+ *
+ * This is an alternative engine to \ref hash_map for maps which only grow,
+ * like interning tables and symbol caches. As no node can disappear before
+ * the map is cleared or destroyed, nodes are held by raw pointers instead of
+ * \c std::shared_ptr, and the deletion machinery of \c hash_map is not
+ * needed: There are no marker nodes, and lookups never restart.
+ *
+ * New nodes are prepended to their bucket with a single compare and swap on
+ * its head. The next-pointer of a node is set before the node is published
+ * and never changes afterwards, so lookups only load the head of the bucket
+ * atomically and follow the next-pointers with plain loads.
+ *
+ * The interface follows \ref hash_map, with these differences:
+ *     - There is no \c erase().
+ *     - References and iterators to elements stay valid until the map is
+ *         cleared or destroyed, including across \ref rehash().
+ *     - \ref clear() is not thread safe, as there is no way to tell when
+ *         other threads stopped using the cleared nodes.
+ *
+ * \tparam Key The type for element keys.
+ * \tparam T The type for element values.
+ * \tparam Hash The type of the hash function.
+ * \tparam KeyEqual The type of the key equality comparator.
+ * \tparam Allocator The type of the allocator.
+ * \tparam Traits The compile time configuration. Only
+ *     \c Traits::bucket_index_policy is used, to map hashes to buckets.
+ */
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename Allocator = std::allocator< std::pair<const Key, T> >,
+	typename Traits = hash_map_traits
+>
+struct insert_only_hash_map {
+private:
+/// \name Member Types
+///\{
+	struct node;
+
+	/// \internal \brief The head of a bucket.
+	typedef std::atomic<node*> bucket_head;
+
+	/// \internal \brief Maps hashes to buckets.
+	typedef typename Traits::bucket_index_policy bucket_index_policy;
+
+public:
+	/// \brief The type used for element counts and indices.
+	typedef std::size_t                 size_type;
+
+	/// \brief The difference type of two iterators.
+	typedef std::ptrdiff_t              difference_type;
+
+	/// \brief The storage type stored in the map.
+	typedef std::pair<const Key, T>     value_type;
+
+	/// \brief The type for element keys.
+	typedef Key                         key_type;
+
+	/// \brief The type for element values.
+	typedef T                           mapped_type;
+
+	/// \brief The type of the hash function.
+	typedef Hash                        hasher;
+
+	/// \brief The type of the key equality comparator.
+	typedef KeyEqual                    key_equal;
+
+	/// \brief The type of the allocator.
+	typedef Allocator                   allocator_type;
+
+	/// \brief The compile time configuration.
+	typedef Traits                      traits_type;
+
+	/// \brief The return type of the hash function.
+	typedef std::result_of_t<Hash(Key)> hash_type;
+
+	static_assert( std::numeric_limits<hash_type>::is_integer,
+		"Hash result type must be an unsigned integer type." );
+	static_assert( !std::numeric_limits<hash_type>::is_signed,
+		"Hash result type must be an unsigned integer type." );
+
+	/// \brief The base class for iterator implementations.
+	template<bool IsConst>
+	class iterator_impl {
+		friend struct insert_only_hash_map;
+		template<bool> friend class iterator_impl;
+
+	public:
+		/// \brief This iterator is a forward iterator.
+		typedef std::forward_iterator_tag iterator_category;
+
+		/// \brief The difference type of two iterators.
+		typedef std::ptrdiff_t            difference_type;
+
+		/// \brief The storage type stored in the map.
+		typedef std::conditional_t<IsConst,
+			const insert_only_hash_map::value_type,
+			insert_only_hash_map::value_type
+		> value_type;
+
+		/// \brief A pointer to the storage type stored in the map.
+		typedef value_type*               pointer;
+
+		/// \brief A reference to the storage type stored in the map.
+		typedef value_type&               reference;
+
+		/// \brief Default constructs an iterator.
+		iterator_impl()
+		: iterator_impl(nullptr, nullptr, nullptr) {}
+
+		/** \brief Converts an iterator to a const iterator.
+		 *
+		 * \param other The iterator to convert.
+		 */
+		template<bool OtherConst
+#ifndef DOXYGEN
+			, typename = std::enable_if_t<OtherConst <= IsConst, void>
+#endif
+		>
+		iterator_impl(const iterator_impl<OtherConst> &other)
+		: iterator_impl(other.pnode, other.bucket, other.last_bucket) {}
+
+		/** \brief Advances the iterator to the next element.
+		 *
+		 * \pre
+		 *     - <tt>*this != end()</tt>.
+		 *
+		 * \return Returns itself after advancing.
+		 */
+		iterator_impl &operator++() {
+			assert( pnode && "cannot increment an end iterator" );
+			pnode = pnode->next;
+			while(!pnode && ++bucket != last_bucket) {
+				pnode = bucket->load(std::memory_order_acquire);
+			}
+			return *this;
+		}
+
+		/** \brief Advances this iterator and returns the previous value.
+		 *
+		 * \return An iterator to the element this iterator referred to before
+		 *     the call.
+		 */
+		iterator_impl operator++(int) {
+			iterator_impl copy(*this);
+			++*this;
+			return copy;
+		}
+
+		/** \brief Compares two iterators.
+		 *
+		 * \return
+		 *     - \c true if this iterator equals \c other,
+		 *     - \c false otherwise.
+		 */
+		template<bool OtherConst>
+		bool operator==(const iterator_impl<OtherConst> &other) const {
+			return pnode == other.pnode;
+		}
+
+		/** \brief Compares two iterators.
+		 *
+		 * \return
+		 *     - \c true if this iterator differs from \c other,
+		 *     - \c false otherwise.
+		 */
+		template<bool OtherConst>
+		bool operator!=(const iterator_impl<OtherConst> &other) const {
+			return pnode != other.pnode;
+		}
+
+		/** \brief Dereferences the iterator.
+		 *
+		 * \return A reference to the iterators referred element.
+		 */
+		reference operator*() const {
+			assert( pnode && "cannot dereference invalid iterator" );
+			return pnode->value;
+		}
+
+		/** \brief Dereferences the iterator.
+		 *
+		 * \return A pointer to the iterators referred element.
+		 */
+		pointer operator->() const {
+			assert( pnode && "cannot dereference invalid iterator" );
+			return &pnode->value;
+		}
+
+	private:
+		/** \internal \brief Creates an iterator to a node.
+		 *
+		 * \param pnode The node, or \c nullptr for an end iterator.
+		 * \param bucket The bucket of \c pnode.
+		 * \param last_bucket The end of the buckets.
+		 */
+		iterator_impl(
+			node *pnode,
+			const bucket_head *bucket,
+			const bucket_head *last_bucket
+		)
+		: pnode(pnode)
+		, bucket(bucket)
+		, last_bucket(last_bucket) {}
+
+		/// \internal \brief The node the iterator refers to.
+		node *pnode;
+
+		/// \internal \brief The bucket of the node.
+		const bucket_head *bucket;
+
+		/// \internal \brief The end of the buckets.
+		const bucket_head *last_bucket;
+	};
+
+	/// \brief The iterator type for the insert_only_hash_map.
+	typedef iterator_impl<false> iterator;
+
+	/// \brief The constant iterator type for the insert_only_hash_map.
+	typedef iterator_impl<true>  const_iterator;
+///\}
+
+
+
+/// \name Member Functions
+///\{
+	/** \brief Creates an empty insert_only_hash_map.
+	 *
+	 * \param bucket_count The number of buckets used initially.
+	 * \param hash The hash function to use.
+	 * \param keycomp The key comparison function to use.
+	 * \param allocator The allocator to use.
+	 *
+	 * \pre
+	 *     - <tt>0 < bucket_count</tt>
+	 */
+	explicit insert_only_hash_map(
+		const size_type bucket_count,
+		const hasher &hash = hasher{},
+		const key_equal &keycomp = key_equal{},
+		const allocator_type &allocator = allocator_type{}
+	)
+	: hash(hash)
+	, keycomp(keycomp)
+	, allocator(allocator)
+	, node_allocator(allocator)
+	, head_allocator(allocator)
+	, bucket_index(bucket_count)
+	, heads(create_heads(bucket_index.bucket_count()))
+	, node_count(0) {
+		assert( 0 < bucket_count
+			&& "can not have an insert_only_hash_map without buckets" );
+	}
+
+	/** \brief Creates a copy of an insert_only_hash_map.
+	 *
+	 * \post
+	 *     - <tt>*this == other</tt>
+	 */
+	insert_only_hash_map(const insert_only_hash_map &other)
+	: insert_only_hash_map(
+		other.bucket_count(), other.hash, other.keycomp, other.allocator
+	) {
+		for(size_type b_id = 0; b_id < other.bucket_count(); ++b_id) {
+			for(
+				node *cur = other.heads[b_id].load(std::memory_order_acquire);
+				cur;
+				cur = cur->next
+			) {
+				insert_hashed(cur->key_hash, cur->value);
+			}
+		}
+	}
+
+	/** \brief Destructs the insert_only_hash_map.
+	 *
+	 * \post
+	 *     - All iterators are invalidated.
+	 */
+	~insert_only_hash_map() {
+		destroy_nodes();
+		destroy_heads(heads, bucket_count());
+	}
+
+	/** \brief Assigns all elements from another insert_only_hash_map to this
+	 *     one.
+	 *
+	 * \return A reference to this insert_only_hash_map.
+	 *
+	 * \post
+	 *     - <tt>*this == other</tt>
+	 *
+	 * \note This function is not thread safe.
+	 */
+	insert_only_hash_map &operator=(const insert_only_hash_map &other) {
+		insert_only_hash_map temp(other);
+		swap(temp);
+		return *this;
+	}
+
+	/** \brief Swaps contents with another insert_only_hash_map.
+	 *
+	 * \param other The insert_only_hash_map to swap contents with.
+	 *
+	 * \note This function is not thread safe.
+	 */
+	void swap(insert_only_hash_map &other) {
+		using std::swap;
+		swap(hash, other.hash);
+		swap(keycomp, other.keycomp);
+		swap(allocator, other.allocator);
+		swap(node_allocator, other.node_allocator);
+		swap(head_allocator, other.head_allocator);
+		swap(bucket_index, other.bucket_index);
+		swap(heads, other.heads);
+		node_count = other.node_count.exchange(node_count);
+	}
+
+	/** \brief Compares the values in the insert_only_hash_map.
+	 *
+	 * \param other Another insert_only_hash_map to compare against.
+	 *
+	 * \pre
+	 *     - \c mapped_type is <tt>==</tt> comparable.
+	 *
+	 * \return
+	 *     - \c true if the contents of the containers are equal,
+	 *     - \c false otherwise.
+	 */
+	bool operator==(const insert_only_hash_map &other) const {
+		if (this == &other) {
+			return true;
+		}
+		if (size() != other.size()) {
+			return false;
+		}
+		for(const value_type &value: *this) {
+			const const_iterator it = other.find(value.first);
+			if (it == other.end() || !(it->second == value.second)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** \brief Compares the values in the insert_only_hash_map.
+	 *
+	 * \param other Another insert_only_hash_map to compare against.
+	 *
+	 * \return
+	 *     - \c true if the contents of the containers differ,
+	 *     - \c false otherwise.
+	 */
+	bool operator!=(const insert_only_hash_map &other) const {
+		return !operator==(other);
+	}
+
+	/** \brief Changes the bucket count and relinks the elements.
+	 *
+	 * \param new_bucket_count The new number of buckets after rehashing.
+	 *
+	 * \pre
+	 *     - <tt>0 < new_bucket_count</tt>
+	 *
+	 * \post
+	 *     - <tt>bucket_count() == new_bucket_count</tt>, unless the
+	 *         \c traits_type::bucket_index_policy rounds bucket counts.
+	 *     - <tt>after_rehash == before_rehash</tt>
+	 *     - References to elements are still valid.
+	 *
+	 * \note The hash function is not called during this operation.
+	 *
+	 * \note This function is not thread safe.
+	 */
+	void rehash(size_type new_bucket_count) {
+		assert( 0 < new_bucket_count
+			&& "can not rehash without buckets" );
+
+		const bucket_index_policy new_bucket_index(new_bucket_count);
+		bucket_head *const new_heads
+			= create_heads(new_bucket_index.bucket_count());
+
+		for(size_type b_id = 0; b_id < bucket_count(); ++b_id) {
+			node *cur = heads[b_id].load(std::memory_order_relaxed);
+			while(cur) {
+				node *const next = cur->next;
+				bucket_head &head = new_heads[
+					new_bucket_index(static_cast<std::size_t>(cur->key_hash))
+				];
+				cur->next = head.load(std::memory_order_relaxed);
+				head.store(cur, std::memory_order_relaxed);
+				cur = next;
+			}
+		}
+
+		destroy_heads(heads, bucket_count());
+		bucket_index = new_bucket_index;
+		heads = new_heads;
+	}
+///\}
+
+
+
+/// \name Observers
+///\{
+	/** \brief Returns the allocator.
+	 *
+	 * \return A copy of the allocator.
+	 */
+	allocator_type get_allocator() const {
+		return allocator;
+	}
+
+	/** \brief Returns the hash function.
+	 *
+	 * \return A copy of the hash function.
+	 */
+	hasher hash_function() const {
+		return hash;
+	}
+
+	/** \brief Returns the key comparison function.
+	 *
+	 * \return A copy of the key comparison function.
+	 */
+	key_equal key_eq() const {
+		return keycomp;
+	}
+///\}
+
+
+
+/// \name Iterators
+///\{
+/// \note These functions are thread safe.
+	/** \brief Returns a begin iterator.
+	 *
+	 * \return An iterator to the first element.
+	 */
+	iterator begin() {
+		const bucket_head *const last_bucket = heads + bucket_count();
+		for(const bucket_head *bucket = heads; bucket != last_bucket; ++bucket) {
+			if (node *first = bucket->load(std::memory_order_acquire)) {
+				return iterator(first, bucket, last_bucket);
+			}
+		}
+		return end();
+	}
+
+	/** \brief Returns a begin iterator.
+	 *
+	 * \return An iterator to the first element.
+	 */
+	const_iterator begin() const {
+		return const_cast<insert_only_hash_map&>(*this).begin();
+	}
+
+	/** \brief Returns a begin iterator.
+	 *
+	 * \return An iterator to the first element.
+	 */
+	const_iterator cbegin() const {
+		return begin();
+	}
+
+	/** \brief Returns an end iterator.
+	 *
+	 * \return An iterator past the last element.
+	 */
+	iterator end() {
+		return iterator(nullptr, heads + bucket_count(), heads + bucket_count());
+	}
+
+	/** \brief Returns an end iterator.
+	 *
+	 * \return An iterator past the last element.
+	 */
+	const_iterator end() const {
+		return const_cast<insert_only_hash_map&>(*this).end();
+	}
+
+	/** \brief Returns an end iterator.
+	 *
+	 * \return An iterator past the last element.
+	 */
+	const_iterator cend() const {
+		return end();
+	}
+///\}
+
+
+
+/// \name Capacity
+///\{
+/// \note These functions are thread safe.
+	/** \brief Checks whether the container is empty.
+	 *
+	 * \return
+	 *     - \c true if the container is empty,
+	 *     - \c false otherwise.
+	 */
+	bool empty() const {
+		return 0 == size();
+	}
+
+	/** \brief Returns the number of elements.
+	 *
+	 * \return The number of elements in the container.
+	 */
+	size_type size() const {
+		return node_count;
+	}
+
+	/** \brief Returns the maximum possible number of elements.
+	 *
+	 * \return The maximum number of possible elements in the container.
+	 */
+	size_type max_size() const {
+		return std::numeric_limits<size_type>::max();
+	}
+///\}
+
+
+
+/// \name Modifiers
+///\{
+/// \note These functions are thread safe, except for \ref clear().
+	/** \brief Clears the contents.
+	 *
+	 * \post
+	 *     - <tt>empty() == true</tt>
+	 *     - All iterators and references to elements are invalidated.
+	 *
+	 * \note This function is not thread safe.
+	 */
+	void clear() {
+		destroy_nodes();
+		for(size_type b_id = 0; b_id < bucket_count(); ++b_id) {
+			heads[b_id].store(nullptr, std::memory_order_relaxed);
+		}
+		node_count = 0;
+	}
+
+	/** \brief Inserts an element into the map.
+	 *
+	 * \param value The value to insert into the map.
+	 *
+	 * \return A pair \c pair as follows:
+	 *     - <tt>pair.first == true</tt>, if \c value was inserted
+	 *         successfully. <tt>pair.second</tt> will be an iterator to the
+	 *         newly inserted element.
+	 *     - <tt>pair.first == false</tt>, if an item with the given key exists
+	 *         already. <tt>pair.second</tt> will be an iterator to the
+	 *         element that blocked the insertion.
+	 */
+	std::pair<bool, iterator> insert(const value_type &value) {
+		return insert_hashed(hash(value.first), value);
+	}
+
+	/** \brief Inserts an element with a precomputed hash into the map.
+	 *
+	 * \param key_hash The hash of the key of \c value.
+	 * \param value The value to insert into the map.
+	 *
+	 * \pre
+	 *     - <tt>key_hash == hash_function()(value.first)</tt>
+	 *
+	 * \return The same as <tt>insert(value)</tt>.
+	 */
+	std::pair<bool, iterator> insert_hashed(
+		hash_type key_hash,
+		const value_type &value
+	) {
+		assert( hash(value.first) == key_hash
+			&& "key_hash must be the hash of the key!" );
+
+		bucket_head &head = bucket_for_hash(key_hash);
+		node *first = head.load(std::memory_order_acquire);
+		node *searched = nullptr;
+		node *new_node = nullptr;
+		while(true) {
+			// only the nodes prepended since the last attempt need to be
+			// searched again
+			if (node *found = find_in(first, searched, value.first, key_hash)) {
+				if (new_node) {
+					destroy_node(new_node);
+				}
+				return std::make_pair(false, iterator_to(found, key_hash));
+			}
+
+			if (!new_node) {
+				new_node = create_node(key_hash, value);
+			}
+			new_node->next = first;
+
+			if (head.compare_exchange_weak(
+				first, new_node,
+				std::memory_order_release, std::memory_order_acquire
+			)) {
+				++node_count;
+				return std::make_pair(true, iterator_to(new_node, key_hash));
+			}
+			searched = new_node->next;
+		}
+	}
+
+	/** \brief Inserts an element into the map.
+	 *
+	 * This function is equivalent to calling <tt>insert(value)</tt>.
+	 *
+	 * \param hint Ignored.
+	 * \param value The value to insert into the map.
+	 *
+	 * \return An iterator to the newly inserted element or to the existing
+	 *     element with they same key as \c value that blocked the insertion.
+	 */
+	iterator insert(const_iterator hint, const value_type &value) {
+		((void)hint); // unused, suppress warning
+		return insert(value).second;
+	}
+
+	/** \brief Inserts an element into the map or modifies an existing one.
+	 *
+	 * \param key The key of the element in the map.
+	 * \param mapped The value to insert or assign.
+	 *
+	 * \return An iterator to the element with key \c key.
+	 *
+	 * \note Like with \ref hash_map::insert_or_assign(), assigning to an
+	 *     existing element is not atomic.
+	 */
+	iterator insert_or_assign(const key_type &key, const mapped_type &mapped) {
+		const auto result = insert(std::make_pair(key, mapped));
+		if (!result.first) {
+			result.second->second = mapped;
+		}
+		return result.second;
+	}
+///\}
+
+
+
+/// \name Lookup
+///\{
+/// \note These functions are thread safe.
+	/** \brief Accesses an element by its key, with bounds-checking.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if no element with the key \c key is
+	 *     stored in the insert_only_hash_map.
+	 *
+	 * \return A reference to the element requested.
+	 */
+	mapped_type &at(const key_type &key) {
+		iterator it = find(key);
+		if (it != end()) {
+			return it->second;
+		}
+		else {
+			throw std::out_of_range("element not found in insert_only_hash_map");
+		}
+	}
+
+	/** \brief Accesses an element by its key, with bounds-checking.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if no element with the key \c key is
+	 *     stored in the insert_only_hash_map.
+	 *
+	 * \return A constant reference to the element requested.
+	 */
+	const mapped_type &at(const key_type &key) const {
+		return const_cast<insert_only_hash_map&>(*this).at(key);
+	}
+
+	/** \brief Accesses an element by its key.
+	 *
+	 * If necessary, default constructs an element first to return it.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \return The element for the key requested.
+	 */
+#ifndef DOXYGEN
+	std::enable_if_t<
+		std::is_default_constructible<mapped_type>::value,
+		mapped_type&
+	>
+#else
+	mapped_type&
+#endif
+	operator[](const key_type &key) {
+		return insert(std::make_pair(key, mapped_type{})).second->second;
+	}
+
+	/** \brief Counts the number of elements with a specific key.
+	 *
+	 * \param key The key of the element to count.
+	 *
+	 * \return The number of elements with the key \c key. (0 or 1)
+	 */
+	size_type count(const key_type &key) const {
+		return (find(key) != cend())
+			? 1
+			: 0;
+	}
+
+	/** \brief Finds an element by its key.
+	 *
+	 * \param key The key of the element to fetch.
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	iterator find(const key_type &key) {
+		return find(key, hash(key));
+	}
+
+	/** \brief Finds an element by its key.
+	 *
+	 * \param key The key of the element to fetch.
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	const_iterator find(const key_type &key) const {
+		return const_cast<insert_only_hash_map&>(*this).find(key);
+	}
+
+	/** \brief Finds an element by its key and precomputed hash.
+	 *
+	 * \param key The key of the element to fetch.
+	 * \param key_hash The hash of \c key.
+	 *
+	 * \pre
+	 *     - <tt>key_hash == hash_function()(key)</tt>
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	iterator find(const key_type &key, hash_type key_hash) {
+		assert( hash(key) == key_hash
+			&& "key_hash must be the hash of the key!" );
+
+		node *const first
+			= bucket_for_hash(key_hash).load(std::memory_order_acquire);
+		if (node *found = find_in(first, nullptr, key, key_hash)) {
+			return iterator_to(found, key_hash);
+		}
+		return end();
+	}
+
+	/** \brief Finds an element by its key and precomputed hash.
+	 *
+	 * \param key The key of the element to fetch.
+	 * \param key_hash The hash of \c key.
+	 *
+	 * \pre
+	 *     - <tt>key_hash == hash_function()(key)</tt>
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	const_iterator find(const key_type &key, hash_type key_hash) const {
+		return const_cast<insert_only_hash_map&>(*this).find(key, key_hash);
+	}
+///\}
+
+
+
+/// \name Bucket interface
+///\{
+	/** \brief Returns the number of buckets.
+	 *
+	 * \return The number of buckets in this insert_only_hash_map.
+	 */
+	size_type bucket_count() const {
+		return bucket_index.bucket_count();
+	}
+
+	/** \brief Returns the maximum possible number of buckets.
+	 *
+	 * \return The maximum possible number of buckets in the container.
+	 */
+	size_type max_bucket_count() const {
+		return std::numeric_limits<size_type>::max() / sizeof(bucket_head);
+	}
+
+	/** \brief Returns the number of elements in a specific bucket.
+	 *
+	 * \pre
+	 *     - <tt>bucket_index < bucket_count()</tt>
+	 *
+	 * \return The number of elements in the given bucket.
+	 */
+	size_type bucket_size(size_type bucket_index) const {
+		size_type count = 0;
+		for(
+			node *cur = heads[bucket_index].load(std::memory_order_acquire);
+			cur;
+			cur = cur->next
+		) {
+			++count;
+		}
+		return count;
+	}
+
+	/** \brief Returns the bucket index for a specific key.
+	 *
+	 * \param key The key for which to retrieve the according bucket index.
+	 *
+	 * \return The index of the bucket that would hold an element with the key
+	 *     \c key.
+	 */
+	size_type bucket(const key_type &key) const {
+		return bucket_index(static_cast<std::size_t>(hash(key)));
+	}
+///\}
+
+
+
+/// \internal \name Internals
+///\{ \internal
+private:
+	/** \internal \brief A node of a bucket list.
+	 *
+	 * The next-pointer is set before the node is published by the compare
+	 * and swap on the head of its bucket and is only changed by
+	 * \ref rehash() afterwards.
+	 */
+	struct node {
+		/** \internal \brief Creates a node.
+		 *
+		 * \param key_hash The hash of the key of the element.
+		 * \param value The element.
+		 */
+		node(hash_type key_hash, const value_type &value)
+		: next(nullptr)
+		, key_hash(key_hash)
+		, value(value) {}
+
+		node(const node &) = delete;
+		node &operator=(const node &) = delete;
+
+		/// \internal \brief The next node in the bucket, or \c nullptr.
+		node *next;
+
+		/// \internal \brief The hash of the key of the element.
+		const hash_type key_hash;
+
+		/// \internal \brief The element.
+		value_type value;
+	};
+
+	/// \internal \brief The allocator for nodes.
+	typedef typename std::allocator_traits<allocator_type>
+		::template rebind_alloc<node> node_allocator_type;
+
+	/// \internal \brief The allocator traits for nodes.
+	typedef typename std::allocator_traits<allocator_type>
+		::template rebind_traits<node> node_allocator_traits;
+
+	/// \internal \brief The allocator for bucket heads.
+	typedef typename std::allocator_traits<allocator_type>
+		::template rebind_alloc<bucket_head> head_allocator_type;
+
+	/// \internal \brief The allocator traits for bucket heads.
+	typedef typename std::allocator_traits<allocator_type>
+		::template rebind_traits<bucket_head> head_allocator_traits;
+
+	/** \internal \brief Searches part of a bucket for a key.
+	 *
+	 * \param first The node to start the search at.
+	 * \param last The node to stop the search at, or \c nullptr to search to
+	 *     the end of the bucket.
+	 * \param key The key to look for.
+	 * \param key_hash The hash of \c key.
+	 *
+	 * \return The node with the key \c key, or \c nullptr if there is none.
+	 */
+	node *find_in(
+		node *first,
+		const node *last,
+		const key_type &key,
+		hash_type key_hash
+	) const {
+		for(node *cur = first; cur != last; cur = cur->next) {
+			if (cur->key_hash == key_hash && keycomp(cur->value.first, key)) {
+				return cur;
+			}
+		}
+		return nullptr;
+	}
+
+	/// \internal \brief Returns the bucket for a hash.
+	bucket_head &bucket_for_hash(hash_type key_hash) const {
+		return heads[bucket_index(static_cast<std::size_t>(key_hash))];
+	}
+
+	/// \internal \brief Creates an iterator to a node.
+	iterator iterator_to(node *pnode, hash_type key_hash) const {
+		return iterator(
+			pnode, &bucket_for_hash(key_hash), heads + bucket_count()
+		);
+	}
+
+	/// \internal \brief Allocates and constructs a node.
+	node *create_node(hash_type key_hash, const value_type &value) {
+		node *const new_node = node_allocator_traits::allocate(node_allocator, 1);
+		try {
+			node_allocator_traits::construct(
+				node_allocator, new_node, key_hash, value
+			);
+		}
+		catch(...) {
+			node_allocator_traits::deallocate(node_allocator, new_node, 1);
+			throw;
+		}
+		return new_node;
+	}
+
+	/// \internal \brief Destructs and deallocates a node.
+	void destroy_node(node *old_node) {
+		node_allocator_traits::destroy(node_allocator, old_node);
+		node_allocator_traits::deallocate(node_allocator, old_node, 1);
+	}
+
+	/// \internal \brief Destroys all nodes, leaving the heads dangling.
+	void destroy_nodes() {
+		for(size_type b_id = 0; b_id < bucket_count(); ++b_id) {
+			node *cur = heads[b_id].load(std::memory_order_relaxed);
+			while(cur) {
+				node *const next = cur->next;
+				destroy_node(cur);
+				cur = next;
+			}
+		}
+	}
+
+	/// \internal \brief Allocates and constructs empty bucket heads.
+	bucket_head *create_heads(size_type count) {
+		bucket_head *const new_heads
+			= head_allocator_traits::allocate(head_allocator, count);
+		for(size_type n = 0; n < count; ++n) {
+			head_allocator_traits::construct(
+				head_allocator, new_heads + n, nullptr
+			);
+		}
+		return new_heads;
+	}
+
+	/// \internal \brief Destructs and deallocates bucket heads.
+	void destroy_heads(bucket_head *old_heads, size_type count) {
+		for(size_type n = 0; n < count; ++n) {
+			head_allocator_traits::destroy(head_allocator, old_heads + n);
+		}
+		head_allocator_traits::deallocate(head_allocator, old_heads, count);
+	}
+
+	/// \internal \brief The hash function used for keys.
+	hasher hash;
+
+	/// \internal \brief The comparator for element keys.
+	key_equal keycomp;
+
+	/// \internal \brief The allocator used to handle allocations.
+	allocator_type allocator;
+
+	/// \internal \brief The allocator used for nodes.
+	node_allocator_type node_allocator;
+
+	/// \internal \brief The allocator used for bucket heads.
+	head_allocator_type head_allocator;
+
+	/// \internal \brief Maps hashes to buckets.
+	bucket_index_policy bucket_index;
+
+	/// \internal \brief The first node of every bucket.
+	bucket_head *heads;
+
+	/// \internal \brief The current number of elements.
+	std::atomic<size_type> node_count;
+///\}
+};
+
+#endif // INSERT_ONLY_HASH_MAP_HPP_INCLUDED
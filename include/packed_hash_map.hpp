@@ -0,0 +1,1589 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef PACKED_HASH_MAP_HPP_INCLUDED
+#define PACKED_HASH_MAP_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "hash_map.hpp"
+
+/** \brief A concurrency friendly hash map for small, trivial elements.
+ * \nosubgrouping
+ *
+ * This is an alternative engine to \ref hash_map for keys and values which
+ * together fit into 64 bits. Instead of a list of nodes per bucket, it keeps a
+ * single array of atomic words, each of which holds a key and its value. Keys
+ * are found by linear probing from the slot their hash is mapped to, so
+ * \ref find() only loads words from consecutive slots, and
+ * \ref insert(), \ref insert_or_assign() and \ref erase() take effect with a
+ * single compare and swap on one word. There are no nodes, no
+ * \c std::shared_ptr and no allocations apart from the slot array.
+ *
+ * The interface follows \ref hash_map, with these differences:
+ *     - Elements are words, so there are no references to them.
+ *         \ref operator[](), \ref at() and \ref iterator return a
+ *         \ref mapped_reference instead, which loads the value when read and
+ *         assigns it with a compare and swap. \ref const_iterator and the
+ *         \c const \ref at() return copies.
+ *     - The two largest values of \c Key mark empty and erased slots.
+ *         Inserting them throws \c std::invalid_argument, and looking them up
+ *         finds nothing.
+ *     - Erased slots are not reused in place. When the probe sequence of a
+ *         key has no empty slot left, the key goes to an overflow table twice
+ *         the size, which is chained to the full one. If erased elements take
+ *         up at least half of the full table, \ref insert() and
+ *         \ref insert_or_assign() compact the chain into a single table
+ *         instead, so inserting and erasing ever new keys does not make the
+ *         map grow. Other modifications wait while a chain is compacted.
+ *         \ref rehash() and \ref clear() replace the chain by a single table
+ *         as well.
+ *
+ * \tparam Key The type for element keys. Must be an integral type.
+ * \tparam T The type for element values. Must be a trivial type.
+ * \tparam Hash The type of the hash function.
+ * \tparam KeyEqual The type of the key equality comparator.
+ * \tparam Allocator The type of the allocator.
+ * \tparam Traits The compile time configuration. Only
+ *     \c Traits::bucket_index_policy is used, to map hashes to slots.
+ */
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename Allocator = std::allocator< std::pair<const Key, T> >,
+	typename Traits = hash_map_traits
+>
+struct packed_hash_map {
+	static_assert( std::is_integral<Key>::value && !std::is_same<Key, bool>::value,
+		"packed_hash_map requires an integral key type other than bool." );
+	static_assert( std::is_trivial<T>::value,
+		"packed_hash_map requires a trivial mapped type." );
+	static_assert( sizeof(Key) + sizeof(T) <= sizeof(std::uint64_t),
+		"packed_hash_map requires keys and values to fit into 64 bits." );
+
+private:
+/// \name Member Types
+///\{
+	/// \internal \brief A key and its value packed into one word.
+	typedef std::conditional_t<
+		sizeof(Key) + sizeof(T) <= sizeof(std::uint32_t),
+		std::uint32_t,
+		std::uint64_t
+	> word_type;
+
+	/// \internal \brief A slot of the table.
+	typedef std::atomic<word_type> slot;
+
+	struct slot_table;
+	/// \internal \brief A smart pointer to a slot table.
+	typedef std::shared_ptr<slot_table> table_pointer;
+
+	/// \internal \brief Maps hashes to slots.
+	typedef typename Traits::bucket_index_policy bucket_index_policy;
+
+public:
+	/// \brief The type used for element counts and indices.
+	typedef std::size_t                 size_type;
+
+	/// \brief The difference type of two iterators.
+	typedef std::ptrdiff_t              difference_type;
+
+	/// \brief The storage type stored in the map.
+	typedef std::pair<const Key, T>     value_type;
+
+	/// \brief The type for element keys.
+	typedef Key                         key_type;
+
+	/// \brief The type for element values.
+	typedef T                           mapped_type;
+
+	/// \brief The type of the hash function.
+	typedef Hash                        hasher;
+
+	/// \brief The type of the key equality comparator.
+	typedef KeyEqual                    key_equal;
+
+	/// \brief The type of the allocator.
+	typedef Allocator                   allocator_type;
+
+	/// \brief The compile time configuration.
+	typedef Traits                      traits_type;
+
+	/// \brief The return type of the hash function.
+	typedef std::result_of_t<Hash(Key)> hash_type;
+
+	static_assert( std::numeric_limits<hash_type>::is_integer,
+		"Hash result type must be an unsigned integer type." );
+	static_assert( !std::numeric_limits<hash_type>::is_signed,
+		"Hash result type must be an unsigned integer type." );
+
+	/** \brief The iterator type for the packed_hash_map.
+	 *
+	 * Iterators take a copy of the element when they reach it, so
+	 * dereferencing them yields that copy, even if the element has been
+	 * changed or erased since. They keep the chain of tables they iterate
+	 * alive, so they stay valid when it is compacted.
+	 */
+	class const_iterator {
+		friend struct packed_hash_map;
+
+	public:
+		/// \brief Elements are copied, so this is an input iterator.
+		typedef std::input_iterator_tag iterator_category;
+
+		/// \brief The difference type of two iterators.
+		typedef std::ptrdiff_t          difference_type;
+
+		/// \brief The storage type stored in the map.
+		typedef packed_hash_map::value_type value_type;
+
+		/// \brief Dereferencing yields a copy of the element.
+		typedef value_type              reference;
+
+		/// \brief Provides <tt>operator-></tt> on a copy of the element.
+		class pointer {
+			friend class const_iterator;
+
+		public:
+			/// \brief Accesses the copy of the element.
+			const value_type *operator->() const {
+				return &value;
+			}
+
+		private:
+			/// \internal \brief Wraps a copy of an element.
+			explicit pointer(const value_type &value)
+			: value(value) {}
+
+			/// \internal \brief The copy of the element.
+			value_type value;
+		};
+
+		/// \brief Default constructs an end iterator.
+		const_iterator()
+		: chain()
+		, table(nullptr)
+		, pos(nullptr)
+		, word() {}
+
+		/// \brief Copies an iterator, sharing the chain it keeps alive.
+		const_iterator(const const_iterator &) = default;
+
+		/// \brief Moves an iterator.
+		const_iterator(const_iterator &&) = default;
+
+		/// \brief Assigns an iterator, sharing the chain it keeps alive.
+		const_iterator &operator=(const const_iterator &) = default;
+
+		/// \brief Assigns an iterator.
+		const_iterator &operator=(const_iterator &&) = default;
+
+		/** \brief Advances the iterator to the next element.
+		 *
+		 * \pre
+		 *     - <tt>*this</tt> is valid,
+		 *     - <tt>*this != end()</tt>.
+		 *
+		 * \return Returns itself after advancing.
+		 */
+		const_iterator &operator++() {
+			assert( pos && "cannot increment an end iterator" );
+			++pos;
+			skip_free();
+			return *this;
+		}
+
+		/** \brief Advances this iterator and returns the previous value.
+		 *
+		 * \return An iterator to the element this iterator referred to before
+		 *     the call.
+		 */
+		const_iterator operator++(int) {
+			const_iterator copy(*this);
+			++*this;
+			return copy;
+		}
+
+		/** \brief Compares two iterators.
+		 *
+		 * \return
+		 *     - \c true if this iterator equals \c other,
+		 *     - \c false otherwise.
+		 */
+		bool operator==(const const_iterator &other) const {
+			return pos == other.pos;
+		}
+
+		/** \brief Compares two iterators.
+		 *
+		 * \return
+		 *     - \c true if this iterator differs from \c other,
+		 *     - \c false otherwise.
+		 */
+		bool operator!=(const const_iterator &other) const {
+			return pos != other.pos;
+		}
+
+		/** \brief Dereferences the iterator.
+		 *
+		 * \return A copy of the element.
+		 */
+		reference operator*() const {
+			assert( pos && "cannot dereference invalid iterator" );
+			return value_type(unpack_key(word), unpack_mapped(word));
+		}
+
+		/** \brief Dereferences the iterator.
+		 *
+		 * \return An object providing access to a copy of the element.
+		 */
+		pointer operator->() const {
+			return pointer(**this);
+		}
+
+	private:
+		/** \internal \brief Creates an iterator to the first element at or
+		 *     after a slot.
+		 */
+		const_iterator(
+			table_pointer chain, const slot_table *table, const slot *pos
+		)
+		: chain(std::move(chain))
+		, table(table)
+		, pos(pos)
+		, word() {
+			skip_free();
+		}
+
+		/// \internal \brief Creates an iterator to an element already loaded.
+		const_iterator(
+			table_pointer chain,
+			const slot_table *table,
+			const slot *pos,
+			word_type word
+		)
+		: chain(std::move(chain))
+		, table(table)
+		, pos(pos)
+		, word(word) {}
+
+		/** \internal \brief Advances to the next slot holding an element.
+		 *
+		 * Continues with the overflow table at the end of a table, and
+		 * becomes an end iterator at the end of the last one.
+		 */
+		void skip_free() {
+			while(table) {
+				const slot *const last = table->slots + table->slot_count;
+				for(; pos != last; ++pos) {
+					word = pos->load(std::memory_order_acquire);
+					if (is_live(word)) {
+						return;
+					}
+				}
+				table = table->next_table();
+				pos = table ? table->slots : nullptr;
+			}
+			chain.reset();
+		}
+
+		/// \internal \brief The first table of the chain, kept alive.
+		table_pointer chain;
+
+		/// \internal \brief The table of \ref pos.
+		const slot_table *table;
+
+		/// \internal \brief The slot the iterator refers to.
+		const slot *pos;
+
+		/// \internal \brief The element, as loaded from the slot.
+		word_type word;
+	};
+
+	/** \brief Refers to the value of an element.
+	 *
+	 * Values are packed into one word with their keys, so \ref operator[](),
+	 * \ref at() and \ref iterator return this in place of a reference.
+	 * Reading it loads the current value of the element. If the element has
+	 * been erased, it yields the value the reference was created with or
+	 * last assigned. Assigning to it replaces the value with a compare and
+	 * swap, unless the element has been erased in the meantime.
+	 *
+	 * References must not outlive the packed_hash_map they refer to.
+	 */
+	class mapped_reference {
+		friend struct packed_hash_map;
+
+	public:
+		/// \brief Creates another reference to the same element.
+		mapped_reference(const mapped_reference &) = default;
+
+		/** \brief Loads the value of the element.
+		 *
+		 * \return The current value, or the value this reference was created
+		 *     with or last assigned if the element has been erased.
+		 */
+		operator mapped_type() const {
+			const packed_hash_map &const_map = *map;
+			const const_iterator it = const_map.find(key);
+			return (it != const_map.cend())
+				? it->second
+				: mapped;
+		}
+
+		/** \brief Assigns a value to the element.
+		 *
+		 * \param value The new value.
+		 *
+		 * \return Returns itself.
+		 */
+		mapped_reference &operator=(const mapped_type &value) {
+			map->assign(key, value);
+			mapped = value;
+			return *this;
+		}
+
+		/** \brief Assigns the value of another element to the element.
+		 *
+		 * \param other The reference to the other element.
+		 *
+		 * \return Returns itself.
+		 */
+		mapped_reference &operator=(const mapped_reference &other) {
+			return *this = static_cast<mapped_type>(other);
+		}
+
+	private:
+		/// \internal \brief Creates a reference to an element.
+		mapped_reference(
+			packed_hash_map *map,
+			const key_type &key,
+			const mapped_type &mapped
+		)
+		: map(map)
+		, key(key)
+		, mapped(mapped) {}
+
+		/// \internal \brief The map holding the element.
+		packed_hash_map *map;
+
+		/// \internal \brief The key of the element.
+		key_type key;
+
+		/// \internal \brief The value created with or last assigned.
+		mapped_type mapped;
+	};
+
+	/** \brief The iterator type for the packed_hash_map.
+	 *
+	 * Like \ref const_iterator, except that dereferencing it yields a pair of
+	 * the key and a \ref mapped_reference, through which the value of the
+	 * element can be assigned.
+	 */
+	class iterator: public const_iterator {
+		friend struct packed_hash_map;
+
+	public:
+		/// \brief Dereferencing yields the key and a reference to the value.
+		typedef std::pair<const key_type, mapped_reference> reference;
+
+		/// \brief Provides <tt>operator-></tt> on the key and the reference.
+		class pointer {
+			friend class iterator;
+
+		public:
+			/// \brief Accesses the key and the reference.
+			reference *operator->() {
+				return &element;
+			}
+
+		private:
+			/// \internal \brief Wraps the key and the reference.
+			explicit pointer(const reference &element)
+			: element(element) {}
+
+			/// \internal \brief The key and the reference.
+			reference element;
+		};
+
+		/// \brief Default constructs an end iterator.
+		iterator()
+		: const_iterator()
+		, map(nullptr) {}
+
+		/// \brief Copies an iterator.
+		iterator(const iterator &) = default;
+
+		/// \brief Moves an iterator.
+		iterator(iterator &&) = default;
+
+		/// \brief Assigns an iterator.
+		iterator &operator=(const iterator &) = default;
+
+		/// \brief Assigns an iterator.
+		iterator &operator=(iterator &&) = default;
+
+		/// \copydoc const_iterator::operator++()
+		iterator &operator++() {
+			const_iterator::operator++();
+			return *this;
+		}
+
+		/// \copydoc const_iterator::operator++(int)
+		iterator operator++(int) {
+			iterator copy(*this);
+			++*this;
+			return copy;
+		}
+
+		/** \brief Dereferences the iterator.
+		 *
+		 * \return The key and a reference to the value of the element.
+		 */
+		reference operator*() const {
+			const value_type element = const_iterator::operator*();
+			return reference(
+				element.first,
+				mapped_reference(map, element.first, element.second)
+			);
+		}
+
+		/** \brief Dereferences the iterator.
+		 *
+		 * \return An object providing access to the key and a reference to
+		 *     the value of the element.
+		 */
+		pointer operator->() const {
+			return pointer(**this);
+		}
+
+	private:
+		/// \internal \brief Makes an iterator of a map mutable.
+		iterator(const const_iterator &it, packed_hash_map *map)
+		: const_iterator(it)
+		, map(map) {}
+
+		/// \internal \brief The map iterated.
+		packed_hash_map *map;
+	};
+///\}
+
+
+
+/// \name Member Functions
+///\{
+	/** \brief Creates an empty packed_hash_map.
+	 *
+	 * \param bucket_count The number of slots. The map grows beyond it if
+	 *     needed.
+	 * \param hash The hash function to use.
+	 * \param keycomp The key comparison function to use.
+	 * \param allocator The allocator to use.
+	 *
+	 * \pre
+	 *     - <tt>0 < bucket_count</tt>
+	 */
+	explicit packed_hash_map(
+		const size_type bucket_count,
+		const hasher &hash = hasher{},
+		const key_equal &keycomp = key_equal{},
+		const allocator_type &allocator = allocator_type{}
+	)
+	: current_table(slot_table::create(
+		bucket_count, hash, keycomp, allocator
+	)) {
+		assert( 0 < bucket_count
+			&& "can not have a packed_hash_map without slots" );
+	}
+
+	/** \brief Creates a copy of a packed_hash_map.
+	 *
+	 * \post
+	 *     - <tt>*this == other</tt>
+	 */
+	packed_hash_map(const packed_hash_map &other)
+	: current_table(std::atomic_load(&other.current_table)->copy()) {}
+
+	/** \brief Destructs the packed_hash_map.
+	 *
+	 * \post
+	 *     - All iterators are invalidated.
+	 */
+	~packed_hash_map() = default;
+
+	/** \brief Assigns all elements from another packed_hash_map to this one.
+	 *
+	 * \return A reference to this packed_hash_map.
+	 *
+	 * \post
+	 *     - <tt>*this == other</tt>
+	 */
+	packed_hash_map &operator=(const packed_hash_map &other) {
+		packed_hash_map temp(other);
+		swap(temp);
+		return *this;
+	}
+
+	/** \brief Swaps contents with another packed_hash_map.
+	 *
+	 * \param other The packed_hash_map to swap contents with.
+	 *
+	 * \note This function is not thread safe, for the same reasons as
+	 *     \ref hash_map::swap().
+	 */
+	void swap(packed_hash_map &other) {
+		table_pointer temp = std::atomic_exchange(
+			&other.current_table,
+			current_table
+		);
+		std::atomic_store(&current_table, temp);
+	}
+
+	/** \brief Compares the values in the packed_hash_map.
+	 *
+	 * \param other Another packed_hash_map to compare against.
+	 *
+	 * \pre
+	 *     - \c mapped_type is <tt>==</tt> comparable.
+	 *
+	 * \return
+	 *     - \c true if the contents of the containers are equal,
+	 *     - \c false otherwise.
+	 */
+	bool operator==(const packed_hash_map &other) const {
+		if (this == &other) {
+			return true;
+		}
+		if (size() != other.size()) {
+			return false;
+		}
+		for(const value_type &value: *this) {
+			const const_iterator it = other.find(value.first);
+			if (it == other.end() || !(it->second == value.second)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** \brief Compares the values in the packed_hash_map.
+	 *
+	 * \param other Another packed_hash_map to compare against.
+	 *
+	 * \return
+	 *     - \c true if the contents of the containers differ,
+	 *     - \c false otherwise.
+	 */
+	bool operator!=(const packed_hash_map &other) const {
+		return !operator==(other);
+	}
+
+	/** \brief Changes the number of slots and reinserts the elements.
+	 *
+	 * This also makes the slots of erased elements available again and
+	 * moves the elements of all overflow tables into a single table.
+	 *
+	 * \param new_bucket_count The new number of slots after rehashing.
+	 *
+	 * \pre
+	 *     - <tt>size() < new_bucket_count</tt>
+	 *
+	 * \post
+	 *     - <tt>bucket_count() == new_bucket_count</tt>, unless the
+	 *         \c traits_type::bucket_index_policy rounds bucket counts.
+	 *     - <tt>after_rehash == before_rehash</tt>
+	 *
+	 * \note If any allocations fail in the process, the value of the
+	 *     packed_hash_map will be unchanged.
+	 *
+	 * \note This function is not thread safe.
+	 */
+	void rehash(size_type new_bucket_count) {
+		assert( size() < new_bucket_count
+			&& "can not rehash into fewer slots than elements" );
+
+		std::atomic_store(
+			&current_table, current_table->copy(new_bucket_count)
+		);
+	}
+
+	/** \brief Returns the allocator.
+	 *
+	 * \return A copy of the allocator.
+	 */
+	allocator_type get_allocator() const {
+		return std::atomic_load(&current_table)->allocator;
+	}
+///\}
+
+
+
+/// \name Observers
+///\{
+/// \note These functions are thread safe.
+	/** \brief Returns the hash function.
+	 *
+	 * \return A copy of the hash function.
+	 */
+	hasher hash_function() const {
+		return std::atomic_load(&current_table)->hash;
+	}
+
+	/** \brief Returns the key comparison function.
+	 *
+	 * \return A copy of the key comparison function.
+	 */
+	key_equal key_eq() const {
+		return std::atomic_load(&current_table)->keycomp;
+	}
+///\}
+
+
+
+/// \name Iterators
+///\{
+/// \note These functions are thread safe.
+	/** \brief Returns an iterator to the first element.
+	 *
+	 * \return An iterator to the first element, or <tt>end()</tt> if the
+	 *     map is empty.
+	 */
+	const_iterator begin() const {
+		table_pointer table = std::atomic_load(&current_table);
+		const slot_table *const first = table.get();
+		return const_iterator(std::move(table), first, first->slots);
+	}
+
+	/// \copydoc begin()
+	iterator begin() {
+		return iterator(cbegin(), this);
+	}
+
+	/// \copydoc begin()
+	const_iterator cbegin() const {
+		return begin();
+	}
+
+	/** \brief Returns an iterator past the last element.
+	 *
+	 * \return An iterator past the last element.
+	 */
+	const_iterator end() const {
+		return const_iterator();
+	}
+
+	/// \copydoc end()
+	iterator end() {
+		return iterator();
+	}
+
+	/// \copydoc end()
+	const_iterator cend() const {
+		return end();
+	}
+///\}
+
+
+
+/// \name Capacity
+///\{
+/// \note These functions are thread safe.
+	/** \brief Checks whether the container is empty.
+	 *
+	 * \return
+	 *     - \c true if the container is empty,
+	 *     - \c false otherwise.
+	 */
+	bool empty() const {
+		return 0 == size();
+	}
+
+	/** \brief Returns the number of elements.
+	 *
+	 * \return The number of elements in the container.
+	 */
+	size_type size() const {
+		const table_pointer table = std::atomic_load(&current_table);
+		size_type count = 0;
+		for(const slot_table *t = table.get(); t; t = t->next_table()) {
+			count += t->element_count;
+		}
+		return count;
+	}
+
+	/** \brief Returns the maximum possible number of elements.
+	 *
+	 * \return The maximum possible number of elements in the container.
+	 */
+	size_type max_size() const {
+		return max_bucket_count();
+	}
+///\}
+
+
+
+/// \name Modifiers
+///\{
+/// \note These functions are thread safe.
+	/** \brief Clears the contents.
+	 *
+	 * The new table has as many slots as the first table of the chain.
+	 *
+	 * \post
+	 *     - <tt>empty() == true</tt>
+	 *     - All iterators to this packed_hash_map are invalidated.
+	 */
+	void clear() {
+		table_pointer table = std::atomic_load(&current_table);
+		table_pointer new_table = slot_table::create(
+			table->slot_count, table->hash, table->keycomp, table->allocator
+		);
+
+		// See hash_map::clear() for why a failure does not need a retry.
+		std::atomic_compare_exchange_strong(
+			&current_table, &table, new_table
+		);
+	}
+
+	/** \brief Inserts an element into the map.
+	 *
+	 * \param value The value to insert into the map.
+	 *
+	 * \return A pair \c pair as follows:
+	 *     - <tt>pair.first == true</tt>, if \c value was inserted
+	 *         successfully. <tt>pair.second</tt> will be an iterator to the
+	 *         newly inserted element.
+	 *     - <tt>pair.first == false</tt>, if an item with the given key exists
+	 *         already. <tt>pair.second</tt> will be an iterator to the
+	 *         element that blocked the insertion.
+	 *
+	 * \throw <tt>std::invalid_argument</tt> if the key of \c value is one of
+	 *     the two keys reserved for marking slots.
+	 */
+	std::pair<bool, iterator> insert(const value_type &value) {
+		check_key(value.first);
+
+		const word_type new_word = pack(value.first, value.second);
+
+		slot *found;
+		word_type word;
+		while(true) {
+			const modification change(current_table);
+			slot_table *t = change.table.get();
+			while(t) {
+				if (!t->probe(value.first, found, word)) {
+					t = overflow_for(change.table, *t);
+				}
+				else if (is_live(word)) {
+					return std::make_pair(false, iterator(
+						const_iterator(change.table, t, found, word), this
+					));
+				}
+				// an empty slot: claim it, unless someone else is faster
+				else if (found->compare_exchange_strong(
+					word, new_word, std::memory_order_acq_rel
+				)) {
+					++t->element_count;
+					return std::make_pair(true, iterator(
+						const_iterator(change.table, t, found, new_word), this
+					));
+				}
+				// else retry; the slot has been claimed, maybe for the same
+				// key
+			}
+			// the chain has been compacted; start over with the new one
+		}
+	}
+
+	/** \brief Inserts an element into the map.
+	 *
+	 * This function is equivalent to calling <tt>insert(value)</tt>.
+	 *
+	 * \param hint Ignored.
+	 * \param value The value to insert into the map.
+	 *
+	 * \return An iterator to the newly inserted element or to the existing
+	 *     element with they same key as \c value that blocked the insertion.
+	 *
+	 * \throw <tt>std::invalid_argument</tt> if the key of \c value is one of
+	 *     the two keys reserved for marking slots.
+	 */
+	iterator insert(const_iterator hint, const value_type &value) {
+		((void)hint); // unused, suppress warning
+		return insert(value).second;
+	}
+
+	/** \brief Inserts an element into the map or modifies an existing one.
+	 *
+	 * \param key The key of the element in the map.
+	 * \param mapped The value to insert or assign.
+	 *
+	 * \return An iterator to the element with key \c key.
+	 *
+	 * \throw <tt>std::invalid_argument</tt> if \c key is one of the two keys
+	 *     reserved for marking slots.
+	 */
+	iterator insert_or_assign(const key_type &key, const mapped_type &mapped) {
+		check_key(key);
+
+		const word_type new_word = pack(key, mapped);
+
+		slot *found;
+		word_type word;
+		while(true) {
+			const modification change(current_table);
+			slot_table *t = change.table.get();
+			while(t) {
+				if (!t->probe(key, found, word)) {
+					t = overflow_for(change.table, *t);
+				}
+				// the slot is empty or holds the key; either way, replace it.
+				// If it has been erased or claimed for another key in the
+				// meantime, probe again.
+				else if (found->compare_exchange_strong(
+					word, new_word, std::memory_order_acq_rel
+				)) {
+					if (!is_live(word)) {
+						++t->element_count;
+					}
+					return iterator(
+						const_iterator(change.table, t, found, new_word), this
+					);
+				}
+			}
+			// the chain has been compacted; start over with the new one
+		}
+	}
+
+	/** \brief Removes an element from the packed_hash_map by its key.
+	 *
+	 * \param key The key of the element in the packed_hash_map.
+	 *
+	 * \return The number of elements erased from the packed_hash_map
+	 *     (0 or 1).
+	 *
+	 * \post
+	 *     - <tt>find(key) == end()</tt>
+	 */
+	size_type erase(const key_type &key) {
+		if (is_reserved(key)) {
+			return 0;
+		}
+
+		const modification change(current_table);
+		const word_type erased_word = pack(erased_key(), mapped_type{});
+
+		slot_table *t = change.table.get();
+		slot *found;
+		word_type word;
+		while(t) {
+			if (!t->probe(key, found, word)) {
+				t = t->next_table();
+			}
+			else if (!is_live(word)) {
+				return 0;
+			}
+			else if (found->compare_exchange_strong(
+				word, erased_word, std::memory_order_acq_rel
+			)) {
+				--t->element_count;
+				++t->erased_count;
+				return 1;
+			}
+			// else the value has been changed or the element has been
+			// erased concurrently; probe again
+		}
+		return 0;
+	}
+
+	/** \brief Removes an element from the packed_hash_map by its iterator.
+	 *
+	 * \param pos An iterator to the element to erase.
+	 *
+	 * \return An iterator to the element after the deleted one.
+	 */
+	iterator erase(const_iterator pos) {
+		const iterator next(std::next(pos), this);
+		erase(pos->first);
+		return next;
+	}
+///\}
+
+
+
+/// \name Lookup
+///\{
+/// \note These functions are thread safe.
+	/** \brief Accesses an element by its key, with bounds-checking.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if no element with the key \c key is
+	 *     stored in the packed_hash_map.
+	 *
+	 * \return A reference to the value of the element requested.
+	 */
+	mapped_reference at(const key_type &key) {
+		const packed_hash_map &const_this = *this;
+		return mapped_reference(this, key, const_this.at(key));
+	}
+
+	/** \brief Accesses an element by its key, with bounds-checking.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if no element with the key \c key is
+	 *     stored in the packed_hash_map.
+	 *
+	 * \return A copy of the value of the element requested.
+	 */
+	mapped_type at(const key_type &key) const {
+		const const_iterator it = find(key);
+		if (it != cend()) {
+			return it->second;
+		}
+		else {
+			throw std::out_of_range("element not found in packed_hash_map");
+		}
+	}
+
+	/** \brief Accesses an element by its key.
+	 *
+	 * If necessary, inserts an element with a value initialized value
+	 * first.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::invalid_argument</tt> if \c key is one of the two keys
+	 *     reserved for marking slots.
+	 *
+	 * \return A reference to the value of the element requested.
+	 */
+	mapped_reference operator[](const key_type &key) {
+		return (*insert(std::make_pair(key, mapped_type{})).second).second;
+	}
+
+	/** \brief Counts the number of elements with a specific key.
+	 *
+	 * \param key The key of the element to count.
+	 *
+	 * \return The number of elements with the key \c key. (0 or 1)
+	 */
+	size_type count(const key_type &key) const {
+		return (find(key) != cend())
+			? 1
+			: 0;
+	}
+
+	/** \brief Finds an element by its key.
+	 *
+	 * \param key The key of the element to fetch.
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	iterator find(const key_type &key) {
+		const packed_hash_map &const_this = *this;
+		return iterator(const_this.find(key), this);
+	}
+
+	/// \copydoc find()
+	const_iterator find(const key_type &key) const {
+		if (is_reserved(key)) {
+			return end();
+		}
+
+		table_pointer table = std::atomic_load(&current_table);
+
+		slot *found;
+		word_type word;
+		for(const slot_table *t = table.get(); t; t = t->next_table()) {
+			if (t->probe(key, found, word)) {
+				return is_live(word)
+					? const_iterator(std::move(table), t, found, word)
+					: end();
+			}
+		}
+		return end();
+	}
+///\}
+
+
+
+/// \name Bucket Interface
+///\{
+/// \note These functions are thread safe.
+	/** \brief Returns the number of slots.
+	 *
+	 * \return The number of slots in this packed_hash_map, including those
+	 *     of overflow tables.
+	 */
+	size_type bucket_count() const {
+		const table_pointer table = std::atomic_load(&current_table);
+		size_type count = 0;
+		for(const slot_table *t = table.get(); t; t = t->next_table()) {
+			count += t->slot_count;
+		}
+		return count;
+	}
+
+	/** \brief Returns the maximum possible number of slots.
+	 *
+	 * \return The maximum possible number of slots in the container.
+	 */
+	size_type max_bucket_count() const {
+		return std::numeric_limits<size_type>::max() / sizeof(slot);
+	}
+
+	/** \brief Returns the slot an element with a key is searched from.
+	 *
+	 * \param key The key for which to retrieve the slot index.
+	 *
+	 * \return The index of the first slot probed for \c key in the first
+	 *     table.
+	 */
+	size_type bucket(const key_type &key) const {
+		const table_pointer table = std::atomic_load(&current_table);
+		return table->slot_index(static_cast<std::size_t>(table->hash(key)));
+	}
+///\}
+
+
+
+/// \internal \name Internals
+///\{ \internal
+private:
+	/// \internal \brief The key marking slots which never held an element.
+	static constexpr key_type empty_key() noexcept {
+		return std::numeric_limits<key_type>::max();
+	}
+
+	/// \internal \brief The key marking slots of erased elements.
+	static constexpr key_type erased_key() noexcept {
+		return std::numeric_limits<key_type>::max() - 1;
+	}
+
+	/// \internal \brief Checks whether a key is reserved for marking slots.
+	static bool is_reserved(const key_type &key) noexcept {
+		return key == empty_key() || key == erased_key();
+	}
+
+	/** \internal \brief Rejects the keys reserved for marking slots.
+	 *
+	 * \throw <tt>std::invalid_argument</tt> if \c key is reserved.
+	 */
+	static void check_key(const key_type &key) {
+		if (is_reserved(key)) {
+			throw std::invalid_argument(
+				"the two largest keys are reserved by packed_hash_map"
+			);
+		}
+	}
+
+	/** \internal \brief Packs a key and a value into a word.
+	 *
+	 * The key takes the first bytes of the word, the value the following
+	 * ones. Unused bytes are zero.
+	 */
+	static word_type pack(const key_type &key, const mapped_type &mapped) {
+		unsigned char bytes[sizeof(word_type)] = {};
+		std::memcpy(bytes, &key, sizeof(key_type));
+		std::memcpy(bytes + sizeof(key_type), &mapped, sizeof(mapped_type));
+
+		word_type word;
+		std::memcpy(&word, bytes, sizeof(word_type));
+		return word;
+	}
+
+	/// \internal \brief Extracts the key from a word.
+	static key_type unpack_key(word_type word) {
+		key_type key;
+		std::memcpy(&key, &word, sizeof(key_type));
+		return key;
+	}
+
+	/// \internal \brief Extracts the value from a word.
+	static mapped_type unpack_mapped(word_type word) {
+		unsigned char bytes[sizeof(word_type)];
+		std::memcpy(bytes, &word, sizeof(word_type));
+
+		mapped_type mapped;
+		std::memcpy(&mapped, bytes + sizeof(key_type), sizeof(mapped_type));
+		return mapped;
+	}
+
+	/// \internal \brief Checks whether a word holds an element.
+	static bool is_live(word_type word) {
+		return !is_reserved(unpack_key(word));
+	}
+
+	/** \internal \brief A fixed size array of slots.
+	 *
+	 * Slots only ever change from empty to holding an element, between
+	 * elements with the same key and from holding an element to erased.
+	 * Keys are probed for until the first empty slot, which is also where
+	 * new keys are inserted, so two insertions of the same key always race
+	 * for the same slot and a key is held by at most one slot.
+	 *
+	 * Probing gives up after \ref max_probe_length slots. Keys whose probe
+	 * sequence has no empty slot left go to the overflow table, where the
+	 * same rules apply. An empty slot never becomes empty again once it has
+	 * been used, so if a table has an empty slot on the probe sequence of a
+	 * key, the key can not be in any later table; if it has none, the key
+	 * can never be added to it. A key is thus held by at most one slot of
+	 * the whole chain.
+	 *
+	 * Erased slots are only freed by replacing the whole chain with a
+	 * compacted copy, see \ref compact().
+	 */
+	struct slot_table {
+		/// \internal \brief The allocator for slots.
+		typedef typename std::allocator_traits<allocator_type>
+			::template rebind_alloc<slot> slot_allocator_type;
+
+		/// \internal \brief The allocator traits for slots.
+		typedef typename std::allocator_traits<allocator_type>
+			::template rebind_traits<slot> slot_allocator_traits;
+
+		/** \internal
+		 * \brief Creates a slot table.
+		 *
+		 * \param slot_count The number of slots in this table.
+		 * \param hash The hash function used for keys.
+		 * \param keycomp The comparison function used for keys.
+		 * \param allocator The allocator to use for allocating the slots.
+		 */
+		static table_pointer create(
+			size_type slot_count,
+			const hasher &hash,
+			const key_equal &keycomp,
+			const allocator_type &allocator
+		) {
+			return std::allocate_shared<slot_table, allocator_type>(
+				allocator, slot_count, hash, keycomp, allocator
+			);
+		}
+
+		/** \internal \brief Creates a table of empty slots.
+		 *
+		 * \param requested_slot_count The number of slots requested for
+		 *     this table. The bucket index policy may round it up.
+		 * \param hash The hash function used for keys.
+		 * \param keycomp The comparison function used for keys.
+		 * \param allocator The allocator to use for allocating the slots.
+		 */
+		slot_table(
+			size_type requested_slot_count,
+			const hasher &hash,
+			const key_equal &keycomp,
+			const allocator_type &allocator
+		)
+		: slot_index(requested_slot_count)
+		, slot_count(slot_index.bucket_count())
+		, element_count(0)
+		, erased_count(0)
+		, modifications(0)
+		, compacting(false)
+		, hash(hash)
+		, keycomp(keycomp)
+		, allocator(allocator)
+		, slot_allocator(allocator)
+		, slots(slot_allocator_traits::allocate(slot_allocator, slot_count))
+		, overflow() {
+			const word_type empty_word = pack(empty_key(), mapped_type{});
+			for(size_type n=0; n < slot_count; ++n) {
+				slot_allocator_traits::construct(
+					slot_allocator, slots + n, empty_word
+				);
+			}
+		}
+
+		slot_table(const slot_table &) = delete;
+		slot_table &operator=(const slot_table &) = delete;
+
+		/// \internal \brief The maximum number of slots probed for a key.
+		static constexpr size_type max_probe_length = 64;
+
+		/// \internal \brief Destroys the slot table.
+		~slot_table() {
+			for(size_type n=0; n < slot_count; ++n) {
+				slot_allocator_traits::destroy(slot_allocator, slots + n);
+			}
+			slot_allocator_traits::deallocate(slot_allocator, slots, slot_count);
+		}
+
+		/** \internal \brief Copies the chain slot by slot.
+		 *
+		 * Every element keeps its slot, so the copy iterates in the same
+		 * order as the original.
+		 *
+		 * \note Concurrent modifications may or may not be copied. Keys
+		 *     inserted concurrently may have been copied into a slot where
+		 *     they can not be found, or twice; such copies are erased again.
+		 */
+		table_pointer copy() const {
+			table_pointer new_table = create(
+				slot_count, hash, keycomp, allocator
+			);
+
+			// the new chain is not shared yet
+			slot_table *target = new_table.get();
+			for(const slot_table *t = this; t; t = t->next_table()) {
+				assert( target->slot_count == t->slot_count
+					&& "overflow tables are created alike" );
+				for(size_type n=0; n < t->slot_count; ++n) {
+					const word_type word
+						= t->slots[n].load(std::memory_order_acquire);
+					target->slots[n].store(word, std::memory_order_relaxed);
+					if (is_live(word)) {
+						++target->element_count;
+					}
+					else if (unpack_key(word) == erased_key()) {
+						++target->erased_count;
+					}
+				}
+				if (t->next_table()) {
+					target = &target->grow();
+				}
+			}
+
+			const word_type erased_word = pack(erased_key(), mapped_type{});
+			for(slot_table *t = new_table.get(); t; t = t->next_table()) {
+				for(size_type n=0; n < t->slot_count; ++n) {
+					const word_type word
+						= t->slots[n].load(std::memory_order_relaxed);
+					if (is_live(word) && !new_table->holds(t->slots + n)) {
+						t->slots[n].store(erased_word, std::memory_order_relaxed);
+						--t->element_count;
+						++t->erased_count;
+					}
+				}
+			}
+			return new_table;
+		}
+
+		/** \internal \brief Copies the elements of the chain into a new
+		 *     table.
+		 *
+		 * \param new_slot_count The number of slots of the new table.
+		 *
+		 * \note Concurrent modifications may or may not be copied.
+		 */
+		table_pointer copy(size_type new_slot_count) const {
+			table_pointer new_table = create(
+				new_slot_count, hash, keycomp, allocator
+			);
+			for(const slot_table *t = this; t; t = t->next_table()) {
+				for(size_type n=0; n < t->slot_count; ++n) {
+					const word_type word
+						= t->slots[n].load(std::memory_order_acquire);
+					if (!is_live(word)) {
+						continue;
+					}
+
+					// the new table is not shared yet
+					slot_table *target = new_table.get();
+					slot *found;
+					word_type found_word;
+					while(!target->probe(unpack_key(word), found, found_word)) {
+						target = &target->grow();
+					}
+					found->store(word, std::memory_order_relaxed);
+					++target->element_count;
+				}
+			}
+			return new_table;
+		}
+
+		/** \internal \brief Checks whether erased elements take up at least
+		 *     half of the slots.
+		 */
+		bool mostly_erased() const {
+			return slot_count <= 2 * erased_count;
+		}
+
+		/** \internal \brief Checks whether a slot of the chain is the one its
+		 *     key is found in.
+		 */
+		bool holds(const slot *pos) const {
+			const key_type key = unpack_key(pos->load(std::memory_order_relaxed));
+
+			slot *found;
+			word_type word;
+			for(const slot_table *t = this; t; t = t->next_table()) {
+				if (t->probe(key, found, word)) {
+					return found == pos;
+				}
+			}
+			return false;
+		}
+
+		/** \internal \brief Returns the overflow table, if any.
+		 *
+		 * \return The next table of the chain, or \c nullptr.
+		 */
+		slot_table *next_table() const {
+			return std::atomic_load(&overflow).get();
+		}
+
+		/** \internal \brief Returns the overflow table, creating it if needed.
+		 *
+		 * The overflow table has twice as many slots as this one. If several
+		 * threads create it at once, the first one wins.
+		 *
+		 * \return The next table of the chain.
+		 */
+		slot_table &grow() {
+			table_pointer next = std::atomic_load(&overflow);
+			if (!next) {
+				table_pointer new_table = create(
+					slot_count * 2, hash, keycomp, allocator
+				);
+				if (std::atomic_compare_exchange_strong(
+					&overflow, &next, new_table
+				)) {
+					return *new_table;
+				}
+				// someone else was faster; next is their table
+			}
+			return *next;
+		}
+
+		/** \internal \brief Finds the slot for a key.
+		 *
+		 * \param key The key to look for.
+		 * \param[out] found The slot holding \c key, or the first empty slot
+		 *     on its probe sequence.
+		 * \param[out] word The contents of \c found.
+		 *
+		 * \return
+		 *     - \c true if a slot has been found,
+		 *     - \c false if all slots probed hold or held other keys.
+		 */
+		bool probe(const key_type &key, slot *&found, word_type &word) const {
+			assert( !is_reserved(key)
+				&& "the two largest keys are reserved by packed_hash_map" );
+
+			size_type index = slot_index(static_cast<std::size_t>(hash(key)));
+			const size_type probe_length = (slot_count < max_probe_length)
+				? slot_count
+				: max_probe_length;
+			for(size_type n=0; n < probe_length; ++n) {
+				word = slots[index].load(std::memory_order_acquire);
+				const key_type slot_key = unpack_key(word);
+				if (
+					slot_key == empty_key() ||
+					(slot_key != erased_key() && keycomp(key, slot_key))
+				) {
+					found = slots + index;
+					return true;
+				}
+				index = (index + 1 == slot_count) ? 0 : index + 1;
+			}
+			return false;
+		}
+
+		/// \internal \brief Maps hashes to slots.
+		const bucket_index_policy slot_index;
+
+		/// \internal \brief The number of slots in the table.
+		const size_type slot_count;
+
+		/// \internal \brief The current number of elements in the table.
+		std::atomic<size_type> element_count;
+
+		/// \internal \brief The number of slots of erased elements.
+		std::atomic<size_type> erased_count;
+
+		/** \internal \brief The number of modifications of the chain in
+		 *     progress. Only used in the first table of a chain.
+		 */
+		std::atomic<size_type> modifications;
+
+		/** \internal \brief Whether the chain is being compacted. Only used
+		 *     in the first table of a chain.
+		 */
+		std::atomic<bool> compacting;
+
+		/// \internal \brief The hash function used for keys.
+		const hasher hash;
+
+		/// \internal \brief The comparator for element keys.
+		const key_equal keycomp;
+
+		/// \internal \brief The allocator used to handle allocations.
+		const allocator_type allocator;
+
+	private:
+		/// \internal \brief The allocator used for the slots.
+		slot_allocator_type slot_allocator;
+
+	public:
+		/// \internal \brief The slots.
+		slot *const slots;
+
+	private:
+		/// \internal \brief The table keys go to if this one is full.
+		table_pointer overflow;
+	};
+
+	/** \internal \brief Registers a modification of the current chain.
+	 *
+	 * A chain is only compacted while no modifications of it are
+	 * registered. While the current chain is being compacted, registering
+	 * waits until the compacted chain has replaced it.
+	 */
+	struct modification {
+		/** \internal \brief Registers a modification of the current chain.
+		 *
+		 * \param current_table The current chain of the map.
+		 */
+		explicit modification(const table_pointer &current_table)
+		: table() {
+			while(true) {
+				table = std::atomic_load(&current_table);
+				++table->modifications;
+				if (!table->compacting) {
+					return;
+				}
+				--table->modifications;
+
+				while(
+					table->compacting &&
+					std::atomic_load(&current_table) == table
+				) {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		modification(const modification &) = delete;
+		modification &operator=(const modification &) = delete;
+
+		/// \internal \brief Unregisters the modification.
+		~modification() {
+			--table->modifications;
+		}
+
+		/// \internal \brief The chain being modified.
+		table_pointer table;
+	};
+
+	/** \internal \brief Assigns a value to an existing element.
+	 *
+	 * Does nothing if there is no element with the key \c key.
+	 *
+	 * \param key The key of the element.
+	 * \param mapped The value to assign.
+	 */
+	void assign(const key_type &key, const mapped_type &mapped) {
+		const modification change(current_table);
+		const word_type new_word = pack(key, mapped);
+
+		slot_table *t = change.table.get();
+		slot *found;
+		word_type word;
+		while(t) {
+			if (!t->probe(key, found, word)) {
+				t = t->next_table();
+			}
+			else if (!is_live(word)) {
+				return;
+			}
+			else if (found->compare_exchange_strong(
+				word, new_word, std::memory_order_acq_rel
+			)) {
+				return;
+			}
+			// else the value has been changed or the element has been
+			// erased concurrently; probe again
+		}
+	}
+
+	/** \internal \brief Returns the table to probe for a key next, after
+	 *     a table without room for it.
+	 *
+	 * If erased elements take up most of the full table, the chain is
+	 * compacted instead of growing it further.
+	 *
+	 * \param table The chain, as registered by the calling modification.
+	 * \param full The table without room for the key.
+	 *
+	 * \return The overflow table of \c full, or \c nullptr if the caller has
+	 *     to start over with the compacted chain.
+	 */
+	slot_table *overflow_for(const table_pointer &table, slot_table &full) {
+		if (full.mostly_erased()) {
+			compact(table);
+			return nullptr;
+		}
+		return &full.grow();
+	}
+
+	/** \internal \brief Replaces a chain by a copy without erased elements.
+	 *
+	 * Waits for all other modifications of the chain to finish, and keeps
+	 * new ones waiting until the copy has replaced it. If another thread is
+	 * compacting the chain already, this returns right away.
+	 *
+	 * \param table The chain, as registered by the calling modification.
+	 */
+	void compact(const table_pointer &table) {
+		bool compacting = false;
+		if (!table->compacting.compare_exchange_strong(compacting, true)) {
+			return;
+		}
+
+		// the modification of the calling thread is the one left
+		while(table->modifications != 1) {
+			std::this_thread::yield();
+		}
+
+		size_type element_count = 0;
+		for(const slot_table *t = table.get(); t; t = t->next_table()) {
+			element_count += t->element_count;
+		}
+		size_type new_slot_count = table->slot_count;
+		while(new_slot_count < 2 * element_count) {
+			new_slot_count *= 2;
+		}
+
+		table_pointer new_table;
+		try {
+			new_table = table->copy(new_slot_count);
+		}
+		catch(...) {
+			table->compacting = false;
+			throw;
+		}
+
+		// fails only if clear() has replaced the chain in the meantime
+		table_pointer expected = table;
+		std::atomic_compare_exchange_strong(
+			&current_table, &expected, new_table
+		);
+	}
+
+	/// \internal \brief The current slot table.
+	table_pointer current_table;
+///\}
+};
+
+#endif // PACKED_HASH_MAP_HPP_INCLUDED
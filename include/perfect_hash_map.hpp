@@ -0,0 +1,500 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef PERFECT_HASH_MAP_HPP_INCLUDED
+#define PERFECT_HASH_MAP_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <stdexcept>
+#include <type_traits>
+
+/** \brief A hash function which can be evaluated at compile time.
+ *
+ * Hashes integers, enumerations and null terminated strings.
+ */
+struct perfect_hash {
+	/** \brief Calculates the hash of an integer or enumeration.
+	 *
+	 * \param key The key to hash.
+	 *
+	 * \return The hash of \c key.
+	 */
+	template<typename T>
+	constexpr std::enable_if_t<
+		std::is_integral<T>::value || std::is_enum<T>::value,
+		std::uint64_t
+	> operator()(T key) const noexcept {
+		return mix(static_cast<std::uint64_t>(key));
+	}
+
+	/** \brief Calculates the hash of a null terminated string.
+	 *
+	 * \param key The string to hash.
+	 *
+	 * \return The hash of \c key.
+	 */
+	constexpr std::uint64_t operator()(const char *key) const noexcept {
+		// FNV-1a
+		std::uint64_t hash = UINT64_C(0xcbf29ce484222325);
+		for(; *key; ++key) {
+			hash = (hash ^ static_cast<unsigned char>(*key))
+				* UINT64_C(0x100000001b3);
+		}
+		return mix(hash);
+	}
+
+	/** \brief Mixes the bits of a hash.
+	 *
+	 * This is the finalizer of MurmurHash3.
+	 *
+	 * \param hash The hash to mix.
+	 *
+	 * \return The mixed hash.
+	 */
+	static constexpr std::uint64_t mix(std::uint64_t hash) noexcept {
+		hash ^= hash >> 33;
+		hash *= UINT64_C(0xff51afd7ed558ccd);
+		hash ^= hash >> 33;
+		hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+		hash ^= hash >> 33;
+		return hash;
+	}
+};
+
+/** \brief A key comparator which can be evaluated at compile time.
+ *
+ * Compares integers and enumerations by value and null terminated strings by
+ * their characters.
+ */
+struct perfect_key_equal {
+	/** \brief Compares two integers or enumerations.
+	 *
+	 * \return \c true if \c a equals \c b.
+	 */
+	template<typename T>
+	constexpr std::enable_if_t<
+		std::is_integral<T>::value || std::is_enum<T>::value,
+		bool
+	> operator()(T a, T b) const noexcept {
+		return a == b;
+	}
+
+	/** \brief Compares two null terminated strings.
+	 *
+	 * \return \c true if \c a and \c b have the same characters.
+	 */
+	constexpr bool operator()(const char *a, const char *b) const noexcept {
+		for(; *a && *a == *b; ++a, ++b);
+		return *a == *b;
+	}
+};
+
+/** \brief The storage type stored in a \ref perfect_hash_map.
+ *
+ * Unlike <tt>std::pair</tt>, this can be assigned at compile time.
+ */
+template<typename Key, typename T>
+struct perfect_hash_entry {
+	/// \brief The key.
+	Key first;
+
+	/// \brief The value.
+	T second;
+};
+
+/** \brief An immutable map with a collision free hash table, which can be
+ *     built at compile time.
+ * \nosubgrouping
+ *
+ * The table is built by hash and displace: Keys are distributed into
+ * buckets by their hash, and every bucket gets a seed which places all of
+ * its keys into distinct free slots. Looking up a key thus takes one hash,
+ * one mix with the seed of its bucket and one key comparison, without
+ * probing or walking chains.
+ *
+ * Built as a \c constexpr variable by \ref make_perfect_hash_map(), the
+ * table is part of the program image, so there is no startup cost either:
+ *
+ * \code
+ * constexpr auto opcodes = make_perfect_hash_map<const char *, int>({
+ *     {"GET", 1}, {"PUT", 2}, {"DELETE", 3}
+ * });
+ * static_assert( opcodes.at("PUT") == 2, "" );
+ * \endcode
+ *
+ * The lookup interface follows \ref hash_map.
+ *
+ * \tparam Key The type for element keys. Must be a literal type.
+ * \tparam T The type for element values. Must be a default constructible
+ *     literal type.
+ * \tparam N The number of elements.
+ * \tparam Hash The type of the hash function. Must be usable at compile time
+ *     and return 64 bit hashes.
+ * \tparam KeyEqual The type of the key equality comparator. Must be usable at
+ *     compile time.
+ */
+template<
+	typename Key,
+	typename T,
+	std::size_t N,
+	typename Hash = perfect_hash,
+	typename KeyEqual = perfect_key_equal
+>
+class perfect_hash_map {
+	static_assert( 0 < N,
+		"perfect_hash_map needs at least one element." );
+	static_assert( N < UINT32_MAX,
+		"perfect_hash_map supports less than 2^32 elements." );
+
+public:
+/// \name Member Types
+///\{
+	/// \brief The type used for element counts and indices.
+	typedef std::size_t    size_type;
+
+	/// \brief The type for element keys.
+	typedef Key            key_type;
+
+	/// \brief The type for element values.
+	typedef T              mapped_type;
+
+	/// \brief The type of the hash function.
+	typedef Hash           hasher;
+
+	/// \brief The type of the key equality comparator.
+	typedef KeyEqual       key_equal;
+
+	/// \brief The storage type stored in the map.
+	typedef perfect_hash_entry<Key, T> value_type;
+
+	/// \brief The iterator type for the perfect_hash_map.
+	typedef const value_type *const_iterator;
+
+	/// \brief Elements can not be modified.
+	typedef const_iterator     iterator;
+///\}
+
+
+
+/// \name Member Functions
+///\{
+	/** \brief Builds the map.
+	 *
+	 * \param elements The elements of the map.
+	 * \param hash The hash function to use.
+	 * \param keycomp The key comparison function to use.
+	 *
+	 * \throw <tt>std::invalid_argument</tt> if two elements have the same
+	 *     key or no seed is found for a bucket. If the map is built at
+	 *     compile time, this is reported as an error by the compiler.
+	 */
+	constexpr perfect_hash_map(
+		const value_type (&elements)[N],
+		const hasher &hash = hasher{},
+		const key_equal &keycomp = key_equal{}
+	)
+	: hash(hash)
+	, keycomp(keycomp)
+	, elements()
+	, seeds()
+	, slots() {
+		for(size_type n = 0; n < N; ++n) {
+			this->elements[n] = elements[n];
+		}
+		build();
+	}
+///\}
+
+
+
+/// \name Iterators
+///\{
+	/// \brief Returns an iterator to the first element.
+	constexpr const_iterator begin() const noexcept {
+		return elements;
+	}
+
+	/// \brief Returns an iterator to the first element.
+	constexpr const_iterator cbegin() const noexcept {
+		return begin();
+	}
+
+	/// \brief Returns an iterator past the last element.
+	constexpr const_iterator end() const noexcept {
+		return elements + N;
+	}
+
+	/// \brief Returns an iterator past the last element.
+	constexpr const_iterator cend() const noexcept {
+		return end();
+	}
+///\}
+
+
+
+/// \name Capacity
+///\{
+	/// \brief Checks whether the container is empty.
+	constexpr bool empty() const noexcept {
+		return false;
+	}
+
+	/// \brief Returns the number of elements.
+	constexpr size_type size() const noexcept {
+		return N;
+	}
+
+	/// \brief Returns the maximum possible number of elements.
+	constexpr size_type max_size() const noexcept {
+		return N;
+	}
+///\}
+
+
+
+/// \name Lookup
+///\{
+	/** \brief Accesses an element by its key, with bounds-checking.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if no element with the key \c key is
+	 *     stored in the map.
+	 *
+	 * \return A constant reference to the element requested.
+	 */
+	constexpr const mapped_type &at(const key_type &key) const {
+		const const_iterator it = find(key);
+		if (it == end()) {
+			throw std::out_of_range("element not found in perfect_hash_map");
+		}
+		return it->second;
+	}
+
+	/** \brief Counts the number of elements with a specific key.
+	 *
+	 * \param key The key of the element to count.
+	 *
+	 * \return The number of elements with the key \c key. (0 or 1)
+	 */
+	constexpr size_type count(const key_type &key) const {
+		return (find(key) != end())
+			? 1
+			: 0;
+	}
+
+	/** \brief Finds an element by its key.
+	 *
+	 * \param key The key of the element to fetch.
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	constexpr const_iterator find(const key_type &key) const {
+		const std::uint64_t key_hash = hash(key);
+		const std::uint32_t index
+			= slots[slot_for(key_hash, seeds[bucket_for(key_hash)])];
+		return (index != empty_slot && keycomp(elements[index].first, key))
+			? elements + index
+			: end();
+	}
+///\}
+
+
+
+/// \name Bucket Interface
+///\{
+	/** \brief Returns the number of slots.
+	 *
+	 * \return The number of slots of the hash table, which is the smallest
+	 *     power of two not less than twice the number of elements.
+	 */
+	constexpr size_type bucket_count() const noexcept {
+		return slot_count;
+	}
+///\}
+
+
+
+/// \name Observers
+///\{
+	/// \brief Returns the hash function.
+	constexpr hasher hash_function() const {
+		return hash;
+	}
+
+	/// \brief Returns the key comparison function.
+	constexpr key_equal key_eq() const {
+		return keycomp;
+	}
+///\}
+
+
+
+/// \internal \name Internals
+///\{ \internal
+private:
+	/// \internal \brief Computes the number of slots.
+	static constexpr size_type slot_count_for(size_type elements) noexcept {
+		size_type count = 1;
+		while(count < 2 * elements) {
+			count *= 2;
+		}
+		return count;
+	}
+
+	/// \internal \brief The number of buckets.
+	static constexpr size_type bucket_count_ = N;
+
+	/// \internal \brief The number of slots.
+	static constexpr size_type slot_count = slot_count_for(N);
+
+	/// \internal \brief Marks slots without an element.
+	static constexpr std::uint32_t empty_slot = UINT32_MAX;
+
+	/// \internal \brief The maximum number of seeds tried per bucket.
+	static constexpr std::uint32_t max_seed = 1 << 16;
+
+	/// \internal \brief Maps a hash to a bucket.
+	static constexpr size_type bucket_for(std::uint64_t key_hash) noexcept {
+		return static_cast<size_type>((key_hash >> 32) % bucket_count_);
+	}
+
+	/// \internal \brief Maps a hash to a slot, displaced by a seed.
+	static constexpr size_type slot_for(
+		std::uint64_t key_hash,
+		std::uint32_t seed
+	) noexcept {
+		return static_cast<size_type>(
+			perfect_hash::mix(key_hash + seed * UINT64_C(0x9e3779b97f4a7c15))
+				& (slot_count - 1)
+		);
+	}
+
+	/** \internal \brief Builds the hash table.
+	 *
+	 * Buckets are placed from the largest to the smallest, as larger buckets
+	 * are harder to place into a fuller table. For every bucket, seeds are
+	 * tried in order until all of its keys fall into distinct free slots.
+	 */
+	constexpr void build() {
+		std::uint64_t hashes[N] = {};
+		size_type bucket_sizes[bucket_count_] = {};
+		size_type largest = 0;
+		for(size_type n = 0; n < N; ++n) {
+			hashes[n] = hash(elements[n].first);
+			const size_type size = ++bucket_sizes[bucket_for(hashes[n])];
+			largest = (size > largest) ? size : largest;
+		}
+		for(size_type s = 0; s < slot_count; ++s) {
+			slots[s] = empty_slot;
+		}
+
+		for(size_type size = largest; size > 0; --size) {
+			for(size_type b = 0; b < bucket_count_; ++b) {
+				if (bucket_sizes[b] == size) {
+					place_bucket(b, hashes);
+				}
+			}
+		}
+	}
+
+	/** \internal \brief Finds a seed for a bucket and places its elements.
+	 *
+	 * \param bucket The bucket to place.
+	 * \param hashes The hashes of all keys.
+	 */
+	constexpr void place_bucket(size_type bucket, const std::uint64_t (&hashes)[N]) {
+		for(std::uint32_t seed = 0; seed < max_seed; ++seed) {
+			if (try_seed(bucket, seed, hashes)) {
+				seeds[bucket] = seed;
+				return;
+			}
+		}
+		throw std::invalid_argument("no perfect hash found for perfect_hash_map");
+	}
+
+	/** \internal \brief Places the elements of a bucket using a seed.
+	 *
+	 * \return
+	 *     - \c true if all elements have been placed,
+	 *     - \c false if a slot has been occupied already, in which case no
+	 *         element has been placed.
+	 *
+	 * \throw <tt>std::invalid_argument</tt> if two elements of the bucket
+	 *     have the same key.
+	 */
+	constexpr bool try_seed(
+		size_type bucket,
+		std::uint32_t seed,
+		const std::uint64_t (&hashes)[N]
+	) {
+		size_type placed = 0;
+		for(size_type n = 0; n < N; ++n) {
+			if (bucket_for(hashes[n]) != bucket) {
+				continue;
+			}
+
+			const size_type slot = slot_for(hashes[n], seed);
+			if (slots[slot] != empty_slot) {
+				const std::uint32_t other = slots[slot];
+				if (
+					hashes[other] == hashes[n] &&
+					keycomp(elements[other].first, elements[n].first)
+				) {
+					throw std::invalid_argument(
+						"duplicate key in perfect_hash_map");
+				}
+
+				// undo this attempt
+				for(size_type m = 0; m < n && placed; ++m) {
+					if (bucket_for(hashes[m]) == bucket) {
+						slots[slot_for(hashes[m], seed)] = empty_slot;
+						--placed;
+					}
+				}
+				return false;
+			}
+			slots[slot] = static_cast<std::uint32_t>(n);
+			++placed;
+		}
+		return true;
+	}
+
+	/// \internal \brief The hash function.
+	hasher hash;
+
+	/// \internal \brief The key comparator.
+	key_equal keycomp;
+
+	/// \internal \brief The elements, in the order they were given.
+	value_type elements[N];
+
+	/// \internal \brief The seed of every bucket.
+	std::uint32_t seeds[bucket_count_];
+
+	/// \internal \brief The index of the element in every slot.
+	std::uint32_t slots[slot_count];
+///\}
+};
+
+/** \brief Builds a \ref perfect_hash_map.
+ *
+ * \param elements The elements of the map.
+ *
+ * \return A \ref perfect_hash_map with \c elements.
+ *
+ * \throw <tt>std::invalid_argument</tt> if two elements have the same key.
+ */
+template<typename Key, typename T, std::size_t N>
+constexpr perfect_hash_map<Key, T, N> make_perfect_hash_map(
+	const perfect_hash_entry<Key, T> (&elements)[N]
+) {
+	return perfect_hash_map<Key, T, N>(elements);
+}
+
+#endif // PERFECT_HASH_MAP_HPP_INCLUDED
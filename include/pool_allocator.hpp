@@ -0,0 +1,345 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef POOL_ALLOCATOR_HPP_INCLUDED
+#define POOL_ALLOCATOR_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+/** \internal \brief Hands out memory blocks of a single size.
+ *
+ * Blocks are carved out of large chunks, without any per-block header, and
+ * recycled through free lists. Every thread keeps a small cache of free
+ * blocks, so most allocations and deallocations do not touch shared state;
+ * the cache is refilled from and drained to a shared free list in batches.
+ *
+ * Chunks are never returned to the system: Freed blocks are kept for later
+ * allocations of the same size.
+ *
+ * \tparam BlockSize The size of the blocks.
+ * \tparam BlockAlign The alignment of the blocks.
+ */
+template<std::size_t BlockSize, std::size_t BlockAlign>
+class fixed_size_pool {
+	static_assert( BlockAlign <= alignof(std::max_align_t),
+		"blocks can not be aligned beyond the alignment of operator new" );
+
+public:
+	/** \internal \brief Allocates a block.
+	 *
+	 * \return A pointer to a block of at least \c BlockSize bytes.
+	 *
+	 * \throw <tt>std::bad_alloc</tt> if a new chunk can not be allocated.
+	 */
+	static void *allocate() {
+		if (cache_destroyed) {
+			// during thread exit, after the cache has been destroyed
+			std::lock_guard<std::mutex> lock(shared().mutex);
+			return pop_shared();
+		}
+
+		local_cache &cache = local();
+		if (!cache.free) {
+			refill(cache);
+		}
+		free_block *block = cache.free;
+		cache.free = block->next;
+		--cache.count;
+		return block;
+	}
+
+	/** \internal \brief Releases a block.
+	 *
+	 * \param p A block returned by \ref allocate().
+	 */
+	static void deallocate(void *p) noexcept {
+		free_block *block = static_cast<free_block *>(p);
+
+		if (cache_destroyed) {
+			std::lock_guard<std::mutex> lock(shared().mutex);
+			block->next = shared().free;
+			shared().free = block;
+			return;
+		}
+
+		local_cache &cache = local();
+		block->next = cache.free;
+		cache.free = block;
+		if (++cache.count >= 2 * batch_size) {
+			drain(cache, batch_size);
+		}
+	}
+
+private:
+	/// \internal \brief A block which is not in use.
+	struct free_block {
+		/// \internal \brief The next free block in the same list.
+		free_block *next;
+	};
+
+	/// \internal \brief The alignment of the blocks.
+	static constexpr std::size_t block_align =
+		(BlockAlign < alignof(free_block)) ? alignof(free_block) : BlockAlign;
+
+	/// \internal \brief The size of the blocks, including room for the link.
+	static constexpr std::size_t block_size =
+		(((BlockSize < sizeof(free_block)) ? sizeof(free_block) : BlockSize)
+			+ block_align - 1) / block_align * block_align;
+
+	/// \internal \brief The number of blocks moved between caches at once.
+	static constexpr std::size_t batch_size = 32;
+
+	/// \internal \brief The maximum number of blocks in a chunk.
+	static constexpr std::size_t max_chunk_blocks = 4096;
+
+	/// \internal \brief The state shared by all threads.
+	struct shared_state {
+		/// \internal \brief Creates an empty pool.
+		shared_state() noexcept
+		: mutex()
+		, free(nullptr)
+		, unused(nullptr)
+		, unused_end(nullptr)
+		, next_chunk_blocks(64) {}
+
+		/// \internal \brief Guards all other members.
+		std::mutex mutex;
+
+		/// \internal \brief Blocks released by threads.
+		free_block *free;
+
+		/// \internal \brief The first never used block of the newest chunk.
+		char *unused;
+
+		/// \internal \brief The end of the newest chunk.
+		char *unused_end;
+
+		/// \internal \brief The number of blocks of the next chunk.
+		std::size_t next_chunk_blocks;
+	};
+
+	/// \internal \brief The free blocks of a thread.
+	struct local_cache {
+		/// \internal \brief Creates an empty cache.
+		local_cache() noexcept
+		: free(nullptr)
+		, count(0) {}
+
+		local_cache(const local_cache &) = delete;
+		local_cache &operator=(const local_cache &) = delete;
+
+		/// \internal \brief Returns all cached blocks to the shared state.
+		~local_cache() {
+			drain(*this, count);
+			cache_destroyed = true;
+		}
+
+		/// \internal \brief The cached blocks.
+		free_block *free;
+
+		/// \internal \brief The number of cached blocks.
+		std::size_t count;
+	};
+
+	/** \internal \brief Returns the shared state.
+	 *
+	 * The state is never destroyed, so blocks can still be released by
+	 * objects destroyed after it would have been.
+	 */
+	static shared_state &shared() {
+		static shared_state *const state = new shared_state();
+		return *state;
+	}
+
+	/// \internal \brief Returns the cache of the calling thread.
+	static local_cache &local() {
+		static thread_local local_cache cache;
+		return cache;
+	}
+
+	/** \internal \brief Takes a block from the shared state.
+	 *
+	 * \pre
+	 *     - The shared mutex is locked by the caller.
+	 */
+	static free_block *pop_shared() {
+		shared_state &state = shared();
+		if (state.free) {
+			free_block *block = state.free;
+			state.free = block->next;
+			return block;
+		}
+
+		if (state.unused == state.unused_end) {
+			const std::size_t bytes = state.next_chunk_blocks * block_size;
+			state.unused = static_cast<char *>(::operator new(bytes));
+			state.unused_end = state.unused + bytes;
+			if (state.next_chunk_blocks < max_chunk_blocks) {
+				state.next_chunk_blocks *= 2;
+			}
+		}
+		free_block *block = reinterpret_cast<free_block *>(state.unused);
+		state.unused += block_size;
+		return block;
+	}
+
+	/// \internal \brief Moves a batch of blocks from the shared state.
+	static void refill(local_cache &cache) {
+		std::lock_guard<std::mutex> lock(shared().mutex);
+		for(std::size_t n = 0; n < batch_size; ++n) {
+			free_block *block;
+			try {
+				block = pop_shared();
+			}
+			catch(...) {
+				if (cache.free) {
+					return; // make do with what we got
+				}
+				throw;
+			}
+			block->next = cache.free;
+			cache.free = block;
+			++cache.count;
+		}
+	}
+
+	/// \internal \brief Moves blocks to the shared state.
+	static void drain(local_cache &cache, std::size_t count) noexcept {
+		if (!count) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(shared().mutex);
+		for(; count; --count) {
+			free_block *block = cache.free;
+			cache.free = block->next;
+			--cache.count;
+			block->next = shared().free;
+			shared().free = block;
+		}
+	}
+
+	/// \internal \brief Whether the cache of this thread has been destroyed.
+	static thread_local bool cache_destroyed;
+};
+
+template<std::size_t BlockSize, std::size_t BlockAlign>
+thread_local bool fixed_size_pool<BlockSize, BlockAlign>::cache_destroyed = false;
+
+template<std::size_t BlockSize, std::size_t BlockAlign>
+constexpr std::size_t fixed_size_pool<BlockSize, BlockAlign>::block_align;
+
+template<std::size_t BlockSize, std::size_t BlockAlign>
+constexpr std::size_t fixed_size_pool<BlockSize, BlockAlign>::block_size;
+
+template<std::size_t BlockSize, std::size_t BlockAlign>
+constexpr std::size_t fixed_size_pool<BlockSize, BlockAlign>::batch_size;
+
+/** \brief An allocator which pools single objects by size.
+ *
+ * Single objects of up to 256 bytes are allocated from pools of blocks of
+ * their size, without the per-allocation header of \c operator \c new, and
+ * close to other objects of the same size. All other allocations are
+ * forwarded to \c operator \c new.
+ *
+ * Used as the allocator of a \c hash_map, this packs its nodes densely into
+ * large chunks, which saves memory and improves locality when iterating.
+ * All instances of \c pool_allocator share the same pools, so they compare
+ * equal and do not take up space in the nodes.
+ *
+ * \note Memory of pooled objects is kept for reuse by later objects of the
+ *     same size and is never returned to the system.
+ *
+ * \tparam T The type of the objects to allocate.
+ */
+template<typename T>
+struct pool_allocator {
+	/// \brief The type of the objects to allocate.
+	typedef T value_type;
+
+	/// \brief All instances are interchangeable.
+	typedef std::true_type is_always_equal;
+
+	/// \brief Creates an allocator.
+	pool_allocator() noexcept = default;
+
+	/// \brief Creates an allocator for a different type.
+	template<typename U>
+	pool_allocator(const pool_allocator<U> &) noexcept {}
+
+	/** \brief Allocates memory for objects.
+	 *
+	 * \param n The number of objects.
+	 *
+	 * \return A pointer to uninitialized memory for \c n objects.
+	 *
+	 * \throw <tt>std::bad_alloc</tt> if the memory can not be allocated.
+	 */
+	T *allocate(std::size_t n) {
+		if (n == 1 && pooled<T>()) {
+			return static_cast<T *>(pool<T>::allocate());
+		}
+		if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(::operator new(n * sizeof(T)));
+	}
+
+	/** \brief Releases memory allocated by \ref allocate().
+	 *
+	 * \param p The pointer returned by \ref allocate().
+	 * \param n The number of objects passed to \ref allocate().
+	 */
+	void deallocate(T *p, std::size_t n) noexcept {
+		if (n == 1 && pooled<T>()) {
+			pool<T>::deallocate(p);
+		}
+		else {
+			::operator delete(p);
+		}
+	}
+
+private:
+	// T may still be incomplete when the allocator is instantiated, so its
+	// size is only looked at inside of member functions.
+
+	/// \internal \brief Whether single objects of type \c U are pooled.
+	template<typename U>
+	static constexpr bool pooled() noexcept {
+		return sizeof(U) <= 256 && alignof(U) <= alignof(std::max_align_t);
+	}
+
+	/** \internal \brief The pool for single objects of type \c U.
+	 *
+	 * Over-aligned types are not pooled, but their pool type must still be
+	 * valid.
+	 */
+	template<typename U>
+	using pool = fixed_size_pool<sizeof(U), pooled<U>() ? alignof(U) : 1>;
+};
+
+/** \brief Compares two pool allocators.
+ *
+ * \return \c true, as all pool allocators share the same pools.
+ */
+template<typename T, typename U>
+bool operator==(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+	return true;
+}
+
+/** \brief Compares two pool allocators.
+ *
+ * \return \c false, as all pool allocators share the same pools.
+ */
+template<typename T, typename U>
+bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+	return false;
+}
+
+#endif // POOL_ALLOCATOR_HPP_INCLUDED
@@ -0,0 +1,493 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef STATIC_HASH_MAP_HPP_INCLUDED
+#define STATIC_HASH_MAP_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "hash_map.hpp"
+
+/** \internal \brief Hands out memory from a buffer owned by someone else.
+ *
+ * Memory is carved out of the buffer from front to back. Released blocks are
+ * kept in free lists by their size and handed out again for requests of the
+ * same size, which is what a \c hash_map mostly makes: bucket lists of one
+ * size and nodes of another.
+ *
+ * The arena is lock-free: Carving advances an atomic offset, and each free
+ * list is a stack whose head is a single atomic word. The head refers to its
+ * block by the index of the block in the buffer and carries a counter, which
+ * changes with every push and pop, so a pop can not succeed on a head which
+ * has been popped and pushed again in the meantime.
+ *
+ * Requests the arena can not serve are refused rather than failing, so the
+ * caller can fall back to another source of memory.
+ */
+class static_arena {
+public:
+	/** \internal \brief Creates an arena on a buffer.
+	 *
+	 * \param storage The buffer. Must be aligned to
+	 *     \c alignof(std::max_align_t) and outlive the arena.
+	 * \param size The size of the buffer in bytes.
+	 */
+	static_arena(void *storage, std::size_t size) noexcept
+	: storage(static_cast<unsigned char *>(storage))
+	, size(size)
+	, used(0)
+	, classes() {
+		assert( size / granularity < std::numeric_limits<std::uint32_t>::max()
+			&& "can not index the blocks of a buffer this large" );
+	}
+
+	static_arena(const static_arena &) = delete;
+	static_arena &operator=(const static_arena &) = delete;
+
+	/** \internal \brief Allocates a block.
+	 *
+	 * \param bytes The size of the block.
+	 * \param alignment The alignment of the block.
+	 *
+	 * \return A pointer to the block, or \c nullptr if the arena has no
+	 *     room for it or can not align it.
+	 */
+	void *allocate(std::size_t bytes, std::size_t alignment) noexcept {
+		if (alignment > granularity) {
+			return nullptr;
+		}
+		bytes = rounded(bytes);
+
+		if (size_class *sc = find_class(bytes)) {
+			if (void *block = pop(*sc)) {
+				return block;
+			}
+		}
+
+		std::size_t offset = used.load(std::memory_order_relaxed);
+		do {
+			if (size - offset < bytes) {
+				return nullptr;
+			}
+		} while(!used.compare_exchange_weak(
+			offset, offset + bytes, std::memory_order_relaxed
+		));
+		return storage + offset;
+	}
+
+	/** \internal \brief Releases a block.
+	 *
+	 * \param p The block to release.
+	 * \param bytes The size of the block passed to \ref allocate().
+	 *
+	 * \return
+	 *     - \c true if \c p was allocated from this arena,
+	 *     - \c false otherwise.
+	 */
+	bool deallocate(void *p, std::size_t bytes) noexcept {
+		if (!owns(p)) {
+			return false;
+		}
+		bytes = rounded(bytes);
+
+		if (size_class *sc = find_class(bytes)) {
+			push(*sc, p);
+		}
+		// otherwise, there is no free list for blocks of this size left and
+		// the block is lost until the arena is destroyed.
+		return true;
+	}
+
+private:
+	/// \internal \brief The alignment and size granularity of all blocks.
+	static constexpr std::size_t granularity = alignof(std::max_align_t);
+
+	/// \internal \brief The maximum number of distinct block sizes recycled.
+	static constexpr std::size_t max_classes = 8;
+
+	/** \internal \brief The head of a free list.
+	 *
+	 * The lower half holds one more than the index of the first block in
+	 * units of \ref granularity, or zero for an empty list. The upper half
+	 * counts the changes of the head.
+	 */
+	typedef std::uint64_t head_type;
+
+	/// \internal \brief A block which is not in use.
+	struct free_block {
+		/** \internal \brief The index of the next free block of the same
+		 *     size, in the encoding of \ref head_type.
+		 *
+		 * Atomic, as a pop may read it while the block is being handed out
+		 * by a concurrent pop. The head has changed then, so the value read
+		 * is discarded.
+		 */
+		std::atomic<std::uint32_t> next;
+	};
+
+	/// \internal \brief The free blocks of one size.
+	struct size_class {
+		/// \internal \brief The size of the blocks, or zero if unused.
+		std::atomic<std::size_t> bytes;
+
+		/// \internal \brief The free blocks.
+		std::atomic<head_type> free;
+	};
+
+	/// \internal \brief Rounds a size up to the granularity of blocks.
+	static std::size_t rounded(std::size_t bytes) noexcept {
+		return (bytes + granularity - 1) / granularity * granularity;
+	}
+
+	/// \internal \brief Checks whether a block belongs to the buffer.
+	bool owns(const void *p) const noexcept {
+		const unsigned char *block = static_cast<const unsigned char *>(p);
+		return std::less_equal<const unsigned char *>()(storage, block) &&
+			std::less<const unsigned char *>()(block, storage + size);
+	}
+
+	/// \internal \brief Returns the block of a free list index.
+	free_block *block_at(std::uint32_t index) const noexcept {
+		return reinterpret_cast<free_block *>(
+			storage + std::size_t(index - 1) * granularity
+		);
+	}
+
+	/// \internal \brief Returns the free list index of a block.
+	std::uint32_t index_of(const void *p) const noexcept {
+		const std::size_t offset = static_cast<std::size_t>(
+			static_cast<const unsigned char *>(p) - storage
+		);
+		return static_cast<std::uint32_t>(offset / granularity + 1);
+	}
+
+	/// \internal \brief Creates a head from a block index and a counter.
+	static head_type make_head(std::uint32_t index, head_type tag) noexcept {
+		return (tag << 32) | index;
+	}
+
+	/// \internal \brief Takes a block from a free list.
+	///
+	/// \return The block, or \c nullptr if the list is empty.
+	void *pop(size_class &sc) noexcept {
+		head_type head = sc.free.load(std::memory_order_acquire);
+		while(const std::uint32_t index = static_cast<std::uint32_t>(head)) {
+			const std::uint32_t next
+				= block_at(index)->next.load(std::memory_order_relaxed);
+			if (sc.free.compare_exchange_weak(
+				head, make_head(next, (head >> 32) + 1),
+				std::memory_order_acquire
+			)) {
+				return block_at(index);
+			}
+		}
+		return nullptr;
+	}
+
+	/// \internal \brief Puts a block on a free list.
+	void push(size_class &sc, void *p) noexcept {
+		free_block *const block = ::new(p) free_block;
+		const std::uint32_t index = index_of(p);
+
+		head_type head = sc.free.load(std::memory_order_relaxed);
+		do {
+			block->next.store(
+				static_cast<std::uint32_t>(head), std::memory_order_relaxed
+			);
+		} while(!sc.free.compare_exchange_weak(
+			head, make_head(index, (head >> 32) + 1),
+			std::memory_order_release, std::memory_order_relaxed
+		));
+	}
+
+	/** \internal \brief Finds or adds the free list for a block size.
+	 *
+	 * Lists are claimed for a size in order and never released, so the
+	 * first list which is either unused or claimed for the size is the one.
+	 *
+	 * \return The free list, or \c nullptr if there are free lists for too
+	 *     many other sizes already.
+	 */
+	size_class *find_class(std::size_t bytes) noexcept {
+		for(size_class &sc: classes) {
+			std::size_t claimed = sc.bytes.load(std::memory_order_relaxed);
+			if (claimed == 0 && sc.bytes.compare_exchange_strong(
+				claimed, bytes, std::memory_order_relaxed
+			)) {
+				return &sc;
+			}
+			// claimed now holds the size of the list, if it was claimed
+			// concurrently
+			if (claimed == bytes) {
+				return &sc;
+			}
+		}
+		return nullptr;
+	}
+
+	/// \internal \brief The buffer.
+	unsigned char *const storage;
+
+	/// \internal \brief The size of the buffer.
+	const std::size_t size;
+
+	/// \internal \brief The number of bytes handed out at least once.
+	std::atomic<std::size_t> used;
+
+	/// \internal \brief The free lists.
+	size_class classes[max_classes];
+};
+
+/** \internal \brief Allocates from a \ref static_arena.
+ *
+ * Requests the arena can not serve are forwarded to \c operator \c new.
+ *
+ * \tparam T The type to allocate.
+ */
+template<typename T>
+struct static_arena_allocator {
+	/// \internal \brief The type to allocate.
+	typedef T value_type;
+
+	/** \internal \brief Creates an allocator.
+	 *
+	 * \param arena The arena to allocate from.
+	 */
+	explicit static_arena_allocator(static_arena *arena) noexcept
+	: arena(arena) {}
+
+	/// \internal \brief Copies an allocator for another type.
+	template<typename U>
+	static_arena_allocator(const static_arena_allocator<U> &other) noexcept
+	: arena(other.arena) {}
+
+	/// \internal \brief Allocates storage for \c n objects.
+	T *allocate(std::size_t n) {
+		if (void *p = arena->allocate(n * sizeof(T), alignof(T))) {
+			return static_cast<T *>(p);
+		}
+		return std::allocator<T>().allocate(n);
+	}
+
+	/// \internal \brief Deallocates storage for \c n objects.
+	void deallocate(T *p, std::size_t n) noexcept {
+		if (!arena->deallocate(p, n * sizeof(T))) {
+			std::allocator<T>().deallocate(p, n);
+		}
+	}
+
+	/// \internal \brief Compares two allocators.
+	template<typename U>
+	bool operator==(const static_arena_allocator<U> &other) const noexcept {
+		return arena == other.arena;
+	}
+
+	/// \internal \brief Compares two allocators.
+	template<typename U>
+	bool operator!=(const static_arena_allocator<U> &other) const noexcept {
+		return arena != other.arena;
+	}
+
+	/// \internal \brief The arena to allocate from.
+	static_arena *arena;
+};
+
+/** \internal \brief Embedded storage for a \ref static_hash_map.
+ *
+ * This is a base class of \ref static_hash_map, so it is constructed before
+ * and destroyed after the \c hash_map allocating from it.
+ *
+ * \tparam Bytes The size of the storage.
+ */
+template<std::size_t Bytes>
+struct static_hash_map_storage {
+	/// \internal \brief Creates the arena on the storage.
+	static_hash_map_storage() noexcept
+	: arena(storage, Bytes) {}
+
+	/// \internal \brief The memory of the map.
+	alignas(std::max_align_t) unsigned char storage[Bytes];
+
+	/// \internal \brief Hands out \ref storage.
+	static_arena arena;
+};
+
+/** \internal \brief The configuration of a \ref static_hash_map.
+ *
+ * \tparam Traits The configuration to extend.
+ * \tparam BucketCount The number of buckets.
+ */
+template<typename Traits, std::size_t BucketCount>
+struct static_hash_map_traits: Traits {
+	/// \internal \brief The number of buckets is fixed.
+	typedef static_bucket_index<BucketCount> bucket_index_policy;
+
+	/// \internal \brief Buckets are stored in the arena, not in memory
+	///     from \c std::calloc.
+	static constexpr bool lazy_buckets = false;
+
+	/// \internal \brief The arena is sized for one bucket list at a time,
+	///     so clear() releases the replaced one to make room for the next.
+	static constexpr bool incremental_clear = false;
+
+	/// \internal \brief Bucket lists must not outlive the arena.
+	typedef immediate_reclamation reclamation_policy;
+};
+
+/// \internal \brief The \c hash_map a \ref static_hash_map is built on.
+template<
+	typename Key,
+	typename T,
+	std::size_t BucketCount,
+	typename Hash,
+	typename KeyEqual,
+	typename Traits
+>
+using static_hash_map_base = hash_map<
+	Key, T, Hash, KeyEqual,
+	static_arena_allocator< std::pair<const Key, T> >,
+	static_hash_map_traits<Traits, BucketCount>
+>;
+
+/** \brief A hash_map with a number of buckets and elements fixed at compile
+ *     time, which does not allocate memory.
+ * \nosubgrouping
+ *
+ * The bucket list and up to \c Capacity elements are stored inside the map
+ * object itself, so creating, filling and destroying a map does not allocate
+ * any memory. As the number of buckets is a constant, mapping hashes to
+ * buckets takes a multiplication instead of a division.
+ *
+ * Apart from its construction, a \c static_hash_map is a \ref hash_map and
+ * offers the same interface and guarantees, with these exceptions:
+ *     - \ref hash_map::rehash() does nothing.
+ *     - Maps can not be swapped, as their elements are stored inside of them.
+ *         For the same reason, assigning a map copies all elements one by one
+ *         and is not thread safe.
+ *
+ * Elements beyond \c Capacity, and erased elements still referred to by
+ * concurrent operations, are allocated by \c operator \c new, so exceeding
+ * the capacity degrades performance rather than failing.
+ *
+ * \tparam Key The type for element keys.
+ * \tparam T The type for element values.
+ * \tparam BucketCount The number of buckets.
+ * \tparam Capacity The number of elements stored inside the map.
+ * \tparam Hash The type of the hash function.
+ * \tparam KeyEqual The type of the key equality comparator.
+ * \tparam Traits The compile time configuration. The bucket index policy is
+ *     replaced by \ref static_bucket_index.
+ */
+template<
+	typename Key,
+	typename T,
+	std::size_t BucketCount,
+	std::size_t Capacity,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename Traits = hash_map_traits
+>
+struct static_hash_map
+: private static_hash_map_storage<
+	static_hash_map_base<Key, T, BucketCount, Hash, KeyEqual, Traits>
+		::storage_estimate(BucketCount, Capacity)
+>
+, public static_hash_map_base<Key, T, BucketCount, Hash, KeyEqual, Traits> {
+private:
+	/// \internal \brief The embedded storage.
+	typedef static_hash_map_storage<
+		static_hash_map_base<Key, T, BucketCount, Hash, KeyEqual, Traits>
+			::storage_estimate(BucketCount, Capacity)
+	> storage_type;
+
+	/// \internal \brief The map allocating from the storage.
+	typedef static_hash_map_base<
+		Key, T, BucketCount, Hash, KeyEqual, Traits
+	> base_type;
+
+public:
+	/// \brief The type of the hash function.
+	typedef typename base_type::hasher hasher;
+
+	/// \brief The type of the key equality comparator.
+	typedef typename base_type::key_equal key_equal;
+
+	/// \brief The type of the allocator.
+	typedef typename base_type::allocator_type allocator_type;
+
+	/// \brief The number of elements stored inside the map.
+	static constexpr std::size_t capacity = Capacity;
+
+	/** \brief Creates an empty static_hash_map.
+	 *
+	 * \param hash The hash function to use.
+	 * \param keycomp The key comparison function to use.
+	 */
+	explicit static_hash_map(
+		const hasher &hash = hasher{},
+		const key_equal &keycomp = key_equal{}
+	)
+	: storage_type()
+	, base_type(BucketCount, hash, keycomp, allocator_type(&this->arena)) {}
+
+	/** \brief Creates a copy of a static_hash_map.
+	 *
+	 * \post
+	 *     - <tt>*this == other</tt>
+	 */
+	static_hash_map(const static_hash_map &other)
+	: storage_type()
+	, base_type(
+		BucketCount, other.hash_function(), other.key_eq(),
+		allocator_type(&this->arena)
+	) {
+		for(const auto &value: other) {
+			this->insert(value);
+		}
+	}
+
+	/** \brief Assigns all elements from another static_hash_map to this one.
+	 *
+	 * \return A reference to this static_hash_map.
+	 *
+	 * \post
+	 *     - <tt>*this == other</tt>
+	 *
+	 * \note Unlike \ref hash_map::operator=(), this function is not thread
+	 *     safe, as it clears the map and inserts the elements one by one.
+	 */
+	static_hash_map &operator=(const static_hash_map &other) {
+		if (this != &other) {
+			this->clear();
+			for(const auto &value: other) {
+				this->insert(value);
+			}
+		}
+		return *this;
+	}
+
+	/// \brief Elements stored inside of maps can not be swapped.
+	void swap(static_hash_map &other) = delete;
+};
+
+template<
+	typename Key, typename T, std::size_t BucketCount, std::size_t Capacity,
+	typename Hash, typename KeyEqual, typename Traits
+>
+constexpr std::size_t static_hash_map<
+	Key, T, BucketCount, Capacity, Hash, KeyEqual, Traits
+>::capacity;
+
+#endif // STATIC_HASH_MAP_HPP_INCLUDED
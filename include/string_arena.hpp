@@ -0,0 +1,680 @@
+// This implementation was done in response to an assignment for a job interview.
+// Production use is discouraged!
+
+#pragma once
+
+#ifndef STRING_ARENA_HPP_INCLUDED
+#define STRING_ARENA_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "hash_map.hpp"
+#include "hashers.hpp"
+
+/** \brief A reference to a range of characters, used to look up keys.
+ *
+ * A \c string_ref does not own its characters and is never stored by a map,
+ * so it can refer to temporary strings. It plays the role of
+ * \c std::string_view, which is not available in C++14.
+ */
+class string_ref {
+public:
+	/** \brief Creates a reference to a range of characters.
+	 *
+	 * \param chars The first character.
+	 * \param length The number of characters.
+	 */
+	string_ref(const char *chars, std::size_t length) noexcept
+	: chars(chars)
+	, length(length) {}
+
+	/** \brief Creates a reference to a null terminated string.
+	 *
+	 * \param str The string to refer to, without the terminator.
+	 */
+	string_ref(const char *str) noexcept
+	: string_ref(str, std::strlen(str)) {}
+
+	/** \brief Creates a reference to a \c std::string.
+	 *
+	 * \param str The string to refer to.
+	 */
+	string_ref(const std::string &str) noexcept
+	: string_ref(str.data(), str.size()) {}
+
+	/** \brief Returns the number of characters.
+	 *
+	 * \return The number of characters.
+	 */
+	std::size_t size() const noexcept {
+		return length;
+	}
+
+	/** \brief Returns the characters.
+	 *
+	 * \return A pointer to the characters, which are not null terminated.
+	 */
+	const char *data() const noexcept {
+		return chars;
+	}
+
+private:
+	/// \internal \brief The first character.
+	const char *chars;
+
+	/// \internal \brief The number of characters.
+	std::size_t length;
+};
+
+class string_arena;
+
+template<typename T, typename Hash, typename Allocator, typename Traits>
+class arena_hash_map;
+
+/** \brief A reference to a string stored in a \ref string_arena.
+ *
+ * An \c arena_string does not own its characters. Apart from the empty
+ * string, it can only be created by storing a string in a \ref string_arena,
+ * so it can be used as the key of a \c hash_map without referring to
+ * characters which are gone. Use \ref arena_hash_map to have the characters
+ * of keys stored in an arena owned by the map, and \ref string_ref to look
+ * them up.
+ *
+ * Two \c arena_string objects are equal if their characters are equal, no
+ * matter where they are stored.
+ */
+class arena_string {
+public:
+	/// \brief The type for sizes.
+	typedef std::uint32_t size_type;
+
+	/// \brief Creates an empty string.
+	arena_string() noexcept
+	: chars("")
+	, length(0) {}
+
+	/** \brief Returns the number of characters.
+	 *
+	 * \return The number of characters.
+	 */
+	std::size_t size() const noexcept {
+		return length;
+	}
+
+	/** \brief Checks whether the string is empty.
+	 *
+	 * \return \c true if the string has no characters.
+	 */
+	bool empty() const noexcept {
+		return length == 0;
+	}
+
+	/** \brief Returns the characters.
+	 *
+	 * \return A pointer to the characters, which are not null terminated.
+	 */
+	const char *data() const noexcept {
+		return chars;
+	}
+
+	/** \brief Copies the string into a \c std::string.
+	 *
+	 * \return A \c std::string with the same characters.
+	 */
+	std::string str() const {
+		return std::string(chars, length);
+	}
+
+	/// \brief Returns a reference to the characters.
+	operator string_ref() const noexcept {
+		return string_ref(chars, length);
+	}
+
+	/** \brief Compares two strings.
+	 *
+	 * The lengths are compared before the characters.
+	 *
+	 * \return \c true if both strings have the same characters.
+	 */
+	friend bool operator==(const arena_string &a, const arena_string &b) noexcept {
+		return a.length == b.length &&
+			(a.chars == b.chars || std::memcmp(a.chars, b.chars, a.length) == 0);
+	}
+
+	/** \brief Compares two strings.
+	 *
+	 * \return \c true if the strings have different characters.
+	 */
+	friend bool operator!=(const arena_string &a, const arena_string &b) noexcept {
+		return !(a == b);
+	}
+
+private:
+	friend class string_arena;
+
+	template<typename T, typename Hash, typename Allocator, typename Traits>
+	friend class arena_hash_map;
+
+	/** \internal \brief Creates a reference to a range of characters.
+	 *
+	 * Only used for characters in an arena, and by \ref arena_hash_map for
+	 * lookup keys which are never stored.
+	 *
+	 * \throw <tt>std::length_error</tt> if \c str is longer than
+	 *     \ref size_type can represent.
+	 */
+	explicit arena_string(string_ref str)
+	: chars(str.data())
+	, length(checked_length(str.size())) {}
+
+	/** \internal \brief Checks whether a length can be represented.
+	 *
+	 * \throw <tt>std::length_error</tt> if \c length does not fit into
+	 *     \ref size_type.
+	 */
+	static size_type checked_length(std::size_t length) {
+		if (length > std::numeric_limits<size_type>::max()) {
+			throw std::length_error("string too long for arena_string");
+		}
+		return static_cast<size_type>(length);
+	}
+
+	/// \internal \brief The first character.
+	const char *chars;
+
+	/// \internal \brief The number of characters.
+	size_type length;
+};
+
+/** \brief Append-only storage for the characters of many strings.
+ *
+ * Strings are copied into large chunks, one after another, so storing a
+ * string does not need an allocation of its own, and strings stored together
+ * are close to each other in memory. Strings can not be removed; all of them
+ * are released along with the arena.
+ *
+ * Storing strings is thread safe and lock free, apart from the allocation of
+ * new chunks.
+ *
+ * \note The arena must outlive every \ref arena_string referring to it, and
+ *     thus every \c hash_map using such strings as keys. \ref arena_hash_map
+ *     takes care of this by owning its arena.
+ */
+class string_arena {
+public:
+	/** \brief Creates an empty arena.
+	 *
+	 * \param chunk_size The number of bytes allocated at once. Strings
+	 *     longer than a quarter of a chunk get a chunk of their own.
+	 *
+	 * \pre
+	 *     - <tt>0 < chunk_size</tt>
+	 */
+	explicit string_arena(std::size_t chunk_size = 64 * 1024)
+	: chunk_size(chunk_size)
+	, current(nullptr)
+	, oversized(nullptr) {
+		assert( 0 < chunk_size
+			&& "chunks must be able to store characters" );
+	}
+
+	string_arena(const string_arena &) = delete;
+	string_arena &operator=(const string_arena &) = delete;
+
+	/// \brief Releases all strings stored in the arena.
+	~string_arena() {
+		release(current.load(std::memory_order_relaxed));
+		release(oversized.load(std::memory_order_relaxed));
+	}
+
+	/** \brief Copies a string into the arena.
+	 *
+	 * \param str The string to copy.
+	 *
+	 * \throw <tt>std::length_error</tt> if \c str is longer than
+	 *     \ref arena_string::size_type can represent.
+	 *
+	 * \return A reference to the copy in the arena.
+	 *
+	 * \note This function is thread safe.
+	 */
+	arena_string store(string_ref str) {
+		// validate the length before storing anything
+		const arena_string view(str);
+		const std::size_t length = str.size();
+
+		char *target;
+		if (length > chunk_size / 4) {
+			chunk *new_chunk = chunk::create(length, length);
+			new_chunk->previous = oversized.load(std::memory_order_relaxed);
+			while(!oversized.compare_exchange_weak(
+				new_chunk->previous, new_chunk, std::memory_order_release
+			));
+			target = new_chunk->bytes();
+		}
+		else {
+			target = reserve(length);
+		}
+
+		std::memcpy(target, view.data(), length);
+		return arena_string(string_ref(target, length));
+	}
+
+	/** \brief Gives back the space of the string stored last.
+	 *
+	 * If no other string has been stored in the same chunk since \c str,
+	 * its space is reused by the next string; a chunk of its own is
+	 * released. Otherwise, the space stays taken until the arena is
+	 * destroyed.
+	 *
+	 * \param str A string returned by \ref store() which is not used
+	 *     anymore.
+	 *
+	 * \return \c true if the space has been given back.
+	 *
+	 * \note This function is thread safe.
+	 */
+	bool unstore(const arena_string &str) noexcept {
+		if (str.empty()) {
+			return false;
+		}
+
+		if (str.size() > chunk_size / 4) {
+			chunk *c = oversized.load(std::memory_order_acquire);
+			// chunks are only released along with the arena, so if the
+			// newest one holds str, it is the one str has been stored in
+			if (c && c->bytes() == str.data() && oversized.compare_exchange_strong(
+				c, c->previous, std::memory_order_relaxed
+			)) {
+				chunk::destroy(c);
+				return true;
+			}
+			return false;
+		}
+
+		chunk *c = current.load(std::memory_order_acquire);
+		if (!c) {
+			return false;
+		}
+		const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(c->bytes());
+		const std::uintptr_t at = reinterpret_cast<std::uintptr_t>(str.data());
+		if (at < first || at - first > c->size) {
+			return false; // stored in another chunk
+		}
+		const std::size_t offset = std::size_t(at - first);
+		std::size_t expected = offset + str.size();
+		// fails if anything has been claimed behind str in the meantime
+		return c->used.compare_exchange_strong(
+			expected, offset, std::memory_order_relaxed
+		);
+	}
+
+private:
+	/// \internal \brief A block of memory strings are stored in.
+	struct chunk {
+		/** \internal \brief Allocates a chunk.
+		 *
+		 * \param size The number of bytes to store in the chunk.
+		 * \param used The number of bytes already claimed by the caller.
+		 */
+		static chunk *create(std::size_t size, std::size_t used) {
+			void *memory = ::operator new(sizeof(chunk) + size);
+			return new(memory) chunk(size, used);
+		}
+
+		/// \internal \brief Releases a chunk created by \ref create().
+		static void destroy(chunk *c) noexcept {
+			c->~chunk();
+			::operator delete(c);
+		}
+
+		/// \internal \brief Returns the first byte of the chunk.
+		char *bytes() noexcept {
+			return reinterpret_cast<char *>(this + 1);
+		}
+
+		/// \internal \brief The chunk allocated before this one.
+		chunk *previous;
+
+		/// \internal \brief The number of bytes in the chunk.
+		const std::size_t size;
+
+		/** \internal \brief The number of bytes claimed.
+		 *
+		 * Claims are made without checking for space first, so this can
+		 * exceed \ref size, in which case the chunk is full.
+		 */
+		std::atomic<std::size_t> used;
+
+	private:
+		/// \internal \brief Constructs the header of a chunk.
+		chunk(std::size_t size, std::size_t used) noexcept
+		: previous(nullptr)
+		, size(size)
+		, used(used) {}
+	};
+
+	/** \internal \brief Claims memory in the current chunk.
+	 *
+	 * Allocates a new chunk if the current one is full.
+	 *
+	 * \param length The number of bytes to claim.
+	 *
+	 * \return The first byte claimed.
+	 */
+	char *reserve(std::size_t length) {
+		chunk *c = current.load(std::memory_order_acquire);
+		while(true) {
+			if (c) {
+				const std::size_t offset
+					= c->used.fetch_add(length, std::memory_order_relaxed);
+				if (offset + length <= c->size) {
+					return c->bytes() + offset;
+				}
+			}
+
+			// the chunk is full; the first byte of the next one is ours
+			chunk *new_chunk = chunk::create(chunk_size, length);
+			new_chunk->previous = c;
+			if (current.compare_exchange_strong(
+				c, new_chunk, std::memory_order_acq_rel
+			)) {
+				return new_chunk->bytes();
+			}
+
+			// someone else replaced the chunk first; use theirs
+			chunk::destroy(new_chunk);
+		}
+	}
+
+	/** \internal \brief Releases a list of chunks.
+	 *
+	 * \param c The last chunk of the list.
+	 */
+	static void release(chunk *c) noexcept {
+		while(c) {
+			chunk *previous = c->previous;
+			chunk::destroy(c);
+			c = previous;
+		}
+	}
+
+	/// \internal \brief The number of bytes allocated at once.
+	const std::size_t chunk_size;
+
+	/// \internal \brief The chunk new strings are stored in.
+	std::atomic<chunk *> current;
+
+	/// \internal \brief The chunks of strings too long to share a chunk.
+	std::atomic<chunk *> oversized;
+};
+
+namespace std {
+	/// \brief Hashes an \ref arena_string.
+	template<>
+	struct hash<arena_string> {
+		/** \brief Calculates the hash of a string.
+		 *
+		 * \param str The string to hash.
+		 *
+		 * \return The hash of the characters of \c str.
+		 */
+		std::size_t operator()(const arena_string &str) const noexcept {
+			return bytes_hash(0)(str.data(), str.size());
+		}
+	};
+}
+
+/** \brief A \c hash_map with \ref arena_string keys stored in an arena of
+ *     its own.
+ * \nosubgrouping
+ *
+ * Keys are passed as \ref string_ref, so lookups do not take up any space.
+ * Insertions copy the characters of the key into the arena of the map and
+ * give the copy back if the key is in the map already. The space is reused
+ * unless another thread has stored a key behind the copy in the meantime,
+ * so rejected insertions only take up space under contention.
+ *
+ * Strings can not be removed from an arena, so erasing an element does not
+ * give back the characters of its key; they are released along with the map.
+ *
+ * \tparam T The type for element values.
+ * \tparam Hash The type of the hash function.
+ * \tparam Allocator The type of the allocator.
+ * \tparam Traits The compile time configuration of the \c hash_map.
+ */
+template<
+	typename T,
+	typename Hash = std::hash<arena_string>,
+	typename Allocator = std::allocator< std::pair<const arena_string, T> >,
+	typename Traits = hash_map_traits
+>
+class arena_hash_map {
+public:
+/// \name Member Types
+///\{
+	/// \brief The underlying map type.
+	typedef hash_map<
+		arena_string, T, Hash, std::equal_to<arena_string>, Allocator, Traits
+	> map_type;
+
+	/// \brief The type used for element counts and indices.
+	typedef typename map_type::size_type      size_type;
+
+	/// \brief The storage type stored in the map.
+	typedef typename map_type::value_type     value_type;
+
+	/// \brief The type for element keys.
+	typedef typename map_type::key_type       key_type;
+
+	/// \brief The type for element values.
+	typedef typename map_type::mapped_type    mapped_type;
+
+	/// \brief The iterator type for the arena_hash_map.
+	typedef typename map_type::iterator       iterator;
+
+	/// \brief The const iterator type for the arena_hash_map.
+	typedef typename map_type::const_iterator const_iterator;
+///\}
+
+
+
+/// \name Member Functions
+///\{
+	/** \brief Creates an empty map.
+	 *
+	 * \param bucket_count The number of buckets.
+	 * \param chunk_size The number of bytes the arena allocates at once.
+	 *
+	 * \pre
+	 *     - <tt>0 < bucket_count</tt>
+	 *     - <tt>0 < chunk_size</tt>
+	 */
+	explicit arena_hash_map(
+		size_type bucket_count,
+		std::size_t chunk_size = 64 * 1024
+	)
+	: strings(chunk_size)
+	, elements(bucket_count) {}
+
+	// the keys refer to the arena, so they can not be shared
+	arena_hash_map(const arena_hash_map &) = delete;
+	arena_hash_map &operator=(const arena_hash_map &) = delete;
+
+	/** \brief Returns the underlying map.
+	 *
+	 * \return The map, for all operations which do not add keys.
+	 */
+	const map_type &map() const noexcept {
+		return elements;
+	}
+///\}
+
+
+
+/// \name Iterators
+///\{
+	/// \brief Returns an iterator to the first element.
+	iterator begin() {
+		return elements.begin();
+	}
+
+	/// \brief Returns an iterator to the first element.
+	const_iterator begin() const {
+		return elements.begin();
+	}
+
+	/// \brief Returns an iterator behind the last element.
+	iterator end() {
+		return elements.end();
+	}
+
+	/// \brief Returns an iterator behind the last element.
+	const_iterator end() const {
+		return elements.end();
+	}
+///\}
+
+
+
+/// \name Capacity
+///\{
+	/// \brief Checks whether the map is empty.
+	bool empty() const {
+		return elements.empty();
+	}
+
+	/// \brief Returns the number of elements.
+	size_type size() const {
+		return elements.size();
+	}
+///\}
+
+
+
+/// \name Modifiers
+///\{
+	/** \brief Inserts an element into the map.
+	 *
+	 * \param key The key of the element. Its characters are copied into the
+	 *     arena, and given back if the element is not inserted.
+	 * \param value The value of the element.
+	 *
+	 * \return The same as \c hash_map::insert().
+	 */
+	std::pair<bool, iterator> insert(string_ref key, const mapped_type &value) {
+		const arena_string stored = strings.store(key);
+		try {
+			auto result = elements.insert(value_type(stored, value));
+			if (!result.first) {
+				strings.unstore(stored);
+			}
+			return result;
+		}
+		catch(...) {
+			strings.unstore(stored);
+			throw;
+		}
+	}
+
+	/** \brief Erases an element from the map.
+	 *
+	 * \param key The key of the element to erase.
+	 *
+	 * \return The number of elements erased. (0 or 1)
+	 *
+	 * \note The characters of the key stay in the arena.
+	 */
+	size_type erase(string_ref key) {
+		return elements.erase(arena_string(key));
+	}
+
+	/** \brief Erases all elements.
+	 *
+	 * \note The characters of the keys stay in the arena.
+	 */
+	void clear() {
+		elements.clear();
+	}
+///\}
+
+
+
+/// \name Lookup
+///\{
+	/** \brief Accesses an element by its key, with bounds-checking.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \throw <tt>std::out_of_range</tt> if no element with the key \c key is
+	 *     stored in the map.
+	 *
+	 * \return A reference to the element requested.
+	 */
+	mapped_type &at(string_ref key) {
+		return elements.at(arena_string(key));
+	}
+
+	/// \copydoc at()
+	const mapped_type &at(string_ref key) const {
+		return elements.at(arena_string(key));
+	}
+
+	/** \brief Accesses an element by its key, inserting it if necessary.
+	 *
+	 * \param key The key of the element to access.
+	 *
+	 * \return A reference to the element with the key \c key.
+	 */
+	mapped_type &operator[](string_ref key) {
+		return insert(key, mapped_type{}).second->second;
+	}
+
+	/** \brief Counts the number of elements with a specific key.
+	 *
+	 * \param key The key of the element to count.
+	 *
+	 * \return The number of elements with the key \c key. (0 or 1)
+	 */
+	size_type count(string_ref key) const {
+		return elements.count(arena_string(key));
+	}
+
+	/** \brief Finds an element by its key.
+	 *
+	 * \param key The key of the element to fetch.
+	 *
+	 * \return An iterator to the element with the key \c key, or
+	 *     <tt>end()</tt> is no such element exists.
+	 */
+	iterator find(string_ref key) {
+		return elements.find(arena_string(key));
+	}
+
+	/// \copydoc find()
+	const_iterator find(string_ref key) const {
+		return elements.find(arena_string(key));
+	}
+///\}
+
+private:
+	/// \internal \brief The characters of the keys.
+	string_arena strings;
+
+	/// \internal \brief The elements; destroyed before their keys.
+	map_type elements;
+};
+
+#endif // STRING_ARENA_HPP_INCLUDED
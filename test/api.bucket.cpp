@@ -1,11 +1,64 @@
+#include <algorithm>
+#include <cstddef>
+#include <functional>
 #include <iterator>
+#include <memory>
+#include <utility>
 
 #include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
 #include "test_helper.hpp"
 
 #define CATCH_CONFIG_MAIN
 #include "../3rdparty/catch.hpp"
 
+namespace {
+	template<typename Policy>
+	struct bucket_index_traits: hash_map_traits {
+		typedef Policy bucket_index_policy;
+	};
+
+	template<typename Policy>
+	using policy_map = hash_map<
+		int, int, std::hash<int>, std::equal_to<int>,
+		std::allocator<std::pair<const int, int>>,
+		bucket_index_traits<Policy>
+	>;
+
+	template<typename Policy>
+	void check_bucket_index_policy(std::size_t expected_bucket_count) {
+		policy_map<Policy> hm(10);
+		REQUIRE( hm.bucket_count() == expected_bucket_count );
+
+		// multiples of 16 cluster without proper mixing
+		for(int i=0; i<256; ++i) {
+			hm[16*i] = i;
+		}
+
+		std::size_t used_buckets = 0;
+		for(std::size_t b=0; b<hm.bucket_count(); ++b) {
+			used_buckets += (0 < hm.bucket_size(b) ? 1 : 0);
+		}
+		REQUIRE( 1 < used_buckets );
+
+		for(int i=0; i<256; ++i) {
+			const auto b = hm.bucket(16*i);
+			REQUIRE( b < hm.bucket_count() );
+			REQUIRE( std::find_if(hm.cbegin(b), hm.cend(b), [i](const auto &e) {
+				return e.first == 16*i;
+			}) != hm.cend(b) );
+		}
+
+		hm.rehash(33);
+		REQUIRE( hm.bucket_count() == Policy(33).bucket_count() );
+		REQUIRE( hm.size() == 256 );
+		for(int i=0; i<256; ++i) {
+			REQUIRE( hm.find(16*i) != hm.end() );
+			REQUIRE( hm.find(16*i+1) == hm.end() );
+		}
+	}
+}
+
 TEST_CASE("hash_map/bucket: iterators, bucket_size", "") {
 	// see also hash_map/iterator tests.
 
@@ -75,3 +128,22 @@ TEST_CASE("hash_map/bucket: bucket", "") {
 		REQUIRE( hm.size() == i );
 	}
 }
+
+TEST_CASE("hash_map/bucket: bucket_index_policy", "") {
+	check_bucket_index_policy<modulo_bucket_index>(10);
+	check_bucket_index_policy<mask_bucket_index>(16);
+	check_bucket_index_policy<fastrange_bucket_index>(10);
+	check_bucket_index_policy<reciprocal_bucket_index>(10);
+
+	REQUIRE( mask_bucket_index(1).bucket_count() == 1 );
+	REQUIRE( mask_bucket_index(16).bucket_count() == 16 );
+	REQUIRE( mask_bucket_index(17).bucket_count() == 32 );
+
+	// same results as a division for 32 bit hashes
+	for(const std::size_t count : {1U, 7U, 10U, 97U, 65536U}) {
+		const reciprocal_bucket_index policy(count);
+		for(const std::size_t hash : {0U, 1U, 6U, 96U, 12345U, 4294967295U}) {
+			REQUIRE( policy(hash) == hash % count );
+		}
+	}
+}
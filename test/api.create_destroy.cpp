@@ -1,7 +1,9 @@
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #include "../include/hash_map.hpp"
 #include "test_helper.hpp"
@@ -9,6 +11,105 @@
 #define CATCH_CONFIG_MAIN
 #include "../3rdparty/catch.hpp"
 
+namespace {
+	struct lazy_buckets_traits: hash_map_traits {
+		static constexpr bool lazy_buckets = true;
+	};
+
+	struct lazy_inline_traits: lazy_buckets_traits {
+		static constexpr bool inline_first_node = true;
+	};
+
+	struct parallel_destruction_traits: hash_map_traits {
+		static constexpr unsigned destruction_threads = 4;
+	};
+
+	struct parallel_lazy_traits: lazy_inline_traits {
+		static constexpr unsigned destruction_threads = 3;
+		static constexpr bool incremental_clear = true;
+	};
+
+	template<typename Traits>
+	void check_parallel_destruction() {
+		typedef hash_map<
+			int, tracked_mapped_type,
+			std::hash<int>, std::equal_to<int>,
+			std::allocator<std::pair<const int, tracked_mapped_type>>,
+			Traits
+		> map_type;
+
+		const auto live_before
+			= tracked_mapped_type::created - tracked_mapped_type::destroyed;
+		{
+			map_type hm(1 << 16);
+			for(int i=0; i<(1 << 17); i+=3) {
+				hm[i];
+			}
+
+			// destroys the previous bucket list in parallel, unless
+			// Traits::incremental_clear hands it to the new one
+			hm.clear();
+			for(int i=0; i<1000; ++i) {
+				hm[i];
+			}
+			REQUIRE( hm.size() == 1000 );
+
+			for(int i=0; i<(1 << 17); ++i) {
+				hm[i];
+			}
+			REQUIRE( tracked_mapped_type::created - tracked_mapped_type::destroyed
+				- live_before >= (1 << 17) );
+		}
+		REQUIRE( tracked_mapped_type::created - tracked_mapped_type::destroyed
+			== live_before );
+	}
+
+	template<typename Traits>
+	void check_lazy_buckets() {
+		typedef hash_map<
+			int, tracked_mapped_type,
+			std::hash<int>, std::equal_to<int>,
+			std::allocator<std::pair<const int, tracked_mapped_type>>,
+			Traits
+		> map_type;
+
+		const auto live_before
+			= tracked_mapped_type::created - tracked_mapped_type::destroyed;
+		{
+			map_type hm(1 << 20);
+			REQUIRE( hm.bucket_count() == 1 << 20 );
+			REQUIRE( hm.empty() );
+			REQUIRE( hm.begin() == hm.end() );
+			REQUIRE( hm.bucket_size(12345) == 0 );
+
+			for(const int i : {7, 1 << 19, 5, (1 << 20) - 1, 7 + (1 << 20)}) {
+				hm[i];
+			}
+			REQUIRE( hm.size() == 5 );
+			REQUIRE( std::distance(hm.begin(), hm.end()) == 5 );
+			REQUIRE( hm.bucket_size(7) == 2 );
+			REQUIRE( hm.count(5) == 1 );
+			REQUIRE( hm.count(6) == 0 );
+			REQUIRE( hm.erase(5) == 1 );
+
+			map_type copy(hm);
+			REQUIRE( copy.size() == 4 );
+			REQUIRE( copy.count(1 << 19) == 1 );
+
+			hm.rehash(1 << 21);
+			REQUIRE( hm.bucket_count() == 1 << 21 );
+			REQUIRE( hm.count(7 + (1 << 20)) == 1 );
+			REQUIRE( std::distance(hm.begin(), hm.end()) == 4 );
+
+			hm.clear();
+			REQUIRE( hm.begin() == hm.end() );
+			REQUIRE( copy.size() == 4 );
+		}
+		REQUIRE( tracked_mapped_type::created - tracked_mapped_type::destroyed
+			== live_before );
+	}
+}
+
 TEST_CASE("hash_map/create_destroy: component constructor", "") {
 	SECTION("vanilla - use default values") {
 		hash_map<int, int> hm(42);
@@ -157,3 +258,33 @@ TEST_CASE("hash_map/create_destroy: destructor", "") {
 	}
 	REQUIRE( tracked_mapped_type::created == tracked_mapped_type::destroyed );
 }
+
+TEST_CASE("hash_map/create_destroy: lazy buckets", "") {
+	check_lazy_buckets<lazy_buckets_traits>();
+	check_lazy_buckets<lazy_inline_traits>();
+
+	// threads racing to construct the same buckets
+	hash_map<
+		int, int, std::hash<int>, std::equal_to<int>,
+		std::allocator<std::pair<const int, int>>,
+		lazy_buckets_traits
+	> hm(64);
+	std::vector<std::thread> threads;
+	for(int t=0; t<4; ++t) {
+		threads.emplace_back([&hm, t] {
+			for(int i=0; i<1000; ++i) {
+				hm.insert(std::make_pair(i * 4 + t, i));
+			}
+		});
+	}
+	for(auto &thread: threads) {
+		thread.join();
+	}
+	REQUIRE( hm.size() == 4000 );
+	REQUIRE( std::distance(hm.begin(), hm.end()) == 4000 );
+}
+
+TEST_CASE("hash_map/create_destroy: parallel destruction", "") {
+	check_parallel_destruction<parallel_destruction_traits>();
+	check_parallel_destruction<parallel_lazy_traits>();
+}
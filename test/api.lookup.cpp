@@ -1,98 +1,144 @@
+#include <cstdint>
 #include <iterator>
 #include <stdexcept>
+#include <vector>
 
 #include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "../include/packed_hash_map.hpp"
 #include "test_helper.hpp"
 
 #define CATCH_CONFIG_MAIN
 #include "../3rdparty/catch.hpp"
 
-TEST_CASE("hash_map/lookup: at()", "") {
-	hash_map<int, int> hm(5);
-	for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
-		hm[i] = 2*i;
+namespace {
+	template<typename Map>
+	void check_at() {
+		Map hm(5);
+		for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+			hm[i] = 2*i;
+		}
+		const Map &hm_c = hm;
+
+		REQUIRE( hm.size() == 10 );
+
+		// existing element
+		REQUIRE( hm.at(7) == 14 ); // current value
+		REQUIRE( 42 == (hm.at(7) = 42) ); // change through ref
+		REQUIRE( hm_c.at(7) == 42 ); // reflect change
+
+		// non-existing element
+		REQUIRE_THROWS_AS( hm.at(23), std::out_of_range );
+		REQUIRE_THROWS_AS( hm_c.at(42), std::out_of_range );
+
+		REQUIRE( hm.size() == 10 ); // unchanged
 	}
-	const hash_map<int, int> &hm_c = hm;
 
-	REQUIRE( hm.size() == 10 );
+	template<typename Map>
+	void check_subscript() {
+		Map hm(5);
+		for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+			hm[i] = 2*i;
+		}
+		// op[] is non-const only
+		// const Map &hm_c = hm;
 
-	// existing element
-	REQUIRE( hm.at(7) == 14 ); // current value
-	REQUIRE( 42 == (hm.at(7) = 42) ); // change through ref
-	REQUIRE( hm_c.at(7) == 42 ); // reflect change
+		REQUIRE( hm.size() == 10 );
 
-	// non-existing element
-	REQUIRE_THROWS_AS( hm.at(23), std::out_of_range );
-	REQUIRE_THROWS_AS( hm_c.at(42), std::out_of_range );
+		// existing element
+		REQUIRE( hm[7] == 14 ); // current value
+		REQUIRE( 42 == (hm[7] = 42) ); // change through ref
+		REQUIRE( hm[7] == 42 ); // reflect change
 
-	REQUIRE( hm.size() == 10 ); // unchanged
-}
+		REQUIRE( hm.size() == 10 ); // unchanged
 
-TEST_CASE("hash_map/lookup: operator[]", "") {
-	hash_map<int, int> hm(5);
-	for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
-		hm[i] = 2*i;
+		// non-existing element
+		REQUIRE_NOTHROW( hm[23] );
+		REQUIRE( hm[23] == 0 );
+
+		REQUIRE( hm.size() == 11 ); // changed
 	}
-	// op[] is non-const only
-	// const hash_map<int, int> &hm_c = hm;
 
-	REQUIRE( hm.size() == 10 );
+	template<typename Map>
+	void check_count() {
+		Map hm(5);
+		for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+			hm[i] = 2*i;
+		}
+		const Map &hm_c = hm;
 
-	// existing element
-	REQUIRE( hm[7] == 14 ); // current value
-	REQUIRE( 42 == (hm[7] = 42) ); // change through ref
-	REQUIRE( hm[7] == 42 ); // reflect change
+		REQUIRE( hm.count(2) == 1 );
+		REQUIRE( hm.count(8) == 1 );
 
-	REQUIRE( hm.size() == 10 ); // unchanged
+		hm.erase(8);
+		REQUIRE( hm.count(2) == 1 );
+		REQUIRE( hm.count(8) == 0 );
 
-	// non-existing element
-	REQUIRE_NOTHROW( hm[23] );
-	REQUIRE( hm[23] == 0 );
+		REQUIRE( hm.count(11) == 0 );
+		REQUIRE( hm.count(12) == 0 );
 
-	REQUIRE( hm.size() == 11 ); // changed
-}
-
-TEST_CASE("hash_map/lookup: count()", "") {
-	hash_map<int, int> hm(5);
-	for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
-		hm[i] = 2*i;
+		hm[12] = 0;
+		REQUIRE( hm.count(11) == 0 );
+		REQUIRE( hm.count(12) == 1 );
 	}
-	const hash_map<int, int> &hm_c = hm;
 
-	REQUIRE( hm.count(2) == 1 );
-	REQUIRE( hm.count(8) == 1 );
+	template<typename Map>
+	void check_find() {
+		Map hm(1);
+		for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+			hm[i] = 2*i;
+		}
+		const Map &hm_c = hm;
 
-	hm.erase(8);
-	REQUIRE( hm.count(2) == 1 );
-	REQUIRE( hm.count(8) == 0 );
+		REQUIRE( hm  .find( 1) == hm  .begin() );
+		REQUIRE( hm_c.find( 1) == hm_c.begin() );
+		REQUIRE( hm  .find( 1)->second == 2 );
+		REQUIRE( hm_c.find( 1)->second == 2 );
 
-	REQUIRE( hm.count(11) == 0 );
-	REQUIRE( hm.count(12) == 0 );
+		REQUIRE( hm  .find(10) != hm  .end() );
+		REQUIRE( hm_c.find(10) != hm_c.end() );
+		REQUIRE( hm  .find(10)->second == 20 );
+		REQUIRE( hm_c.find(10)->second == 20 );
 
-	hm[12] = 0;
-	REQUIRE( hm.count(11) == 0 );
-	REQUIRE( hm.count(12) == 1 );
+		REQUIRE( hm  .find(23) == hm  .end() );
+		REQUIRE( hm_c.find(23) == hm_c.end() );
+	}
 }
 
-TEST_CASE("hash_map/lookup: find()", "") {
-	hash_map<int, int> hm(1);
-	for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
-		hm[i] = 2*i;
+TEST_CASE("hash_map/lookup: at()", "") {
+	SECTION("hash_map") {
+		check_at<hash_map<int, int>>();
 	}
-	const hash_map<int, int> &hm_c = hm;
+	SECTION("packed_hash_map") {
+		check_at<packed_hash_map<int, int>>();
+	}
+}
 
-	REQUIRE( hm  .find( 1) == hm  .begin() );
-	REQUIRE( hm_c.find( 1) == hm_c.begin() );
-	REQUIRE( hm  .find( 1)->second == 2 );
-	REQUIRE( hm_c.find( 1)->second == 2 );
+TEST_CASE("hash_map/lookup: operator[]", "") {
+	SECTION("hash_map") {
+		check_subscript<hash_map<int, int>>();
+	}
+	SECTION("packed_hash_map") {
+		check_subscript<packed_hash_map<int, int>>();
+	}
+}
 
-	REQUIRE( hm  .find(10) != hm  .end() );
-	REQUIRE( hm_c.find(10) != hm_c.end() );
-	REQUIRE( hm  .find(10)->second == 20 );
-	REQUIRE( hm_c.find(10)->second == 20 );
+TEST_CASE("hash_map/lookup: count()", "") {
+	SECTION("hash_map") {
+		check_count<hash_map<int, int>>();
+	}
+	SECTION("packed_hash_map") {
+		check_count<packed_hash_map<int, int>>();
+	}
+}
 
-	REQUIRE( hm  .find(23) == hm  .end() );
-	REQUIRE( hm_c.find(23) == hm_c.end() );
+TEST_CASE("hash_map/lookup: find()", "") {
+	SECTION("hash_map") {
+		check_find<hash_map<int, int>>();
+	}
+	SECTION("packed_hash_map") {
+		check_find<packed_hash_map<int, int>>();
+	}
 }
 
 TEST_CASE("hash_map/lookup: equal_range()", "") {
@@ -142,3 +188,148 @@ TEST_CASE("hash_map/lookup: equal_range()", "") {
 		REQUIRE( range.second == hm_c.end(0) );
 	}
 }
+
+namespace {
+	struct small_index_traits: hash_map_traits {
+		static constexpr std::size_t index_threshold = 8;
+		static constexpr std::size_t unindex_threshold = 4;
+	};
+
+	// few distinct hashes, so the index has to cope with equal hashes
+	struct colliding_hash {
+		std::size_t operator()(int key) const {
+			return static_cast<std::size_t>(key % 7);
+		}
+	};
+}
+
+TEST_CASE("hash_map/lookup: indexed buckets", "") {
+	hash_map<
+		int, int,
+		colliding_hash,
+		std::equal_to<int>,
+		std::allocator<std::pair<const int, int>>,
+		small_index_traits
+	> hm(1);
+
+	for(int i=0; i<100; ++i) {
+		hm[i] = 2*i;
+	}
+	REQUIRE( hm.size() == 100 );
+	REQUIRE( hm.bucket_size(0) == 100 );
+	for(int i=0; i<100; ++i) {
+		REQUIRE( hm.count(i) == 1 );
+		REQUIRE( hm.at(i) == 2*i );
+		REQUIRE( hm.equal_range(i).first->first == i );
+	}
+	REQUIRE( hm.count(100) == 0 );
+
+	for(int i=0; i<100; i+=2) {
+		REQUIRE( hm.erase(i) == 1 );
+		REQUIRE( hm.erase(i) == 0 );
+	}
+	REQUIRE( hm.size() == 50 );
+	REQUIRE( hm.bucket_size(0) == 50 );
+	REQUIRE( std::distance(hm.begin(), hm.end()) == 50 );
+	for(int i=0; i<100; ++i) {
+		REQUIRE( hm.count(i) == (i % 2 ? 1U : 0U) );
+	}
+
+	// reinsert some erased keys; they will end up behind the indexed nodes
+	for(int i=0; i<20; i+=2) {
+		REQUIRE( hm.insert(std::make_pair(i, -i)).first );
+		REQUIRE_FALSE( hm.insert(std::make_pair(i, i)).first );
+	}
+	for(int i=0; i<20; i+=2) {
+		REQUIRE( hm.at(i) == -i );
+	}
+
+	// shrink below the threshold to drop the index
+	for(int i=0; i<100; ++i) {
+		if (i != 41 && i != 43) {
+			hm.erase(i);
+		}
+	}
+	REQUIRE( hm.size() == 2 );
+	REQUIRE( hm.bucket_size(0) == 2 );
+	REQUIRE( hm.at(41) == 82 );
+	REQUIRE( hm.at(43) == 86 );
+	REQUIRE( hm.count(42) == 0 );
+}
+
+TEST_CASE("hash_map/lookup: precomputed hash", "") {
+	typedef hash_map<int, int> map_type;
+	map_type hm1(5), hm2(7);
+	const map_type &hm1_c = hm1;
+
+	for(const int i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+		const map_type::hashed_key key = hm1.hash_key(i);
+		REQUIRE( key.key() == i );
+		REQUIRE( key.hash() == hm1.hash_function()(i) );
+		REQUIRE( hm1.insert_hashed(key.hash(), std::make_pair(i, 2*i)).first );
+		REQUIRE_FALSE( hm1.insert_hashed(key.hash(), std::make_pair(i, i)).first );
+		REQUIRE( hm2.insert_hashed(key.hash(), std::make_pair(i, 3*i)).first );
+	}
+	REQUIRE( hm1.size() == 10 );
+	REQUIRE( hm2.size() == 10 );
+
+	// the same hashed key works with every map with an equal hash function
+	const int seven = 7;
+	const map_type::hashed_key key = hm1.hash_key(seven);
+	REQUIRE( hm1.find(key)->second == 14 );
+	REQUIRE( hm1_c.find(key)->second == 14 );
+	REQUIRE( hm2.find(key)->second == 21 );
+	REQUIRE( hm1.find(key) == hm1.find(seven) );
+	REQUIRE( hm1.find(seven, key.hash()) == hm1.find(seven) );
+	REQUIRE( hm1_c.find(seven, key.hash()) == hm1_c.find(seven) );
+
+	REQUIRE( hm1.erase(key) == 1 );
+	REQUIRE( hm1.erase(key) == 0 );
+	REQUIRE( hm1.find(key) == hm1.end() );
+	REQUIRE( hm2.erase(seven, key.hash()) == 1 );
+	REQUIRE( hm2.find(seven, key.hash()) == hm2.end() );
+
+	REQUIRE( hm1.size() == 9 );
+	REQUIRE( hm2.size() == 9 );
+}
+
+TEST_CASE("hash_map/lookup: bulk operations", "") {
+	std::vector<std::uint64_t> keys, values;
+	for(std::uint64_t i=0; i<100; ++i) {
+		keys.push_back(i * 3);
+		values.push_back(i);
+	}
+
+	hash_map<std::uint64_t, std::uint64_t, integer_hash> hm1(13);
+	hash_map<std::uint64_t, std::uint64_t> hm2(13);
+	const auto &hm1_c = hm1;
+
+	REQUIRE( hm1.insert_bulk(keys.data(), values.data(), 50) == 50 );
+	REQUIRE( hm1.insert_bulk(keys.data(), values.data(), keys.size()) == 50 );
+	REQUIRE( hm2.insert_bulk(keys.data(), values.data(), keys.size()) == 100 );
+	REQUIRE( hm1.size() == 100 );
+	REQUIRE( hm2.size() == 100 );
+
+	// look up existing and missing keys
+	std::vector<std::uint64_t> probes;
+	for(std::uint64_t i=0; i<150; ++i) {
+		probes.push_back(i * 2);
+	}
+	std::vector<decltype(hm1)::iterator> results1(probes.size());
+	std::vector<decltype(hm1)::const_iterator> results1_c(probes.size());
+	std::vector<decltype(hm2)::iterator> results2(probes.size());
+	hm1.find_bulk(probes.data(), probes.size(), results1.data());
+	hm1_c.find_bulk(probes.data(), probes.size(), results1_c.data());
+	hm2.find_bulk(probes.data(), probes.size(), results2.data());
+	for(std::size_t i=0; i<probes.size(); ++i) {
+		REQUIRE( results1[i] == hm1.find(probes[i]) );
+		REQUIRE( results1_c[i] == hm1_c.find(probes[i]) );
+		REQUIRE( results2[i] == hm2.find(probes[i]) );
+		if (probes[i] % 3 == 0 && probes[i] < 300) {
+			REQUIRE( results1[i]->second == probes[i] / 3 );
+		}
+		else {
+			REQUIRE( results1[i] == hm1.end() );
+		}
+	}
+}
@@ -1,12 +1,122 @@
+#include <atomic>
 #include <iterator>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "../include/hash_map.hpp"
+#include "../include/packed_hash_map.hpp"
 #include "test_helper.hpp"
 
 #define CATCH_CONFIG_MAIN
 #include "../3rdparty/catch.hpp"
 
+namespace {
+	struct inline_first_node_traits: hash_map_traits {
+		static constexpr bool inline_first_node = true;
+	};
+
+	struct out_of_line_values_traits: inline_first_node_traits {
+		static constexpr bool out_of_line_values = true;
+	};
+
+	struct incremental_clear_traits: hash_map_traits {
+		static constexpr bool incremental_clear = true;
+	};
+
+	struct lazy_incremental_clear_traits: inline_first_node_traits {
+		static constexpr bool incremental_clear = true;
+		static constexpr bool lazy_buckets = true;
+	};
+
+	// Compares keys, but once armed, stops the first comparison of
+	// gated_key until released, so a test can act while an operation is in
+	// progress.
+	struct gated_equal {
+		bool operator()(int lhs, int rhs) const {
+			bool expected = true;
+			if (lhs == gated_key && armed.compare_exchange_strong(expected, false)) {
+				entered = true;
+				while(!released) {
+					std::this_thread::yield();
+				}
+			}
+			return lhs == rhs;
+		}
+
+		static constexpr int gated_key = 3;
+		static std::atomic<bool> armed;
+		static std::atomic<bool> entered;
+		static std::atomic<bool> released;
+	};
+	constexpr int gated_equal::gated_key;
+	std::atomic<bool> gated_equal::armed(false);
+	std::atomic<bool> gated_equal::entered(false);
+	std::atomic<bool> gated_equal::released(false);
+
+	template<typename Traits>
+	void check_incremental_clear() {
+		typedef hash_map<
+			int, tracked_mapped_type,
+			std::hash<int>, std::equal_to<int>,
+			std::allocator<std::pair<const int, tracked_mapped_type>>,
+			Traits
+		> map_type;
+
+		const auto live = [] {
+			return tracked_mapped_type::created - tracked_mapped_type::destroyed;
+		};
+		const auto live_before = live();
+
+		{
+			map_type hm(64);
+			for(int i=0; i<40; ++i) {
+				hm[i];
+			}
+			REQUIRE( live() - live_before == 40 );
+
+			// the elements outlive clear()
+			hm.clear();
+			REQUIRE( hm.empty() );
+			REQUIRE( hm.begin() == hm.end() );
+			REQUIRE( hm.find(3) == hm.end() );
+			REQUIRE( live() - live_before == 40 );
+
+			// and are destroyed by the following insertions
+			for(int i=0; i<4; ++i) {
+				hm[i];
+			}
+			REQUIRE( hm.size() == 4 );
+			REQUIRE( live() - live_before == 4 );
+
+			// retired bucket lists are reclaimed in turn
+			hm.clear();
+			hm.clear();
+			REQUIRE( live() - live_before == 4 );
+			for(int i=0; i<8; ++i) {
+				hm[i];
+			}
+			REQUIRE( hm.size() == 8 );
+			REQUIRE( live() - live_before == 8 );
+
+			// erasures reclaim as well
+			hm.clear();
+			hm[100];
+			REQUIRE( hm.erase(100) == 1 );
+			REQUIRE( hm.empty() );
+			REQUIRE( live() - live_before == 0 );
+
+			// whatever remains is destroyed along with the map
+			for(int i=0; i<40; ++i) {
+				hm[i];
+			}
+			hm.clear();
+		}
+
+		REQUIRE( live() == live_before );
+	}
+}
+
 TEST_CASE("hash_map/modifiers: clear", "") {
 	hash_map<int, tracked_mapped_type> hm(5);
 	for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
@@ -33,145 +143,333 @@ TEST_CASE("hash_map/modifiers: clear", "") {
 	REQUIRE( hm.begin() == hm.end() );
 }
 
-TEST_CASE("hash_map/modifiers: insert", "") {
-	hash_map<int, int> hm(5);
-	for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
-		hm[i] = 2*i;
-	}
-	hash_map<int, int> hm_orig(hm);
-
-	REQUIRE( hm.size() == 10 );
-	const int existing_key = 5;
-	const int existing_value = hm[existing_key];
-	const int overriding_value = existing_value+2;
-	REQUIRE( existing_value != overriding_value ); // need to be distinguishable
-
-	{ // element exists already, noop!
-		REQUIRE( hm.find(existing_key) != hm.end() );
-		REQUIRE( hm[existing_key] == existing_value );
-		auto result = hm.insert( std::make_pair(existing_key, overriding_value) );
-		REQUIRE( hm == hm_orig );
-		REQUIRE_FALSE( result.first );
-		REQUIRE( result.second->first == existing_key );
-		REQUIRE( result.second->second == existing_value );
-		REQUIRE( hm[existing_key] == existing_value );
+namespace {
+	template<typename Iterator>
+	void require_bucket_end(hash_map<int, int> &hm, Iterator it, int key) {
+		REQUIRE( std::next(hash_map<int, int>::local_iterator(it)) == hm.end(hm.bucket(key)) );
 	}
 
-	{ // element exists already, noop! (w/ hint iterator)
-		REQUIRE( hm.find(existing_key) != hm.end() );
-		REQUIRE( hm[existing_key] == existing_value );
-		auto result = hm.insert( hm.begin(), std::make_pair(existing_key, overriding_value) );
-		REQUIRE( hm == hm_orig );
-		REQUIRE( result->first == existing_key );
-		REQUIRE( result->second == existing_value );
-		REQUIRE( hm[existing_key] == existing_value );
+	// packed maps have no buckets
+	template<typename Iterator>
+	void require_bucket_end(packed_hash_map<int, int> &, Iterator, int) {}
+
+	template<typename Map>
+	void check_insert() {
+		Map hm(5);
+		for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+			hm[i] = 2*i;
+		}
+		Map hm_orig(hm);
+
+		REQUIRE( hm.size() == 10 );
+		const int existing_key = 5;
+		const int existing_value = hm[existing_key];
+		const int overriding_value = existing_value+2;
+		REQUIRE( existing_value != overriding_value ); // need to be distinguishable
+
+		{ // element exists already, noop!
+			REQUIRE( hm.find(existing_key) != hm.end() );
+			REQUIRE( hm[existing_key] == existing_value );
+			auto result = hm.insert( std::make_pair(existing_key, overriding_value) );
+			REQUIRE( hm == hm_orig );
+			REQUIRE_FALSE( result.first );
+			REQUIRE( result.second->first == existing_key );
+			REQUIRE( result.second->second == existing_value );
+			REQUIRE( hm[existing_key] == existing_value );
+		}
+
+		{ // element exists already, noop! (w/ hint iterator)
+			REQUIRE( hm.find(existing_key) != hm.end() );
+			REQUIRE( hm[existing_key] == existing_value );
+			auto result = hm.insert( hm.begin(), std::make_pair(existing_key, overriding_value) );
+			REQUIRE( hm == hm_orig );
+			REQUIRE( result->first == existing_key );
+			REQUIRE( result->second == existing_value );
+			REQUIRE( hm[existing_key] == existing_value );
+		}
+
+		// element does not exist - insert
+		{ const int key = 50, value = 80;
+			REQUIRE( hm.find(key) == hm.end() );
+			auto result = hm.insert( std::make_pair(key, value) );
+			REQUIRE( hm != hm_orig );
+			REQUIRE( hm.size() == 11 );
+			REQUIRE( result.first );
+			REQUIRE( result.second->first == key );
+			REQUIRE( result.second->second == value );
+			REQUIRE( hm[key] == value );
+			// we insert at the end of a bucket, so the next iterator should be a bucket end
+			require_bucket_end(hm, result.second, key);
+		}
+
+		// element does not exist - insert (w/ hint iterator)
+		{ const int key = 51, value = 82;
+			REQUIRE( hm.find(key) == hm.end() );
+			auto result = hm.insert( hm.begin(), std::make_pair(key, value) );
+			REQUIRE( hm != hm_orig );
+			REQUIRE( hm.size() == 12 );
+			REQUIRE( result->first == key );
+			REQUIRE( result->second == value );
+			REQUIRE( hm[key] == value );
+			// we insert at the end of a bucket, so the next iterator should be a bucket end
+			require_bucket_end(hm, result, key);
+		}
 	}
 
-	// element does not exist - insert
-	{ const int key = 50, value = 80;
-		REQUIRE( hm.find(key) == hm.end() );
-		auto result = hm.insert( std::make_pair(key, value) );
-		REQUIRE( hm != hm_orig );
-		REQUIRE( hm.size() == 11 );
-		REQUIRE( result.first );
-		REQUIRE( result.second->first == key );
-		REQUIRE( result.second->second == value );
-		REQUIRE( hm[key] == value );
-		// we insert at the end of a bucket, so the next iterator should be a bucket end
-		REQUIRE( std::next(hash_map<int, int>::local_iterator(result.second)) == hm.end(hm.bucket(key)) );
+	template<typename Map>
+	void check_insert_or_assign() {
+		Map hm(5);
+		for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+			hm[i] = 2*i;
+		}
+		Map hm_orig(hm);
+
+		REQUIRE( hm.size() == 10 );
+		const int existing_key = 5;
+		const int existing_value = hm[existing_key];
+		const int overriding_value = existing_value+2;
+
+		{ // element exists already, assign
+			REQUIRE( hm.find(existing_key) != hm.end() );
+			REQUIRE( hm[existing_key] == existing_value );
+			auto result = hm.insert_or_assign(existing_key, overriding_value);
+			REQUIRE( hm != hm_orig );
+			REQUIRE( result->first == existing_key );
+			REQUIRE( result->second == overriding_value );
+			REQUIRE( hm[existing_key] == overriding_value );
+		}
+
+		// element does not exist - insert
+		{ const int key = 50, value = 80;
+			REQUIRE( hm.find(key) == hm.end() );
+			auto result = hm.insert_or_assign(key, value);
+			REQUIRE( hm != hm_orig );
+			REQUIRE( hm.size() == 11 );
+			REQUIRE( result->first == key );
+			REQUIRE( result->second == value );
+			REQUIRE( hm[key] == value );
+			// we insert at the end of a bucket, so the next iterator should be a bucket end
+			require_bucket_end(hm, result, key);
+		}
 	}
 
-	// element does not exist - insert (w/ hint iterator)
-	{ const int key = 51, value = 82;
-		REQUIRE( hm.find(key) == hm.end() );
-		auto result = hm.insert( hm.begin(), std::make_pair(key, value) );
-		REQUIRE( hm != hm_orig );
-		REQUIRE( hm.size() == 12 );
-		REQUIRE( result->first == key );
-		REQUIRE( result->second == value );
-		REQUIRE( hm[key] == value );
-		// we insert at the end of a bucket, so the next iterator should be a bucket end
-		REQUIRE( std::next(hash_map<int, int>::local_iterator(result)) == hm.end(hm.bucket(key)) );
+	template<typename Map>
+	void check_erase() {
+		Map hm(5);
+		for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+			hm[i] = 2*i;
+		}
+
+		// key based, existing element
+		{ const int key=5;
+			REQUIRE( hm.find(key) != hm.end() );
+			REQUIRE( hm.size() == 10 );
+
+			REQUIRE( hm.erase(key) == 1 );
+
+			REQUIRE( hm.find(key) == hm.end() );
+			REQUIRE( hm.size() == 9 );
+		}
+
+		// key based, non-existing element
+		{ const int key=42;
+			REQUIRE( hm.find(key) == hm.end() );
+			REQUIRE( hm.size() == 9 );
+
+			REQUIRE( hm.erase(key) == 0 );
+
+			REQUIRE( hm.find(key) == hm.end() );
+			REQUIRE( hm.size() == 9 );
+		}
+
+		// iterator based, existing element
+		{ const int key=hm.cbegin()->first;
+			auto next = std::next(hm.cbegin());
+			REQUIRE( hm.find(key) == hm.cbegin() );
+			REQUIRE( hm.find(key) != hm.end() );
+			REQUIRE( hm.size() == 9 );
+
+			REQUIRE( hm.erase(hm.cbegin()) == next );
+
+			REQUIRE( hm.find(key) == hm.end() );
+			REQUIRE( hm.size() == 8 );
+		}
+
+		// iterator based, non-existing element
+		// There are no iterators to non-existing elements!
 	}
 }
 
-TEST_CASE("hash_map/modifiers: insert_or_assign", "") {
-	hash_map<int, int> hm(5);
-	for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
-		hm[i] = 2*i;
+TEST_CASE("hash_map/modifiers: insert", "") {
+	SECTION("hash_map") {
+		check_insert<hash_map<int, int>>();
 	}
-	hash_map<int, int> hm_orig(hm);
-
-	REQUIRE( hm.size() == 10 );
-	const int existing_key = 5;
-	const int existing_value = hm[existing_key];
-	const int overriding_value = existing_value+2;
-
-	{ // element exists already, assign
-		REQUIRE( hm.find(existing_key) != hm.end() );
-		REQUIRE( hm[existing_key] == existing_value );
-		auto result = hm.insert_or_assign(existing_key, overriding_value);
-		REQUIRE( hm != hm_orig );
-		REQUIRE( result->first == existing_key );
-		REQUIRE( result->second == overriding_value );
-		REQUIRE( hm[existing_key] == overriding_value );
+	SECTION("packed_hash_map") {
+		check_insert<packed_hash_map<int, int>>();
 	}
+}
 
-	// element does not exist - insert
-	{ const int key = 50, value = 80;
-		REQUIRE( hm.find(key) == hm.end() );
-		auto result = hm.insert_or_assign(key, value);
-		REQUIRE( hm != hm_orig );
-		REQUIRE( hm.size() == 11 );
-		REQUIRE( result->first == key );
-		REQUIRE( result->second == value );
-		REQUIRE( hm[key] == value );
-		// we insert at the end of a bucket, so the next iterator should be a bucket end
-		REQUIRE( std::next(hash_map<int, int>::local_iterator(result)) == hm.end(hm.bucket(key)) );
+TEST_CASE("hash_map/modifiers: insert_or_assign", "") {
+	SECTION("hash_map") {
+		check_insert_or_assign<hash_map<int, int>>();
+	}
+	SECTION("packed_hash_map") {
+		check_insert_or_assign<packed_hash_map<int, int>>();
 	}
 }
 
 TEST_CASE("hash_map/modifiers: erase", "") {
-	hash_map<int, int> hm(5);
-	for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
-		hm[i] = 2*i;
+	SECTION("hash_map") {
+		check_erase<hash_map<int, int>>();
+	}
+	SECTION("packed_hash_map") {
+		check_erase<packed_hash_map<int, int>>();
 	}
+}
+
+TEST_CASE("hash_map/modifiers: inline first node", "") {
+	typedef hash_map<
+		int, tracked_mapped_type,
+		std::hash<int>, std::equal_to<int>,
+		std::allocator<std::pair<const int, tracked_mapped_type>>,
+		inline_first_node_traits
+	> map_type;
 
-	// key based, existing element
-	{ const int key=5;
-		REQUIRE( hm.find(key) != hm.end() );
+	const auto live = [] {
+		return tracked_mapped_type::created - tracked_mapped_type::destroyed;
+	};
+	const auto live_before = live();
+
+	{
+		map_type hm(5);
+		for(int i=0; i<20; ++i) {
+			hm[i];
+		}
+		REQUIRE( hm.size() == 20 );
+		REQUIRE( live() - live_before == 20 );
+
+		// frees the inline storage of some buckets and reuses it
+		for(int i=0; i<20; i+=2) {
+			REQUIRE( hm.erase(i) == 1 );
+		}
 		REQUIRE( hm.size() == 10 );
+		REQUIRE( live() - live_before == 10 );
+		for(int i=0; i<10; i+=2) {
+			hm[i];
+		}
+		REQUIRE( hm.size() == 15 );
+		REQUIRE( live() - live_before == 15 );
 
-		REQUIRE( hm.erase(key) == 1 );
+		const map_type hm_copy(hm);
+		REQUIRE( hm_copy.size() == 15 );
 
-		REQUIRE( hm.find(key) == hm.end() );
-		REQUIRE( hm.size() == 9 );
+		hm.rehash(13);
+		REQUIRE( hm.size() == 15 );
+		REQUIRE( live() - live_before == 30 );
+		for(int i=0; i<20; ++i) {
+			const bool exists = i < 10 || i % 2;
+			REQUIRE( (hm.find(i) != hm.end()) == exists );
+			REQUIRE( (hm_copy.find(i) != hm_copy.end()) == exists );
+		}
+
+		hm.clear();
+		REQUIRE( hm.empty() );
+		REQUIRE( live() - live_before == 15 );
 	}
 
-	// key based, non-existing element
-	{ const int key=42;
-		REQUIRE( hm.find(key) == hm.end() );
-		REQUIRE( hm.size() == 9 );
+	REQUIRE( live() == live_before );
+}
+
+TEST_CASE("hash_map/modifiers: out of line values", "") {
+	typedef hash_map<
+		int, tracked_mapped_type,
+		std::hash<int>, std::equal_to<int>,
+		std::allocator<std::pair<const int, tracked_mapped_type>>,
+		out_of_line_values_traits
+	> map_type;
 
-		REQUIRE( hm.erase(key) == 0 );
+	const auto live = [] {
+		return tracked_mapped_type::created - tracked_mapped_type::destroyed;
+	};
+	const auto live_before = live();
 
-		REQUIRE( hm.find(key) == hm.end() );
-		REQUIRE( hm.size() == 9 );
-	}
+	{
+		map_type hm(5);
+		for(int i=0; i<20; ++i) {
+			hm[i];
+		}
+		REQUIRE( hm.size() == 20 );
+		REQUIRE( live() - live_before == 20 );
+
+		for(int i=0; i<20; i+=2) {
+			REQUIRE( hm.erase(i) == 1 );
+		}
+		REQUIRE( hm.size() == 10 );
+		REQUIRE( live() - live_before == 10 );
 
-	// iterator based, existing element
-	{ const int key=hm.cbegin()->first;
-		auto next = std::next(hm.cbegin());
-		REQUIRE( hm.find(key) == hm.cbegin() );
-		REQUIRE( hm.find(key) != hm.end() );
-		REQUIRE( hm.size() == 9 );
+		const map_type hm_copy(hm);
+		REQUIRE( hm_copy.size() == 10 );
+		REQUIRE( live() - live_before == 20 );
 
-		REQUIRE( hm.erase(hm.cbegin()) == next );
+		hm.rehash(13);
+		REQUIRE( hm.size() == 10 );
+		REQUIRE( live() - live_before == 20 );
+		for(int i=0; i<20; ++i) {
+			REQUIRE( (hm.find(i) != hm.end()) == (i % 2 == 1) );
+			REQUIRE( (hm_copy.find(i) != hm_copy.end()) == (i % 2 == 1) );
+		}
 
-		REQUIRE( hm.find(key) == hm.end() );
-		REQUIRE( hm.size() == 8 );
+		hm.clear();
+		REQUIRE( hm.empty() );
+		REQUIRE( live() - live_before == 10 );
 	}
 
-	// iterator based, non-existing element
-	// There are no iterators to non-existing elements!
+	REQUIRE( live() == live_before );
+}
+
+TEST_CASE("hash_map/modifiers: incremental clear", "") {
+	check_incremental_clear<incremental_clear_traits>();
+	check_incremental_clear<lazy_incremental_clear_traits>();
+
+	// a lookup in progress keeps the cleared elements alive
+	const auto live = [] {
+		return tracked_mapped_type::created - tracked_mapped_type::destroyed;
+	};
+	const auto live_before = live();
+	{
+		hash_map<
+			int, tracked_mapped_type,
+			std::hash<int>, gated_equal,
+			std::allocator<std::pair<const int, tracked_mapped_type>>,
+			incremental_clear_traits
+		> hm(16);
+		for(int i=0; i<10; ++i) {
+			hm[i];
+		}
+
+		// the reader stops in the middle of at(), holding the bucket list
+		gated_equal::armed = true;
+		std::thread reader([&hm] {
+			const tracked_mapped_type &value = hm.at(gated_equal::gated_key);
+			((void)value);
+		});
+		while(!gated_equal::entered) {
+			std::this_thread::yield();
+		}
+
+		hm.clear();
+		for(int i=100; i<200; ++i) {
+			hm[i];
+			hm.erase(i);
+		}
+		REQUIRE( live() - live_before == 10 );
+
+		// once it is done, the next modifications destroy the elements
+		gated_equal::released = true;
+		reader.join();
+		hm[100];
+		hm.erase(100);
+		REQUIRE( live() == live_before );
+	}
+	REQUIRE( live() == live_before );
 }
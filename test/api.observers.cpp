@@ -1,17 +1,30 @@
 #include "../include/hash_map.hpp"
+#include "../include/packed_hash_map.hpp"
 #include "test_helper.hpp"
 
 #define CATCH_CONFIG_MAIN
 #include "../3rdparty/catch.hpp"
 
-TEST_CASE("hash_map/observers", "") {
-	comparable_map::hasher hash;
-	comparable_map::key_equal key_eq;
-	comparable_map::allocator_type alloc;
+namespace {
+	template<typename Map>
+	void check_observers() {
+		typename Map::hasher hash;
+		typename Map::key_equal key_eq;
+		typename Map::allocator_type alloc;
+
+		Map hm(5, hash, key_eq, alloc);
 
-	comparable_map hm(5, hash, key_eq, alloc);
+		REQUIRE( hm.hash_function() == hash );
+		REQUIRE( hm.key_eq() == key_eq );
+		REQUIRE( hm.get_allocator() == alloc );
+	}
+}
 
-	REQUIRE( hm.hash_function() == hash );
-	REQUIRE( hm.key_eq() == key_eq );
-	REQUIRE( hm.get_allocator() == alloc );
+TEST_CASE("hash_map/observers", "") {
+	SECTION("hash_map") {
+		check_observers<comparable_map>();
+	}
+	SECTION("packed_hash_map") {
+		check_observers<comparable_packed_map>();
+	}
 }
@@ -1,3 +1,8 @@
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+
 #include "../include/hash_map.hpp"
 #include "test_helper.hpp"
 
@@ -51,3 +56,54 @@ TEST_CASE("hash_map/rehash", "") {
 	REQUIRE( hm_copy.size()         == hm_orig.size() );
 	REQUIRE( hm_copy                == hm_orig );
 }
+
+namespace {
+	struct offline_reorder_traits: hash_map_traits {
+		static constexpr bool offline_reorder = true;
+		static constexpr unsigned hit_sample_shift = 0; // count every hit
+	};
+
+	typedef hash_map<
+		int, int,
+		std::hash<int>,
+		std::equal_to<int>,
+		std::allocator<std::pair<const int, int>>,
+		offline_reorder_traits
+	> offline_reorder_map;
+}
+
+TEST_CASE("hash_map/rehash: reorganize", "") {
+	offline_reorder_map hm(1);
+	for(const auto i : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+		hm[i] = 2*i;
+	}
+	const offline_reorder_map hm_orig(hm);
+	const auto it_five = std::next(hm.begin(), 4); // finding would be a hit
+	REQUIRE( it_five->first == 5 );
+
+	hm.find(10);
+	hm.find(10);
+	hm.find(7);
+	hm.reorganize();
+
+	REQUIRE( hm == hm_orig );
+	REQUIRE( it_five->first == 5 ); // iterators are still valid
+	REQUIRE( it_five->second == 10 );
+	{ // hits first, everything else in the previous order
+		auto it = hm.cbegin();
+		for(const auto i : {10, 7, 1, 2, 3, 4, 5, 6, 8, 9}) {
+			REQUIRE( it != hm.cend() );
+			REQUIRE( it->first == i );
+			++it;
+		}
+		REQUIRE( it == hm.cend() );
+	}
+
+	hm.find(1);
+	hm.find(1);
+	hm.rehash(2); // reorganizes as well
+
+	REQUIRE( hm == hm_orig );
+	REQUIRE( hm.cbegin(hm.bucket(1))->first == 1 );
+	REQUIRE( hm.cbegin(hm.bucket(10))->first == 10 );
+}
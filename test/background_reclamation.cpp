@@ -0,0 +1,109 @@
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "../include/hash_map.hpp"
+#include "../include/background_reclamation.hpp"
+#include "test_helper.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+namespace {
+	struct background_traits: hash_map_traits {
+		typedef background_reclamation reclamation_policy;
+	};
+
+	typedef hash_map<
+		int, tracked_mapped_type,
+		std::hash<int>, std::equal_to<int>,
+		std::allocator<std::pair<const int, tracked_mapped_type>>,
+		background_traits
+	> map_type;
+
+	unsigned live() {
+		return tracked_mapped_type::created - tracked_mapped_type::destroyed;
+	}
+
+	// waits for the background thread to catch up
+	bool wait_for_backlog(std::size_t objects) {
+		const auto deadline
+			= std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while(background_reclamation::backlog().objects != objects) {
+			if (std::chrono::steady_clock::now() > deadline) {
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+}
+
+TEST_CASE("background_reclamation: clear and destroy", "") {
+	const auto live_before = live();
+	{
+		map_type hm(16);
+		for(int i=0; i<100; ++i) {
+			hm[i];
+		}
+
+		hm.clear();
+		REQUIRE( hm.empty() );
+		// the elements are destroyed by the background thread
+		REQUIRE( wait_for_backlog(0) );
+		REQUIRE( live() == live_before );
+
+		for(int i=0; i<100; ++i) {
+			hm[i];
+		}
+		REQUIRE( live() - live_before == 100 );
+	}
+	REQUIRE( wait_for_backlog(0) );
+	REQUIRE( live() == live_before );
+}
+
+TEST_CASE("background_reclamation: rehash", "") {
+	const auto live_before = live();
+	{
+		map_type hm(16);
+		for(int i=0; i<100; ++i) {
+			hm[i];
+		}
+
+		// the replaced bucket list is not leaked
+		hm.rehash(64);
+		hm.rehash(256);
+		REQUIRE( hm.bucket_count() == 256 );
+		REQUIRE( hm.size() == 100 );
+		REQUIRE( wait_for_backlog(0) );
+		REQUIRE( live() - live_before == 100 );
+	}
+	REQUIRE( wait_for_backlog(0) );
+	REQUIRE( live() == live_before );
+}
+
+TEST_CASE("background_reclamation: backlog and reclaim", "") {
+	// objects still in use are kept
+	std::shared_ptr<int> used = std::make_shared<int>(1);
+	background_reclamation::retire(used, 100);
+	auto backlog = background_reclamation::backlog();
+	REQUIRE( backlog.objects == 1 );
+	REQUIRE( backlog.bytes == 100 );
+	REQUIRE( background_reclamation::reclaim() == 0 );
+
+	std::weak_ptr<int> weak(used);
+	used.reset();
+	REQUIRE( wait_for_backlog(0) );
+	REQUIRE( weak.expired() );
+	REQUIRE( background_reclamation::backlog().bytes == 0 );
+
+	// reclaim() does not wait for the grace period
+	used = std::make_shared<int>(2);
+	weak = used;
+	background_reclamation::retire(std::move(used), 20);
+	background_reclamation::reclaim();
+	REQUIRE( weak.expired() );
+	REQUIRE( background_reclamation::backlog().objects == 0 );
+}
@@ -0,0 +1,231 @@
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/direct_hash_map.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+namespace {
+	// a value which can be read while it is assigned to
+	struct shared_value {
+		shared_value(int value = 0)
+		: value(value) {}
+
+		shared_value(const shared_value &other)
+		: value(other.value.load()) {}
+
+		shared_value &operator=(const shared_value &other) {
+			value = other.value.load();
+			return *this;
+		}
+
+		std::atomic<int> value;
+	};
+}
+
+TEST_CASE("direct_hash_map: modifiers", "") {
+	direct_hash_map<int, std::string> hm(64);
+	REQUIRE( hm.empty() );
+	REQUIRE( hm.bucket_count() == 64 );
+
+	for(int i=0; i<40; ++i) {
+		const auto result = hm.insert(std::make_pair(i, std::to_string(i)));
+		REQUIRE( result.first );
+		REQUIRE( result.second->first == i );
+		REQUIRE( result.second->second == std::to_string(i) );
+		REQUIRE( hm.bucket(i) == std::size_t(i) );
+	}
+	REQUIRE( hm.size() == 40 );
+
+	// existing keys block insertions
+	const auto blocked = hm.insert(std::make_pair(7, std::string("x")));
+	REQUIRE_FALSE( blocked.first );
+	REQUIRE( blocked.second->second == "7" );
+
+	REQUIRE( hm.insert_or_assign(7, "seven")->second == "seven" );
+	REQUIRE( hm.insert_or_assign(63, "last")->second == "last" );
+	REQUIRE( hm.size() == 41 );
+
+	for(int i=0; i<40; i+=2) {
+		REQUIRE( hm.erase(i) == 1 );
+		REQUIRE( hm.erase(i) == 0 );
+	}
+	REQUIRE( hm.size() == 21 );
+	for(int i=0; i<40; ++i) {
+		REQUIRE( hm.count(i) == std::size_t(i % 2) );
+	}
+
+	// elements can be modified in place
+	hm[9] += "!";
+	hm.at(11) = "eleven";
+	hm.find(13)->second = "thirteen";
+	REQUIRE( hm.at(9) == "9!" );
+	REQUIRE( hm.at(11) == "eleven" );
+	REQUIRE( hm.at(13) == "thirteen" );
+	REQUIRE( hm[8].empty() );
+	REQUIRE( hm.size() == 22 );
+
+	const auto next = hm.erase(hm.find(8));
+	REQUIRE( hm.find(8) == hm.end() );
+	REQUIRE( next->first == 9 );
+	REQUIRE( hm.size() == 21 );
+
+	hm.clear();
+	REQUIRE( hm.empty() );
+	REQUIRE( hm.begin() == hm.end() );
+	REQUIRE( hm.find(9) == hm.end() );
+	REQUIRE( hm.bucket_count() == 64 );
+}
+
+TEST_CASE("direct_hash_map: keys out of range", "") {
+	direct_hash_map<int, int> hm(10);
+	hm[9] = 9;
+
+	// can not be stored ...
+	REQUIRE_THROWS_AS( hm.insert(std::make_pair(10, 10)), std::out_of_range );
+	REQUIRE_THROWS_AS( hm.insert_or_assign(-1, 1), std::out_of_range );
+	REQUIRE_THROWS_AS( hm[100], std::out_of_range );
+
+	// ... and are never found
+	REQUIRE( hm.find(10) == hm.end() );
+	REQUIRE( hm.find(-1) == hm.end() );
+	REQUIRE( hm.count(19) == 0 );
+	REQUIRE( hm.erase(-9) == 0 );
+	REQUIRE_THROWS_AS( hm.at(10), std::out_of_range );
+	REQUIRE( hm.size() == 1 );
+
+	// until the range is extended
+	hm.rehash(20);
+	REQUIRE( hm.bucket_count() == 20 );
+	REQUIRE( hm.insert(std::make_pair(19, 19)).first );
+	REQUIRE( hm.at(9) == 9 );
+	REQUIRE( hm.size() == 2 );
+
+	direct_hash_map<std::uint8_t, int> small(256);
+	for(int i=0; i<256; ++i) {
+		small[std::uint8_t(i)] = i;
+	}
+	REQUIRE( small.size() == 256 );
+	REQUIRE( small.at(255) == 255 );
+}
+
+TEST_CASE("direct_hash_map: iteration and copies", "") {
+	direct_hash_map<std::uint32_t, std::uint32_t> hm(1000);
+	for(std::uint32_t i=0; i<100; ++i) {
+		hm.insert_or_assign(i * 7, i);
+	}
+
+	// elements are visited in the order of their keys
+	std::uint32_t expected = 0;
+	for(auto it = hm.cbegin(); it != hm.cend(); ++it) {
+		REQUIRE( it->first == expected * 7 );
+		REQUIRE( (*it).second == expected );
+		++expected;
+	}
+	REQUIRE( expected == 100 );
+	REQUIRE( std::distance(hm.begin(), hm.end()) == 100 );
+
+	for(auto &element: hm) {
+		element.second += 1;
+	}
+
+	auto hm_copy(hm);
+	REQUIRE( hm_copy == hm );
+	hm_copy.insert_or_assign(0, 0);
+	REQUIRE( hm_copy != hm );
+	REQUIRE( hm.at(0) == 1 );
+
+	hm_copy = hm;
+	REQUIRE( hm_copy == hm );
+
+	hm.swap(hm_copy);
+	hm.clear();
+	REQUIRE( hm.empty() );
+	REQUIRE( hm_copy.size() == 100 );
+}
+
+TEST_CASE("direct_hash_map: concurrent updates", "") {
+	constexpr std::uint32_t num_threads = 4;
+	constexpr std::uint32_t keys_per_thread = 500;
+	constexpr std::uint32_t shared_keys = 16;
+
+	direct_hash_map<std::uint32_t, std::uint32_t> hm(
+		shared_keys + num_threads * keys_per_thread
+	);
+	std::vector<std::thread> threads;
+	for(std::uint32_t t=0; t<num_threads; ++t) {
+		threads.emplace_back([&hm, t] {
+			for(std::uint32_t i=0; i<keys_per_thread; ++i) {
+				const std::uint32_t key = shared_keys + t * keys_per_thread + i;
+				hm.insert(std::make_pair(key, t));
+				hm.insert_or_assign(i % shared_keys, t);
+				hm.insert(std::make_pair(i % shared_keys, t));
+				hm.erase((i + 1) % shared_keys);
+				hm.find(i % shared_keys);
+				if (i % 2) {
+					hm.erase(key);
+				}
+			}
+		});
+	}
+	for(auto &thread: threads) {
+		thread.join();
+	}
+
+	std::set<std::uint32_t> seen;
+	for(const auto &element: hm) {
+		REQUIRE( seen.insert(element.first).second );
+		REQUIRE( element.second < num_threads );
+	}
+	REQUIRE( seen.size() == hm.size() );
+	for(std::uint32_t t=0; t<num_threads; ++t) {
+		for(std::uint32_t i=0; i<keys_per_thread; ++i) {
+			const std::uint32_t key = shared_keys + t * keys_per_thread + i;
+			REQUIRE( hm.count(key) == 1 - i % 2 );
+		}
+	}
+}
+
+TEST_CASE("direct_hash_map: concurrent reads and assignments", "") {
+	constexpr int num_writes = 20000;
+
+	direct_hash_map<int, shared_value> hm(4);
+	hm.insert_or_assign(1, 0);
+
+	// assignments keep the element, so references taken by readers stay
+	// valid and only ever see values written
+	std::atomic<bool> done(false);
+	std::atomic<int> bad_reads(0);
+	std::thread reader([&] {
+		const shared_value &value = hm.at(1);
+		while(!done) {
+			const int seen = hm.at(1).value;
+			if (seen < 0 || seen >= num_writes || value.value < 0) {
+				++bad_reads;
+			}
+			const int through_operator = hm[1].value;
+			if (through_operator < 0 || through_operator >= num_writes) {
+				++bad_reads;
+			}
+		}
+	});
+	const shared_value *const element = &hm.at(1);
+	for(int i=0; i<num_writes; ++i) {
+		hm.insert_or_assign(1, i);
+	}
+	done = true;
+	reader.join();
+
+	REQUIRE( bad_reads == 0 );
+	REQUIRE( &hm.at(1) == element );
+	REQUIRE( hm.at(1).value == num_writes - 1 );
+	REQUIRE( hm.size() == 1 );
+}
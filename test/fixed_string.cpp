@@ -0,0 +1,82 @@
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "../include/hash_map.hpp"
+#include "../include/fixed_string.hpp"
+#include "test_helper.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+TEST_CASE("fixed_string: construction", "") {
+	REQUIRE( sizeof(fixed_string<14>) == 16 );
+	REQUIRE( sizeof(fixed_string<30>) == 32 );
+	REQUIRE( sizeof(fixed_string<31>) == 48 );
+	REQUIRE( fixed_string<30>::max_size() == 30 );
+
+	const fixed_string<30> empty;
+	REQUIRE( empty.empty() );
+	REQUIRE( empty.size() == 0 );
+	REQUIRE( std::string(empty.c_str()) == "" );
+
+	const fixed_string<30> foo("foo");
+	REQUIRE_FALSE( foo.empty() );
+	REQUIRE( foo.size() == 3 );
+	REQUIRE( foo.length() == 3 );
+	REQUIRE( std::string(foo.c_str()) == "foo" );
+	REQUIRE( foo.str() == "foo" );
+
+	// embedded null characters are kept
+	const fixed_string<30> nul(std::string("a\0b", 3));
+	REQUIRE( nul.size() == 3 );
+	REQUIRE( nul.str() == std::string("a\0b", 3) );
+
+	const std::string longest(30, 'x');
+	REQUIRE( fixed_string<30>(longest).str() == longest );
+	REQUIRE( fixed_string<30>(longest).c_str()[30] == '\0' );
+	REQUIRE_THROWS_AS( fixed_string<30>(longest + "x"), std::length_error );
+}
+
+TEST_CASE("fixed_string: comparison", "") {
+	const std::string chars(40, 'x');
+	for(std::size_t a=0; a<=40; ++a) {
+		for(std::size_t b=0; b<=40; ++b) {
+			const fixed_string<40> fa(chars.data(), a), fb(chars.data(), b);
+			REQUIRE( (fa == fb) == (a == b) );
+			REQUIRE( (fa != fb) == (a != b) );
+			REQUIRE( (fa < fb) == (a < b) );
+		}
+	}
+
+	// differences in every position are found
+	for(std::size_t i=0; i<40; ++i) {
+		std::string changed = chars;
+		changed[i] = 'y';
+		REQUIRE( fixed_string<40>(changed) != fixed_string<40>(chars) );
+		REQUIRE( fixed_string<40>(chars) < fixed_string<40>(changed) );
+	}
+
+	REQUIRE( fixed_string<8>("abc") < fixed_string<8>("abd") );
+	REQUIRE( fixed_string<8>("ab") < fixed_string<8>("abc") );
+	REQUIRE_FALSE( fixed_string<8>("b") < fixed_string<8>("abc") );
+}
+
+TEST_CASE("fixed_string: hash_map", "") {
+	const std::hash<fixed_string<30>> hash;
+	REQUIRE( hash("foo") == hash(fixed_string<30>(std::string("foo"))) );
+	REQUIRE( hash("foo") != hash("bar") );
+
+	hash_map<fixed_string<30>, int> hm(13);
+	for(int i=0; i<100; ++i) {
+		hm["key" + std::to_string(i)] = i;
+	}
+	REQUIRE( hm.size() == 100 );
+	for(int i=0; i<100; ++i) {
+		REQUIRE( hm.at("key" + std::to_string(i)) == i );
+	}
+	REQUIRE( hm.count("key100") == 0 );
+	REQUIRE( hm.erase("key42") == 1 );
+	REQUIRE( hm.count("key42") == 0 );
+}
@@ -0,0 +1,113 @@
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/frozen_hash_map.hpp"
+#include "test_helper.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+TEST_CASE("frozen_hash_map: freeze and thaw", "") {
+	hash_map<int, std::string> hm(7);
+	for(int i=0; i<50; ++i) {
+		hm[i] = std::to_string(i);
+	}
+	hm.erase(10);
+
+	const auto frozen = hm.freeze();
+	REQUIRE( frozen.size() == 49 );
+	REQUIRE( frozen.bucket_count() == 7 );
+	REQUIRE( frozen.at(42) == "42" );
+	REQUIRE( frozen.count(10) == 0 );
+	REQUIRE( frozen.find(50) == frozen.end() );
+	REQUIRE( frozen.find(hm.hash_key(3))->second == "3" );
+	REQUIRE_THROWS_AS( frozen.at(10), std::out_of_range );
+
+	// elements are sorted by bucket
+	std::size_t counted = 0;
+	for(std::size_t b=0; b<frozen.bucket_count(); ++b) {
+		REQUIRE( frozen.bucket_size(b) == hm.bucket_size(b) );
+		for(auto it=frozen.begin(b); it!=frozen.end(b); ++it) {
+			REQUIRE( frozen.bucket(it->first) == b );
+			++counted;
+		}
+	}
+	REQUIRE( counted == frozen.size() );
+
+	// the frozen map is a copy
+	hm[100] = "100";
+	hm.erase(42);
+	REQUIRE( frozen.count(100) == 0 );
+	REQUIRE( frozen.at(42) == "42" );
+
+	auto thawed = frozen.thaw();
+	REQUIRE( thawed.bucket_count() == 7 );
+	REQUIRE( thawed.size() == 49 );
+	thawed[100] = "100";
+	thawed.erase(42);
+	REQUIRE( thawed == hm );
+}
+
+TEST_CASE("frozen_hash_map: empty maps", "") {
+	const hash_map<int, int> hm(3);
+	const auto frozen = hm.freeze();
+	REQUIRE( frozen.empty() );
+	REQUIRE( frozen.begin() == frozen.end() );
+	REQUIRE( frozen.count(0) == 0 );
+	REQUIRE( frozen.thaw().empty() );
+}
+
+TEST_CASE("frozen_hash_map: concurrent lookups", "") {
+	hash_map<int, int> hm(1024);
+	for(int i=0; i<4096; ++i) {
+		hm.insert(std::make_pair(i, i * 3));
+	}
+	const frozen_hash_map<int, int> frozen(hm);
+
+	std::vector<std::thread> threads;
+	std::vector<int> mismatches(4, 0);
+	for(int t=0; t<4; ++t) {
+		threads.emplace_back([&, t] {
+			for(int i=0; i<4096; ++i) {
+				if (frozen.at(i) != i * 3) {
+					++mismatches[static_cast<std::size_t>(t)];
+				}
+			}
+		});
+	}
+	for(auto &thread: threads) {
+		thread.join();
+	}
+	for(int count: mismatches) {
+		REQUIRE( count == 0 );
+	}
+}
+
+namespace {
+	struct lazy_buckets_traits: hash_map_traits {
+		static constexpr bool lazy_buckets = true;
+	};
+}
+
+TEST_CASE("frozen_hash_map: lazy buckets", "") {
+	typedef hash_map<
+		int, int, std::hash<int>, std::equal_to<int>,
+		std::allocator<std::pair<const int, int>>,
+		lazy_buckets_traits
+	> map_type;
+
+	map_type hm(1 << 16);
+	hm[3] = 9;
+	hm[1 << 15] = 2;
+
+	const auto frozen = hm.freeze();
+	REQUIRE( frozen.size() == 2 );
+	REQUIRE( frozen.bucket_count() == 1 << 16 );
+	REQUIRE( frozen.at(3) == 9 );
+	REQUIRE( frozen.at(1 << 15) == 2 );
+	REQUIRE( frozen.bucket_size(4) == 0 );
+	REQUIRE( frozen.thaw() == hm );
+}
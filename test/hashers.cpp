@@ -0,0 +1,147 @@
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "../include/hashers.hpp"
+#include "test_helper.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+TEST_CASE("hashers: seeding", "") {
+	// explicitly seeded hashers are deterministic
+	REQUIRE( integer_hash(42)(23) == integer_hash(42)(23) );
+	REQUIRE( bytes_hash(42)(std::string("foo")) == bytes_hash(42)(std::string("foo")) );
+	REQUIRE( crc32c_hash(42)(23) == crc32c_hash(42)(23) );
+	REQUIRE( integer_hash(42)(23) != integer_hash(43)(23) );
+	REQUIRE( bytes_hash(42)(std::string("foo")) != bytes_hash(43)(std::string("foo")) );
+
+	// default constructed hashers are seeded individually
+	integer_hash ih1, ih2;
+	REQUIRE( ih1 != ih2 );
+	REQUIRE( ih1(23) != ih2(23) );
+
+	// copies share the seed
+	const integer_hash ih3 = ih1;
+	REQUIRE( ih3 == ih1 );
+	REQUIRE( ih3(23) == ih1(23) );
+}
+
+TEST_CASE("hashers: integer_hash", "") {
+	const integer_hash hash(0);
+	std::set<std::size_t> hashes;
+	for(std::uint64_t i=0; i<64; ++i) {
+		hashes.insert(hash(std::uint64_t(1) << i));
+	}
+	REQUIRE( hashes.size() == 64 );
+
+	// all bits of the key influence the low bits of the hash
+	std::set<std::size_t> low_bits;
+	for(std::uint64_t i=0; i<1024; ++i) {
+		low_bits.insert(hash(i << 32) & 0xff);
+	}
+	REQUIRE( low_bits.size() > 200 );
+}
+
+TEST_CASE("hashers: bytes_hash", "") {
+	const bytes_hash hash(0);
+	const std::string data(200, 'x');
+
+	// every length passes through a different path of the algorithm
+	std::set<std::size_t> hashes;
+	for(std::size_t length=0; length<=data.size(); ++length) {
+		hashes.insert(hash(data.data(), length));
+	}
+	REQUIRE( hashes.size() == data.size() + 1 );
+
+	// every byte influences the hash
+	for(const std::size_t length : {3u, 8u, 16u, 17u, 49u, 200u}) {
+		const std::size_t original = hash(data.data(), length);
+		for(std::size_t i=0; i<length; ++i) {
+			std::string changed = data.substr(0, length);
+			changed[i] = 'y';
+			REQUIRE( hash(changed) != original );
+		}
+	}
+}
+
+TEST_CASE("hashers: crc32c_hash", "") {
+	REQUIRE( crc32c_hash::checksum("", 0) == 0 );
+	REQUIRE( crc32c_hash::checksum("123456789", 9) == 0xe3069283 );
+	REQUIRE( crc32c_hash::checksum("56789", 5, crc32c_hash::checksum("1234", 4)) == 0xe3069283 );
+
+	const std::string data(100, 'x');
+	REQUIRE( crc32c_hash::checksum(data.data(), data.size()) == 0x4edb03cf );
+
+	// the crc32 instruction, if used, agrees with a bitwise calculation for
+	// every length and alignment of the tail
+	std::string bytes;
+	for(int n=0; n<40; ++n) {
+		std::uint32_t expected = ~std::uint32_t(0);
+		for(const char c: bytes) {
+			expected ^= static_cast<unsigned char>(c);
+			for(int bit = 0; bit < 8; ++bit) {
+				expected = (expected >> 1) ^ (0x82f63b78 & (0 - (expected & 1)));
+			}
+		}
+		REQUIRE( crc32c_hash::checksum(bytes.data(), bytes.size()) == ~expected );
+		bytes.push_back(static_cast<char>(n * 37 + 11));
+	}
+
+	const crc32c_hash hash(0);
+	REQUIRE( hash(std::string("foo")) != hash(std::string("bar")) );
+	REQUIRE( hash(1) != hash(2) );
+}
+
+TEST_CASE("hashers: hash_map", "") {
+	hash_map<int, int, integer_hash> hm_int(13);
+	hash_map<std::string, int, bytes_hash> hm_bytes(13);
+	hash_map<std::string, int, crc32c_hash> hm_crc(13);
+
+	for(int i=0; i<100; ++i) {
+		hm_int[i] = i;
+		hm_bytes[std::to_string(i)] = i;
+		hm_crc[std::to_string(i)] = i;
+	}
+	for(int i=0; i<100; ++i) {
+		REQUIRE( hm_int.at(i) == i );
+		REQUIRE( hm_bytes.at(std::to_string(i)) == i );
+		REQUIRE( hm_crc.at(std::to_string(i)) == i );
+	}
+
+	// copies keep the hasher and thus find the same buckets
+	const hash_map<std::string, int, bytes_hash> copy(hm_bytes);
+	REQUIRE( copy.hash_function() == hm_bytes.hash_function() );
+	REQUIRE( copy.at("42") == 42 );
+}
+
+TEST_CASE("hashers: integer_hash::hash_batch", "") {
+	const integer_hash hash(42);
+
+	std::vector<std::uint64_t> keys64;
+	std::vector<int> keys32;
+	for(int i=0; i<100; ++i) {
+		keys64.push_back(std::uint64_t(i) * UINT64_C(0x123456789));
+		keys32.push_back(-i);
+	}
+
+	// all lengths, so both the vector kernels and the scalar rest are used
+	for(std::size_t count=0; count<=keys64.size(); ++count) {
+		std::vector<std::size_t> hashes(count + 1, 0);
+		hash.hash_batch(keys64.data(), count, hashes.data());
+		for(std::size_t i=0; i<count; ++i) {
+			REQUIRE( hashes[i] == hash(keys64[i]) );
+		}
+		REQUIRE( hashes[count] == 0 ); // nothing written behind the end
+
+		hash.hash_batch(keys32.data(), count, hashes.data());
+		for(std::size_t i=0; i<count; ++i) {
+			REQUIRE( hashes[i] == hash(keys32[i]) );
+		}
+	}
+}
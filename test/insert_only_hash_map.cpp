@@ -0,0 +1,115 @@
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/insert_only_hash_map.hpp"
+#include "test_helper.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+namespace {
+	typedef insert_only_hash_map<int, std::string> string_map;
+}
+
+TEST_CASE("insert_only_hash_map: modifiers and lookup", "") {
+	string_map hm(7);
+	REQUIRE( hm.empty() );
+	REQUIRE( hm.begin() == hm.end() );
+
+	for(int i=0; i<50; ++i) {
+		const auto result = hm.insert(std::make_pair(i, std::to_string(i)));
+		REQUIRE( result.first );
+		REQUIRE( result.second->first == i );
+	}
+	REQUIRE( hm.size() == 50 );
+
+	const auto rejected = hm.insert(std::make_pair(3, std::string("x")));
+	REQUIRE( !rejected.first );
+	REQUIRE( rejected.second->second == "3" );
+
+	REQUIRE( hm.insert_or_assign(3, "three")->second == "three" );
+	REQUIRE( hm.insert_or_assign(50, "50")->second == "50" );
+	REQUIRE( hm[51].empty() );
+	REQUIRE( hm.size() == 52 );
+
+	REQUIRE( hm.at(3) == "three" );
+	REQUIRE( hm.count(49) == 1 );
+	REQUIRE( hm.count(100) == 0 );
+	REQUIRE( hm.find(100) == hm.end() );
+	REQUIRE_THROWS_AS( hm.at(100), std::out_of_range );
+
+	std::size_t counted = 0;
+	for(string_map::const_iterator it=hm.cbegin(); it!=hm.cend(); ++it) {
+		REQUIRE( hm.bucket(it->first) < hm.bucket_count() );
+		++counted;
+	}
+	REQUIRE( counted == hm.size() );
+
+	std::size_t bucket_sizes = 0;
+	for(std::size_t b=0; b<hm.bucket_count(); ++b) {
+		bucket_sizes += hm.bucket_size(b);
+	}
+	REQUIRE( bucket_sizes == hm.size() );
+
+	string_map copy(hm);
+	REQUIRE( copy == hm );
+	copy[100] = "100";
+	REQUIRE( copy != hm );
+	copy = hm;
+	REQUIRE( copy == hm );
+
+	hm.clear();
+	REQUIRE( hm.empty() );
+	REQUIRE( hm.begin() == hm.end() );
+	REQUIRE( copy.size() == 52 );
+}
+
+TEST_CASE("insert_only_hash_map: stable references", "") {
+	string_map hm(2);
+	std::vector<const std::string*> values;
+	for(int i=0; i<100; ++i) {
+		values.push_back(&hm[i]);
+	}
+
+	hm.rehash(97);
+	REQUIRE( hm.bucket_count() == 97 );
+	REQUIRE( hm.size() == 100 );
+	for(int i=0; i<100; ++i) {
+		REQUIRE( &hm.at(i) == values[static_cast<std::size_t>(i)] );
+	}
+}
+
+TEST_CASE("insert_only_hash_map: concurrent insertions", "") {
+	constexpr int num_threads = 4;
+	constexpr int num_keys = 2000;
+
+	insert_only_hash_map<int, int> hm(64);
+	std::atomic<int> inserted(0);
+	std::vector<std::thread> threads;
+	for(int t=0; t<num_threads; ++t) {
+		threads.emplace_back([&, t] {
+			// all threads race for the same keys
+			for(int i=0; i<num_keys; ++i) {
+				if (hm.insert(std::make_pair(i, t)).first) {
+					++inserted;
+				}
+				if (hm.find(i) == hm.end()) {
+					++inserted; // fails the test below
+				}
+			}
+		});
+	}
+	for(auto &thread: threads) {
+		thread.join();
+	}
+
+	REQUIRE( inserted == num_keys );
+	REQUIRE( hm.size() == static_cast<std::size_t>(num_keys) );
+	for(int i=0; i<num_keys; ++i) {
+		REQUIRE( hm.count(i) == 1 );
+	}
+}
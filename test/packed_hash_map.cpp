@@ -0,0 +1,379 @@
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "../include/packed_hash_map.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+// The checks in this file only use the interface common to both engines, and
+// run on hash_map as well as on packed_hash_map.
+//
+// The api.* suites run their capacity, observers, lookup (at(), operator[],
+// count(), find()), modifiers (insert(), insert_or_assign(), erase()) and
+// assign_compare_swap cases on both engines as well. The other cases rely on
+// something the packed engine can not offer:
+//     - tracked or string elements from test_helper.hpp (create_destroy,
+//       modifiers), as elements must be trivial and keys integral,
+//     - local iterators, bucket_size() and equal_range() (bucket, iterators,
+//       lookup), as there are no buckets,
+//     - precomputed hashes and bulk operations (lookup),
+//     - rehash() into fewer buckets than the size and offline_reorder
+//       (rehash), and the traits of the node engine (create_destroy,
+//       modifiers).
+
+namespace {
+	typedef hash_map<std::uint32_t, std::uint32_t> node_map;
+	typedef packed_hash_map<std::uint32_t, std::uint32_t> packed_map;
+
+	template<typename Map>
+	void check_modifiers() {
+		Map hm(64);
+		REQUIRE( hm.empty() );
+
+		for(std::uint32_t i=0; i<40; ++i) {
+			const auto result = hm.insert(std::make_pair(i, i * 10));
+			REQUIRE( result.first );
+			REQUIRE( result.second->first == i );
+			REQUIRE( result.second->second == i * 10 );
+		}
+		REQUIRE( hm.size() == 40 );
+
+		// existing keys block insertions
+		const auto blocked = hm.insert(std::make_pair(7u, 0u));
+		REQUIRE_FALSE( blocked.first );
+		REQUIRE( blocked.second->second == 70 );
+
+		REQUIRE( hm.insert_or_assign(7, 1)->second == 1 );
+		REQUIRE( hm.insert_or_assign(100, 2)->second == 2 );
+		REQUIRE( hm.size() == 41 );
+
+		for(std::uint32_t i=0; i<40; i+=2) {
+			REQUIRE( hm.erase(i) == 1 );
+			REQUIRE( hm.erase(i) == 0 );
+		}
+		REQUIRE( hm.size() == 21 );
+
+		for(std::uint32_t i=0; i<40; ++i) {
+			REQUIRE( hm.count(i) == i % 2 );
+		}
+		REQUIRE( hm.at(7) == 1 );
+		REQUIRE( hm.at(9) == 90 );
+		REQUIRE_THROWS_AS( hm.at(8), std::out_of_range );
+
+		// erased keys can be inserted again
+		REQUIRE( hm.insert(std::make_pair(8u, 8u)).first );
+		REQUIRE( hm.find(8)->second == 8 );
+		REQUIRE( hm.size() == 22 );
+
+		const auto next = hm.erase(hm.find(8));
+		REQUIRE( hm.find(8) == hm.end() );
+		REQUIRE( (next == hm.end() || next->first != 8) );
+		REQUIRE( hm.size() == 21 );
+
+		// values can be assigned through operator[], at() and iterators
+		hm[9] = 91;
+		hm.at(11) = 110;
+		hm.find(13)->second = 130;
+		REQUIRE( hm.at(9) == 91 );
+		REQUIRE( hm.at(11) == 110 );
+		REQUIRE( hm.find(13)->second == 130 );
+		REQUIRE( hm[50] == 0 );
+		REQUIRE( hm.size() == 22 );
+
+		hm.clear();
+		REQUIRE( hm.empty() );
+		REQUIRE( hm.begin() == hm.end() );
+		REQUIRE( hm.find(9) == hm.end() );
+	}
+
+	template<typename Map>
+	void check_iteration_and_copies() {
+		Map hm(128);
+		for(std::uint32_t i=0; i<100; ++i) {
+			hm.insert_or_assign(i * 7, i);
+		}
+
+		std::set<std::uint32_t> seen;
+		for(auto it = hm.cbegin(); it != hm.cend(); ++it) {
+			REQUIRE( it->first == (*it).second * 7 );
+			REQUIRE( seen.insert(it->first).second );
+		}
+		REQUIRE( seen.size() == 100 );
+
+		Map hm_copy(hm);
+		REQUIRE( hm_copy == hm );
+		hm_copy.insert_or_assign(0, 1);
+		REQUIRE( hm_copy != hm );
+
+		hm.rehash(512);
+		REQUIRE( hm.bucket_count() >= 512 );
+		REQUIRE( hm.size() == 100 );
+		for(std::uint32_t i=0; i<100; ++i) {
+			REQUIRE( hm.find(i * 7)->second == i );
+		}
+
+		hm_copy = hm;
+		REQUIRE( hm_copy == hm );
+	}
+
+	template<typename Map>
+	void check_concurrent_updates() {
+		constexpr std::uint32_t num_threads = 4;
+		constexpr std::uint32_t keys_per_thread = 500;
+		constexpr std::uint32_t shared_keys = 16;
+
+		Map hm(4096);
+		std::vector<std::thread> threads;
+		for(std::uint32_t t=0; t<num_threads; ++t) {
+			threads.emplace_back([&hm, t] {
+				for(std::uint32_t i=0; i<keys_per_thread; ++i) {
+					const std::uint32_t key = shared_keys + t * keys_per_thread + i;
+					hm.insert(std::make_pair(key, t));
+					hm.insert_or_assign(i % shared_keys, t);
+					if (i % 2) {
+						hm.erase(key);
+					}
+				}
+			});
+		}
+		for(auto &thread: threads) {
+			thread.join();
+		}
+
+		REQUIRE( hm.size() == shared_keys + num_threads * keys_per_thread / 2 );
+		for(std::uint32_t key=0; key<shared_keys; ++key) {
+			REQUIRE( hm.find(key)->second < num_threads );
+		}
+		for(std::uint32_t t=0; t<num_threads; ++t) {
+			for(std::uint32_t i=0; i<keys_per_thread; ++i) {
+				const std::uint32_t key = shared_keys + t * keys_per_thread + i;
+				REQUIRE( hm.count(key) == 1 - i % 2 );
+			}
+		}
+	}
+}
+
+TEST_CASE("engines: modifiers", "") {
+	check_modifiers<node_map>();
+	check_modifiers<packed_map>();
+}
+
+TEST_CASE("engines: iteration and copies", "") {
+	check_iteration_and_copies<node_map>();
+	check_iteration_and_copies<packed_map>();
+}
+
+TEST_CASE("engines: concurrent updates", "") {
+	check_concurrent_updates<node_map>();
+	check_concurrent_updates<packed_map>();
+}
+
+TEST_CASE("packed_hash_map: capacity", "") {
+	packed_hash_map<std::uint16_t, std::uint16_t> hm(8);
+	REQUIRE( hm.bucket_count() == 8 );
+
+	// a full table gets an overflow table
+	for(std::uint16_t i=0; i<8; ++i) {
+		REQUIRE( hm.insert(std::make_pair(i, i)).first );
+	}
+	REQUIRE( hm.bucket_count() == 8 );
+	REQUIRE( hm.insert(std::make_pair(8, 8)).first );
+	REQUIRE( hm.bucket_count() == 8 + 16 );
+	REQUIRE( hm.insert_or_assign(3, 30)->second == 30 );
+	REQUIRE( hm.size() == 9 );
+
+	// erased slots never keep keys from being inserted
+	for(std::uint16_t i=100; i<200; ++i) {
+		REQUIRE( hm.insert(std::make_pair(i, i)).first );
+		REQUIRE( hm.erase(i) == 1 );
+		REQUIRE( hm.count(i) == 0 );
+	}
+	REQUIRE( hm.size() == 9 );
+	for(std::uint16_t i=0; i<9; ++i) {
+		REQUIRE( hm.at(i) == (i == 3 ? 30 : i) );
+	}
+
+	std::set<std::uint16_t> seen;
+	for(const auto &element : hm) {
+		REQUIRE( seen.insert(element.first).second );
+	}
+	REQUIRE( seen.size() == 9 );
+
+	// rehashing moves all elements into a single table again
+	hm.rehash(16);
+	REQUIRE( hm.bucket_count() == 16 );
+	REQUIRE( hm.size() == 9 );
+	REQUIRE( hm.at(3) == 30 );
+	REQUIRE( hm.at(8) == 8 );
+
+	// a map with as many insertions and erasures as slots is empty
+	packed_hash_map<std::uint32_t, std::uint32_t> m(64);
+	for(std::uint32_t i=0; i<1000; ++i) {
+		REQUIRE( m.insert(std::make_pair(i, i)).first );
+		REQUIRE( m.erase(i) == 1 );
+	}
+	REQUIRE( m.empty() );
+	REQUIRE( m.insert(std::make_pair(1000u, 1u)).first );
+	REQUIRE( m.find(1000)->second == 1 );
+}
+
+TEST_CASE("packed_hash_map: compaction", "") {
+	packed_hash_map<std::uint32_t, std::uint32_t> hm(64);
+	for(std::uint32_t i=0; i<10; ++i) {
+		hm.insert_or_assign(i, i);
+	}
+	auto it = hm.find(5);
+
+	// erased slots are freed before the map grows much
+	for(std::uint32_t i=100; i<100000; ++i) {
+		REQUIRE( hm.insert(std::make_pair(i, i)).first );
+		REQUIRE( hm.erase(i) == 1 );
+		REQUIRE( hm.bucket_count() <= 64 + 128 );
+	}
+	REQUIRE( hm.size() == 10 );
+	for(std::uint32_t i=0; i<10; ++i) {
+		REQUIRE( hm.at(i) == i );
+	}
+
+	// iterators keep the chain they were taken from
+	REQUIRE( it->first == 5 );
+	std::size_t remaining = 0;
+	for(; it != hm.end(); ++it) {
+		++remaining;
+	}
+	REQUIRE( 0 < remaining );
+}
+
+TEST_CASE("packed_hash_map: concurrent compaction", "") {
+	constexpr std::uint32_t num_threads = 4;
+	constexpr std::uint32_t num_keys = 20000;
+	constexpr std::uint32_t kept_keys = 8;
+
+	packed_hash_map<std::uint32_t, std::uint32_t> hm(32);
+	for(std::uint32_t i=0; i<kept_keys; ++i) {
+		hm.insert_or_assign(i, 0);
+	}
+
+	// every thread churns through keys of its own, and keeps assigning to
+	// the same few keys, which must survive every compaction
+	std::atomic<std::uint32_t> failures(0);
+	std::vector<std::thread> threads;
+	for(std::uint32_t t=0; t<num_threads; ++t) {
+		threads.emplace_back([&hm, &failures, t] {
+			for(std::uint32_t i=0; i<num_keys; ++i) {
+				const std::uint32_t key = kept_keys + t * num_keys + i;
+				if (!hm.insert(std::make_pair(key, t)).first) {
+					++failures;
+				}
+				hm.insert_or_assign(i % kept_keys, t);
+				if (hm.erase(key) != 1 || hm.count(i % kept_keys) != 1) {
+					++failures;
+				}
+			}
+		});
+	}
+	for(auto &thread: threads) {
+		thread.join();
+	}
+
+	REQUIRE( failures == 0 );
+	REQUIRE( hm.size() == kept_keys );
+	REQUIRE( hm.bucket_count() < num_threads * num_keys / 8 );
+	for(std::uint32_t i=0; i<kept_keys; ++i) {
+		REQUIRE( hm.at(i) < num_threads );
+	}
+}
+
+TEST_CASE("packed_hash_map: references", "") {
+	packed_hash_map<std::uint32_t, std::uint32_t> hm(16);
+	hm[1] = 10;
+
+	// references read the current value and assign to the element
+	auto ref = hm[1];
+	hm.insert_or_assign(1, 11);
+	REQUIRE( ref == 11 );
+	ref = 12;
+	REQUIRE( hm.at(1) == 12 );
+	hm[2] = ref;
+	REQUIRE( hm.at(2) == 12 );
+
+	// iterators hand out references as well
+	for(auto element: hm) {
+		element.second = element.first + 100;
+	}
+	REQUIRE( hm.at(1) == 101 );
+	REQUIRE( hm.at(2) == 102 );
+
+	// erased elements are not brought back; references to them keep the
+	// value last assigned through them
+	REQUIRE( hm.erase(1) == 1 );
+	REQUIRE( ref == 12 );
+	ref = 13;
+	REQUIRE( hm.count(1) == 0 );
+	REQUIRE( hm.size() == 1 );
+
+	REQUIRE_THROWS_AS( hm[std::numeric_limits<std::uint32_t>::max()], std::invalid_argument );
+}
+
+TEST_CASE("packed_hash_map: reserved keys", "") {
+	packed_hash_map<std::uint8_t, std::uint8_t> hm(8);
+	REQUIRE( hm.insert(std::make_pair(std::uint8_t(253), std::uint8_t(1))).first );
+
+	// the two largest keys mark slots, so they can not be stored ...
+	REQUIRE_THROWS_AS( hm.insert(std::make_pair(std::uint8_t(255), std::uint8_t(1))), std::invalid_argument );
+	REQUIRE_THROWS_AS( hm.insert(hm.begin(), std::make_pair(std::uint8_t(254), std::uint8_t(1))), std::invalid_argument );
+	REQUIRE_THROWS_AS( hm.insert_or_assign(255, 1), std::invalid_argument );
+	REQUIRE_THROWS_AS( hm.insert_or_assign(254, 1), std::invalid_argument );
+	REQUIRE( hm.size() == 1 );
+
+	// ... and are never found
+	REQUIRE( hm.find(255) == hm.end() );
+	REQUIRE( hm.count(254) == 0 );
+	REQUIRE( hm.erase(255) == 0 );
+	REQUIRE( hm.erase(254) == 0 );
+	REQUIRE_THROWS_AS( hm.at(254), std::out_of_range );
+	REQUIRE( hm.at(253) == 1 );
+	REQUIRE( hm.size() == 1 );
+}
+
+TEST_CASE("packed_hash_map: concurrent overflow", "") {
+	constexpr std::uint32_t num_threads = 4;
+	constexpr std::uint32_t num_keys = 2000;
+
+	// all threads insert the same keys into a map much too small for them
+	packed_hash_map<std::uint32_t, std::uint32_t> hm(16);
+	std::vector<std::thread> threads;
+	for(std::uint32_t t=0; t<num_threads; ++t) {
+		threads.emplace_back([&hm, t] {
+			for(std::uint32_t i=0; i<num_keys; ++i) {
+				hm.insert(std::make_pair(i, t));
+				if (i % 3 == 0) {
+					hm.erase(i);
+				}
+			}
+		});
+	}
+	for(auto &thread: threads) {
+		thread.join();
+	}
+
+	std::set<std::uint32_t> seen;
+	for(const auto &element : hm) {
+		REQUIRE( seen.insert(element.first).second ); // no duplicates
+		REQUIRE( element.second < num_threads );
+	}
+	REQUIRE( seen.size() == hm.size() );
+	for(std::uint32_t i=0; i<num_keys; ++i) {
+		if (i % 3) {
+			REQUIRE( hm.count(i) == 1 );
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "../include/perfect_hash_map.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+namespace {
+	enum class opcode { nop, load, store, jump, halt };
+
+	constexpr auto methods = make_perfect_hash_map<const char *, int>({
+		{"GET", 1}, {"HEAD", 2}, {"POST", 3}, {"PUT", 4},
+		{"DELETE", 5}, {"CONNECT", 6}, {"OPTIONS", 7}, {"TRACE", 8},
+	});
+
+	constexpr auto mnemonics = make_perfect_hash_map<opcode, char>({
+		{opcode::nop, 'n'}, {opcode::load, 'l'}, {opcode::store, 's'},
+		{opcode::jump, 'j'}, {opcode::halt, 'h'},
+	});
+
+	static_assert( methods.at("DELETE") == 5, "" );
+	static_assert( methods.count("PATCH") == 0, "" );
+	static_assert( methods.find("TRACE")->second == 8, "" );
+	static_assert( methods.size() == 8, "" );
+	static_assert( methods.bucket_count() == 16, "" );
+	static_assert( mnemonics.at(opcode::jump) == 'j', "" );
+}
+
+TEST_CASE("perfect_hash_map: lookup", "") {
+	REQUIRE( methods.at("GET") == 1 );
+	REQUIRE( methods.at(std::string("OPTIONS").c_str()) == 7 );
+	REQUIRE( methods.count("GET") == 1 );
+	REQUIRE( methods.count("GE") == 0 );
+	REQUIRE( methods.count("GETS") == 0 );
+	REQUIRE( methods.find("PATCH") == methods.end() );
+	REQUIRE_THROWS_AS( methods.at("PATCH"), std::out_of_range );
+
+	int sum = 0;
+	for(const auto &element: methods) {
+		REQUIRE( methods.find(element.first) == &element );
+		sum += element.second;
+	}
+	REQUIRE( sum == 36 );
+
+	REQUIRE( mnemonics.at(opcode::halt) == 'h' );
+}
+
+TEST_CASE("perfect_hash_map: runtime construction", "") {
+	constexpr std::size_t count = 1000;
+	static perfect_hash_entry<std::uint32_t, std::uint32_t> elements[count];
+	for(std::uint32_t i=0; i<count; ++i) {
+		elements[i] = {i * 7919u, i};
+	}
+
+	const perfect_hash_map<std::uint32_t, std::uint32_t, count> hm(elements);
+	REQUIRE( hm.bucket_count() == 2048 );
+	for(std::uint32_t i=0; i<count; ++i) {
+		REQUIRE( hm.at(i * 7919u) == i );
+		REQUIRE( hm.count(i * 7919u + 1) == 0 );
+	}
+
+	elements[count - 1].first = elements[0].first;
+	REQUIRE_THROWS_AS(
+		(perfect_hash_map<std::uint32_t, std::uint32_t, count>(elements)),
+		std::invalid_argument
+	);
+}
@@ -0,0 +1,88 @@
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "../include/pool_allocator.hpp"
+#include "test_helper.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+TEST_CASE("pool_allocator: allocate", "") {
+	pool_allocator<std::uint64_t> alloc;
+	const pool_allocator<char> other(alloc);
+	REQUIRE( alloc == other );
+	REQUIRE_FALSE( alloc != other );
+
+	// single objects are distinct blocks of the pool
+	std::set<std::uint64_t *> blocks;
+	for(int i=0; i<1000; ++i) {
+		std::uint64_t *p = alloc.allocate(1);
+		*p = std::uint64_t(i);
+		REQUIRE( blocks.insert(p).second );
+	}
+	for(auto p : blocks) {
+		REQUIRE( *p < 1000 );
+	}
+
+	// released blocks are reused
+	std::uint64_t *released = *blocks.begin();
+	alloc.deallocate(released, 1);
+	REQUIRE( alloc.allocate(1) == released );
+
+	for(auto p : blocks) {
+		alloc.deallocate(p, 1);
+	}
+
+	// arrays are not pooled
+	std::uint64_t *array = alloc.allocate(100);
+	for(std::uint64_t i=0; i<100; ++i) {
+		array[i] = i;
+	}
+	alloc.deallocate(array, 100);
+}
+
+TEST_CASE("pool_allocator: hash_map", "") {
+	typedef hash_map<
+		std::string, int,
+		std::hash<std::string>,
+		std::equal_to<std::string>,
+		pool_allocator<std::pair<const std::string, int>>
+	> map_type;
+
+	map_type hm(13);
+	std::vector<std::thread> threads;
+	for(int t=0; t<4; ++t) {
+		threads.emplace_back([&hm, t]() {
+			for(int i=0; i<1000; ++i) {
+				hm[std::to_string(t * 1000 + i)] = i;
+				if (i % 3 == 0) {
+					hm.erase(std::to_string(t * 1000 + i));
+				}
+			}
+		});
+	}
+	for(auto &thread : threads) {
+		thread.join();
+	}
+
+	REQUIRE( hm.size() == 4 * 666 );
+	for(int t=0; t<4; ++t) {
+		for(int i=0; i<1000; ++i) {
+			REQUIRE( hm.count(std::to_string(t * 1000 + i)) == (i % 3 ? 1U : 0U) );
+		}
+	}
+
+	const map_type copy(hm);
+	REQUIRE( copy.size() == hm.size() );
+	hm.rehash(101);
+	hm.clear();
+	REQUIRE( hm.size() == 0 );
+	REQUIRE( copy.at("1001") == 1 );
+}
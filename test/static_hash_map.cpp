@@ -0,0 +1,187 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/static_hash_map.hpp"
+#include "test_helper.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+namespace {
+	std::atomic<std::size_t> heap_allocations(0);
+}
+
+void *operator new(std::size_t size) {
+	++heap_allocations;
+	if (void *p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+namespace {
+	typedef static_hash_map<int, int, 13, 16> small_map;
+
+	struct inline_first_node_traits: hash_map_traits {
+		static constexpr bool inline_first_node = true;
+	};
+}
+
+TEST_CASE("static_hash_map: no allocations", "") {
+	const std::size_t before = heap_allocations;
+	std::size_t found = 0;
+	{
+		small_map hm;
+		for(int i=0; i<16; ++i) {
+			hm.insert(std::make_pair(i, i * i));
+		}
+		for(int i=0; i<32; ++i) {
+			found += hm.count(i);
+		}
+
+		// erased nodes are recycled
+		for(int round=0; round<10; ++round) {
+			for(int i=0; i<16; i+=2) {
+				hm.erase(i);
+			}
+			for(int i=0; i<16; i+=2) {
+				hm.insert_or_assign(i, round);
+			}
+		}
+
+		// the previous bucket list is recycled as well
+		for(int round=0; round<10; ++round) {
+			hm.clear();
+			hm[round] = round;
+		}
+	}
+	const std::size_t allocations = heap_allocations - before;
+
+	REQUIRE( found == 16 );
+	REQUIRE( allocations == 0 );
+}
+
+TEST_CASE("static_hash_map: interface", "") {
+	small_map hm;
+	REQUIRE( hm.bucket_count() == 13 );
+	REQUIRE( small_map::capacity == 16 );
+
+	for(int i=0; i<16; ++i) {
+		hm[i] = i * 2;
+	}
+	REQUIRE( hm.size() == 16 );
+	REQUIRE( hm.bucket(27) == 1 );
+
+	hm.rehash(100);
+	REQUIRE( hm.bucket_count() == 13 );
+	REQUIRE( hm.size() == 16 );
+
+	small_map hm_copy(hm);
+	REQUIRE( hm_copy == hm );
+
+	hm_copy.erase(3);
+	REQUIRE( hm_copy != hm );
+	hm_copy = hm;
+	REQUIRE( hm_copy == hm );
+
+	// elements beyond the capacity are allocated on the heap
+	for(int i=16; i<64; ++i) {
+		hm[i] = i * 2;
+	}
+	REQUIRE( hm.size() == 64 );
+	for(int i=0; i<64; ++i) {
+		REQUIRE( hm.at(i) == i * 2 );
+	}
+
+	hm.clear();
+	REQUIRE( hm.empty() );
+}
+
+TEST_CASE("static_hash_map: traits", "") {
+	static_hash_map<
+		int, tracked_mapped_type, 8, 8,
+		std::hash<int>, std::equal_to<int>,
+		inline_first_node_traits
+	> hm;
+
+	const auto live = [] {
+		return tracked_mapped_type::created - tracked_mapped_type::destroyed;
+	};
+	const auto live_before = live();
+
+	for(int i=0; i<20; ++i) {
+		hm[i];
+	}
+	REQUIRE( live() - live_before == 20 );
+	for(int i=0; i<20; i+=2) {
+		REQUIRE( hm.erase(i) == 1 );
+	}
+	REQUIRE( live() - live_before == 10 );
+	hm.clear();
+	REQUIRE( live() == live_before );
+}
+
+TEST_CASE("static_hash_map: concurrent arena", "") {
+	constexpr int num_threads = 4;
+	constexpr int rounds = 2000;
+	constexpr int blocks_per_round = 8;
+
+	alignas(std::max_align_t) static unsigned char storage[1 << 12];
+	static_arena arena(storage, sizeof(storage));
+
+	// every thread marks the blocks it holds, so a block handed out twice
+	// shows up as a mark of another thread. Catch is not thread safe, so
+	// failures are only counted in the threads.
+	std::atomic<int> conflicts(0);
+	std::vector<std::thread> threads;
+	for(int t=0; t<num_threads; ++t) {
+		threads.emplace_back([&arena, &conflicts, t] {
+			for(int round=0; round<rounds; ++round) {
+				const std::size_t bytes = (round % 2) ? 32 : 64;
+				void *blocks[blocks_per_round];
+				for(void *&block: blocks) {
+					block = arena.allocate(bytes, alignof(int));
+					if (block) {
+						*static_cast<int *>(block) = t;
+					}
+				}
+				std::this_thread::yield();
+				for(void *block: blocks) {
+					if (block) {
+						if (*static_cast<int *>(block) != t) {
+							++conflicts;
+						}
+						if (!arena.deallocate(block, bytes)) {
+							++conflicts;
+						}
+					}
+				}
+			}
+		});
+	}
+	for(auto &thread: threads) {
+		thread.join();
+	}
+	REQUIRE( conflicts == 0 );
+
+	// the freed blocks are reused instead of carving new ones
+	void *const block = arena.allocate(32, alignof(int));
+	REQUIRE( block != nullptr );
+	REQUIRE( arena.deallocate(block, 32) );
+
+	int elsewhere = 0;
+	REQUIRE_FALSE( arena.deallocate(&elsewhere, sizeof(elsewhere)) );
+}
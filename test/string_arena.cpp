@@ -0,0 +1,162 @@
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../include/hash_map.hpp"
+#include "../include/string_arena.hpp"
+#include "test_helper.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include "../3rdparty/catch.hpp"
+
+TEST_CASE("string_arena: store", "") {
+	string_arena arena(64);
+
+	const arena_string empty = arena.store(std::string());
+	REQUIRE( empty.empty() );
+	REQUIRE( empty == arena_string() );
+
+	const std::string text = "hello";
+	const arena_string hello = arena.store(text);
+	REQUIRE( hello.size() == 5 );
+	REQUIRE( hello.str() == "hello" );
+	REQUIRE( static_cast<const void *>(hello.data())
+		!= static_cast<const void *>(text.data()) ); // copied into the arena
+	REQUIRE( hello == arena.store(text) );
+	REQUIRE( hello != arena.store(string_ref("hell", 4)) );
+	REQUIRE( hello != arena.store(string_ref("hellO", 5)) );
+
+	// only arenas create non-empty arena strings
+	static_assert( !std::is_constructible<arena_string, std::string>::value,
+		"arena_string must not refer to arbitrary strings" );
+	static_assert( !std::is_constructible<arena_string, string_ref>::value,
+		"arena_string must not refer to arbitrary strings" );
+
+	// strings spanning several chunks, including oversized ones
+	std::vector<std::string> originals;
+	std::vector<arena_string> copies;
+	for(std::size_t i=0; i<200; ++i) {
+		originals.push_back(std::string(i % 40, char('a' + i % 26)));
+		copies.push_back(arena.store(originals.back()));
+	}
+	for(std::size_t i=0; i<originals.size(); ++i) {
+		REQUIRE( copies[i].str() == originals[i] );
+	}
+
+	// the string stored last can be given back
+	const arena_string last = arena.store(string_ref("abc", 3));
+	REQUIRE( arena.unstore(last) );
+	REQUIRE( static_cast<const void *>(arena.store(string_ref("xyz", 3)).data())
+		== static_cast<const void *>(last.data()) );
+	REQUIRE( !arena.unstore(hello) );
+
+	// as can a string with a chunk of its own
+	const arena_string oversized = arena.store(std::string(100, 'o'));
+	REQUIRE( arena.unstore(oversized) );
+	REQUIRE( !arena.unstore(copies[198]) ); // not the newest one
+}
+
+TEST_CASE("string_arena: concurrent store", "") {
+	string_arena arena(256);
+	constexpr int num_threads = 4;
+	constexpr int num_strings = 1000;
+
+	std::vector<std::vector<arena_string>> copies(num_threads);
+	std::vector<std::thread> threads;
+	for(int t=0; t<num_threads; ++t) {
+		threads.emplace_back([&, t]() {
+			for(int i=0; i<num_strings; ++i) {
+				copies[std::size_t(t)].push_back(arena.store(
+					std::to_string(t) + ":" + std::to_string(i)
+				));
+			}
+		});
+	}
+	for(auto &thread : threads) {
+		thread.join();
+	}
+
+	for(int t=0; t<num_threads; ++t) {
+		for(int i=0; i<num_strings; ++i) {
+			REQUIRE( copies[std::size_t(t)][std::size_t(i)].str()
+				== std::to_string(t) + ":" + std::to_string(i) );
+		}
+	}
+}
+
+TEST_CASE("string_arena: hash_map", "") {
+	string_arena arena;
+	hash_map<arena_string, int> hm(13);
+
+	for(int i=0; i<100; ++i) {
+		REQUIRE( hm.insert(std::make_pair(
+			arena.store("key" + std::to_string(i)), i
+		)).first );
+	}
+	REQUIRE( hm.size() == 100 );
+	REQUIRE( hm.at(arena.store(std::string("key42"))) == 42 );
+}
+
+TEST_CASE("string_arena: arena_hash_map", "") {
+	arena_hash_map<int> hm(13);
+
+	for(int i=0; i<100; ++i) {
+		REQUIRE( hm.insert("key" + std::to_string(i), i).first );
+	}
+	REQUIRE( hm.size() == 100 );
+
+	// look up by strings outside the arena, without storing them
+	for(int i=0; i<100; ++i) {
+		const std::string key = "key" + std::to_string(i);
+		REQUIRE( hm.at(key) == i );
+		REQUIRE( static_cast<const void *>(hm.find(key)->first.data())
+			!= static_cast<const void *>(key.data()) );
+	}
+	REQUIRE( hm.count(string_ref("key100", 6)) == 0 );
+	REQUIRE( hm.erase(string_ref("key42", 5)) == 1 );
+	REQUIRE( hm.count(string_ref("key42", 5)) == 0 );
+	REQUIRE_THROWS_AS( hm.at(std::string("key42")), std::out_of_range );
+
+	// rejected insertions do not take up space in the arena
+	arena_hash_map<int> keys(13, 64);
+	keys["a"] = 1;
+	REQUIRE( !keys.insert(std::string("a"), 2).first );
+	keys["b"] += 2;
+	REQUIRE( keys.at(std::string("a")) == 1 );
+	REQUIRE( keys.at(std::string("b")) == 2 );
+	REQUIRE( static_cast<const void *>(keys.find(std::string("b"))->first.data())
+		== static_cast<const void *>(keys.find(std::string("a"))->first.data() + 1) );
+	REQUIRE( keys.insert(std::string(100, 'x'), 1).first );
+	REQUIRE( !keys.insert(std::string(100, 'x'), 2).first );
+	REQUIRE( keys.at(std::string(100, 'x')) == 1 );
+}
+
+TEST_CASE("string_arena: concurrent arena_hash_map", "") {
+	arena_hash_map<int> hm(64, 256);
+	constexpr int num_threads = 4;
+	constexpr int num_keys = 500;
+
+	// all threads insert the same keys
+	std::vector<std::thread> threads;
+	for(int t=0; t<num_threads; ++t) {
+		threads.emplace_back([&hm, t]() {
+			for(int i=0; i<num_keys; ++i) {
+				hm.insert(std::to_string(i), t);
+			}
+		});
+	}
+	for(auto &thread : threads) {
+		thread.join();
+	}
+
+	REQUIRE( hm.size() == num_keys );
+	for(int i=0; i<num_keys; ++i) {
+		REQUIRE( hm.find(std::to_string(i))->first.str() == std::to_string(i) );
+	}
+}
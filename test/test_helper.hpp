@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <sstream>
@@ -34,6 +35,15 @@ typedef hash_map<
 	comparable<std::allocator<void*>>
 > comparable_map;
 
+#ifdef PACKED_HASH_MAP_HPP_INCLUDED
+typedef packed_hash_map<
+	int, int,
+	comparable<std::hash<int>>,
+	comparable<std::equal_to<int>>,
+	comparable<std::allocator<void*>>
+> comparable_packed_map;
+#endif
+
 
 
 template<typename T>
@@ -60,6 +70,19 @@ std::string dump_map(const T &hm) {
 
 	return retval;
 }
+#ifdef PACKED_HASH_MAP_HPP_INCLUDED
+// packed maps have no buckets to list elements by
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator, typename Traits>
+std::string dump_map(const packed_hash_map<Key, T, Hash, KeyEqual, Allocator, Traits> &hm) {
+	std::stringstream ss;
+	for(const auto &element: hm) {
+		ss << ", [" << element.first << ',' << element.second << ']';
+	}
+
+	return "[" + ss.str().substr(hm.empty() ? 0 : 1) + " ]";
+}
+#endif
+
 #undef INFO_MAP
 #define INFO_MAP(map) INFO( #map " = " << dump_map(map) )
 
@@ -82,8 +105,9 @@ struct tracked_mapped_type {
 		++destroyed;
 	}
 
-	static unsigned created;
-	static unsigned destroyed;
+	// elements may be destroyed by other threads
+	static std::atomic<unsigned> created;
+	static std::atomic<unsigned> destroyed;
 };
-unsigned tracked_mapped_type::created=0;
-unsigned tracked_mapped_type::destroyed=0;
+std::atomic<unsigned> tracked_mapped_type::created(0);
+std::atomic<unsigned> tracked_mapped_type::destroyed(0);